@@ -0,0 +1,2340 @@
+// Benchmarks and self-checks for the password manager in main.cpp.
+//
+//   make bench            (or: g++ -std=c++17 -O2 -o bench bench.cpp -pthread)
+//   bench [name] [n]
+//   make test             the timing-independent checks only ("bench check")
+//
+// Builds main.cpp into this program with PM_BENCH defined, which leaves out its
+// interactive main. Each benchmark prints key=value lines ending in PASS or FAIL;
+// the exit status is 1 if any of them failed. See runBenchmarks for the names.
+
+#define PM_BENCH
+#include "main.cpp"
+#include <new>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+// ---- Allocation counting ----
+
+// Every global operator new (plain, array, nothrow and over-aligned) is
+// replaced here, so benchmarks can show a path never allocates. The counter is
+// shared by all threads because several benchmarks time parallel work.
+atomic<unsigned long long> heapAllocations(0);
+
+// nullptr when out of memory. Over-aligned blocks round size up to a multiple
+// of the alignment, as aligned_alloc requires.
+void* countedAllocate(size_t size, size_t alignment) noexcept
+{
+    heapAllocations.fetch_add(1, memory_order_relaxed);
+    if (size == 0) size = 1;
+    if (alignment <= alignof(max_align_t)) return malloc(size);
+#ifdef _WIN32
+    return _aligned_malloc(size, alignment);
+#else
+    return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+}
+
+void countedRelease(void* p, size_t alignment) noexcept
+{
+#ifdef _WIN32
+    if (alignment > alignof(max_align_t))
+    {
+        _aligned_free(p);
+        return;
+    }
+#endif
+    (void)alignment;
+    free(p);
+}
+
+void* countedNew(size_t size, size_t alignment)
+{
+    if (void* p = countedAllocate(size, alignment))
+    {
+        return p;
+    }
+    throw bad_alloc();
+}
+
+void* operator new(size_t size) { return countedNew(size, 0); }
+void* operator new[](size_t size) { return countedNew(size, 0); }
+void* operator new(size_t size, align_val_t al) { return countedNew(size, static_cast<size_t>(al)); }
+void* operator new[](size_t size, align_val_t al) { return countedNew(size, static_cast<size_t>(al)); }
+void* operator new(size_t size, const nothrow_t&) noexcept { return countedAllocate(size, 0); }
+void* operator new[](size_t size, const nothrow_t&) noexcept { return countedAllocate(size, 0); }
+void* operator new(size_t size, align_val_t al, const nothrow_t&) noexcept { return countedAllocate(size, static_cast<size_t>(al)); }
+void* operator new[](size_t size, align_val_t al, const nothrow_t&) noexcept { return countedAllocate(size, static_cast<size_t>(al)); }
+
+void operator delete(void* p) noexcept { countedRelease(p, 0); }
+void operator delete[](void* p) noexcept { countedRelease(p, 0); }
+void operator delete(void* p, size_t) noexcept { countedRelease(p, 0); }
+void operator delete[](void* p, size_t) noexcept { countedRelease(p, 0); }
+void operator delete(void* p, const nothrow_t&) noexcept { countedRelease(p, 0); }
+void operator delete[](void* p, const nothrow_t&) noexcept { countedRelease(p, 0); }
+void operator delete(void* p, align_val_t al) noexcept { countedRelease(p, static_cast<size_t>(al)); }
+void operator delete[](void* p, align_val_t al) noexcept { countedRelease(p, static_cast<size_t>(al)); }
+void operator delete(void* p, size_t, align_val_t al) noexcept { countedRelease(p, static_cast<size_t>(al)); }
+void operator delete[](void* p, size_t, align_val_t al) noexcept { countedRelease(p, static_cast<size_t>(al)); }
+void operator delete(void* p, align_val_t al, const nothrow_t&) noexcept { countedRelease(p, static_cast<size_t>(al)); }
+void operator delete[](void* p, align_val_t al, const nothrow_t&) noexcept { countedRelease(p, static_cast<size_t>(al)); }
+
+// ---- Benchmarks ----
+
+// Inserts n account names in sorted order (the worst case for a plain BST)
+// and checks that the AVL height stays within the 1.44 * log2(n + 2) bound.
+bool benchSortedInsert(int n)
+{
+    RecordSlab records;
+    AccountBST tree(&records);
+    char name[32];
+    for (int i = 0; i < n; i++)
+    {
+        snprintf(name, sizeof(name), "account%08d", i);
+        records.allocate(name, "secret");
+    }
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < n; i++)
+    {
+        tree.insert(static_cast<uint32_t>(i));
+    }
+    double insertSeconds = secondsSince(start);
+
+    start = chrono::steady_clock::now();
+    int found = 0;
+    for (int i = 0; i < n; i++)
+    {
+        if (tree.search(records.at(i).accountName) == static_cast<uint32_t>(i)) found++;
+    }
+    double searchSeconds = secondsSince(start);
+
+    int height = tree.height();
+    double bound = 1.4405 * log2(n + 2.0);
+    bool ok = (found == n) && (height <= bound);
+
+    cout << "bst-sorted-insert n=" << n
+         << " insert_ms=" << insertSeconds * 1000
+         << " search_ms=" << searchSeconds * 1000
+         << " height=" << height
+         << " bound=" << bound
+         << (ok ? " PASS" : " FAIL") << "\n";
+
+    for (int i = 0; i < n; i++)
+    {
+        tree.remove(static_cast<uint32_t>(i));
+    }
+    return ok && tree.isEmpty();
+}
+
+// Writes n shuffled "account<TAB>password" rows to a temp file, bulk imports
+// them into an empty vault and reports records/second.
+bool benchBulkImport(int n)
+{
+    const char* path = "bench_import.tsv";
+    {
+        vector<int> order(n);
+        for (int i = 0; i < n; i++) order[i] = i;
+        shuffle(order.begin(), order.end(), mt19937(42));
+
+        ofstream out(path);
+        char row[64];
+        for (int i = 0; i < n; i++)
+        {
+            int len = snprintf(row, sizeof(row), "account%08d\tPass#%d\n", order[i], order[i] % 1000);
+            out.write(row, len);
+        }
+    }
+
+    PasswordManager manager;
+    int skipped = 0;
+    int reused = 0;
+    auto start = chrono::steady_clock::now();
+    int imported = manager.importFromFile(path, skipped, reused);
+    double seconds = secondsSince(start);
+    remove(path);
+
+    bool ok = imported == n && manager.vault.find("account00000000") != nullptr;
+    cout << "bulk-import n=" << n
+         << " seconds=" << seconds
+         << " records_per_sec=" << static_cast<long long>(imported / seconds)
+         << " height=" << manager.vault.bst.height()
+         << " reused=" << reused
+         << (ok ? " PASS" : " FAIL") << "\n";
+    return ok;
+}
+
+// The pre-VaultStore layout, kept only as a benchmark baseline: every record is a
+// heap node in a linked list, indexed by a balanced tree of heap nodes pointing at
+// them (std::set stands in for the old pointer-based AVL; the list keeps a tail
+// pointer so appends are not charged the old O(n) walk).
+struct LegacyNode
+{
+    string accountName;
+    string password;
+    LegacyNode* next;
+    LegacyNode* prev;   // Lets the churn benchmark unlink in O(1)
+};
+
+struct LegacyNameLess
+{
+    bool operator()(const LegacyNode* a, const LegacyNode* b) const
+    {
+        return a->accountName < b->accountName;
+    }
+};
+
+struct LegacyVault
+{
+    LegacyNode* head = nullptr;
+    LegacyNode* tail = nullptr;
+    set<LegacyNode*, LegacyNameLess> index;
+    LegacyNode probe;
+
+    void add(const string& name, const string& password)
+    {
+        LegacyNode* node = new LegacyNode{ name, password, nullptr, tail };
+        if (tail) tail->next = node; else head = node;
+        tail = node;
+        index.insert(node);
+    }
+
+    void erase(LegacyNode* node)
+    {
+        index.erase(node);
+        if (node->prev) node->prev->next = node->next; else head = node->next;
+        if (node->next) node->next->prev = node->prev; else tail = node->prev;
+        delete node;
+    }
+
+    void clear()
+    {
+        index.clear();
+        while (head)
+        {
+            LegacyNode* next = head->next;
+            delete head;
+            head = next;
+        }
+        tail = nullptr;
+    }
+
+    LegacyNode* find(const string& name)
+    {
+        probe.accountName = name;
+        auto it = index.find(&probe);
+        return it == index.end() ? nullptr : *it;
+    }
+
+    ~LegacyVault()
+    {
+        clear();
+    }
+};
+
+// Inserts n records in random order, looks up n random names and scans the vault
+// in sorted order, for the VaultStore and the legacy list + tree layout.
+bool benchLayout(int n)
+{
+    vector<int> order(n);
+    for (int i = 0; i < n; i++) order[i] = i;
+    shuffle(order.begin(), order.end(), mt19937(7));
+    vector<int> probes(order);
+    shuffle(probes.begin(), probes.end(), mt19937(11));
+
+    // Names are generated up front so only the stores are timed
+    vector<string> names(n);
+    char name[40];
+    for (int i = 0; i < n; i++)
+    {
+        snprintf(name, sizeof(name), "user%08d@example.com", i);
+        names[i] = name;
+    }
+
+    long long checksum[2] = { 0, 0 };
+    for (int layout = 0; layout < 2; layout++)
+    {
+        double insertSeconds, searchSeconds, scanSeconds;
+        if (layout == 0)
+        {
+            VaultStore store;
+            auto start = chrono::steady_clock::now();
+            for (int i : order) store.add(names[i], "ciphertext");
+            insertSeconds = secondsSince(start);
+
+            start = chrono::steady_clock::now();
+            for (int i : probes) checksum[layout] += store.find(names[i]) != nullptr;
+            searchSeconds = secondsSince(start);
+
+            start = chrono::steady_clock::now();
+            for (VaultIterator it = store.begin(); it.hasNext(); ) checksum[layout] += it.next()->password.size();
+            scanSeconds = secondsSince(start);
+        }
+        else
+        {
+            LegacyVault store;
+            auto start = chrono::steady_clock::now();
+            for (int i : order) store.add(names[i], "ciphertext");
+            insertSeconds = secondsSince(start);
+
+            start = chrono::steady_clock::now();
+            for (int i : probes) checksum[layout] += store.find(names[i]) != nullptr;
+            searchSeconds = secondsSince(start);
+
+            start = chrono::steady_clock::now();
+            for (LegacyNode* node : store.index) checksum[layout] += node->password.size();
+            scanSeconds = secondsSince(start);
+        }
+
+        cout << "layout=" << (layout == 0 ? "vaultstore" : "legacy")
+             << " n=" << n
+             << " insert_ns_per_op=" << insertSeconds * 1e9 / n
+             << " search_ns_per_op=" << searchSeconds * 1e9 / n
+             << " scan_ns_per_entry=" << scanSeconds * 1e9 / n << "\n";
+    }
+    return checksum[0] == checksum[1];
+}
+
+// Record encryption: AES, CMAC, AES-SIV and PBKDF2 known answers (FIPS-197,
+// RFC 4493, 5297 and 6070), the AES-NI kernel against the portable one, round
+// trips and tamper checks, then sealing and opening n password-sized records
+// on one thread and on one per core, against memcpy bandwidth. That ratio is
+// reported, not checked: every record of 8..24 bytes needs its own CTR block,
+// CMAC block and tag compare, so opening runs at a few percent of memcpy, well
+// short of memory bandwidth. PASS means the records opened correctly.
+bool benchCipher(int n)
+{
+    auto bytes = [](const char* hex)
+    {
+        vector<uint8_t> out(strlen(hex) / 2);
+        for (size_t i = 0; i < out.size(); i++) out[i] = static_cast<uint8_t>(hexValue(hex[2 * i]) << 4 | hexValue(hex[2 * i + 1]));
+        return out;
+    };
+    auto same = [&](const uint8_t* data, const char* hex)
+    {
+        return memcmp(data, bytes(hex).data(), strlen(hex) / 2) == 0;
+    };
+
+    // FIPS-197 C.1, RFC 4493 section 4 and RFC 5297 A.1
+    bool vectors = true;
+    AesRoundKeys rounds;
+    uint8_t block[AES_BLOCK];
+    aesExpandKey(bytes("000102030405060708090a0b0c0d0e0f").data(), rounds);
+    aesKernel(rounds, bytes("00112233445566778899aabbccddeeff").data(), block, 1);
+    vectors = vectors && same(block, "69c4e0d86a7b0430d8cdb78070b4c55a");
+
+    VaultKey key;
+    vector<uint8_t> material = bytes("2b7e151628aed2a6abf7158809cf4f3c000102030405060708090a0b0c0d0e0f");
+    key.set(material.data());
+    sivCmac(key, nullptr, 0, block);
+    vectors = vectors && same(block, "bb1d6929e95937287fa37d129b756746");
+    sivCmac(key, bytes("6bc1bee22e409f96e93d7e117393172a").data(), AES_BLOCK, block);
+    vectors = vectors && same(block, "070a16b46b4d4144f79bdd9dd04a287c");
+
+    material = bytes("fffefdfcfbfaf9f8f7f6f5f4f3f2f1f0f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff");
+    key.set(material.data());
+    vector<uint8_t> associatedBytes = bytes("101112131415161718191a1b1c1d1e1f2021222324252627");
+    string_view associated(reinterpret_cast<const char*>(associatedBytes.data()), associatedBytes.size());
+    vector<uint8_t> plain = bytes("112233445566778899aabbccddee");
+    uint8_t iv[AES_BLOCK];
+    uint8_t sealed[14];
+    sivS2V(key, &associated, plain.data(), plain.size(), iv);
+    sivCtr(key, iv, plain.data(), sealed, plain.size());
+    vectors = vectors && same(iv, "85632d07c6e8f37f950acd320a2ecc93") && same(sealed, "40c02b9690c4dc04daef7f6afe5c");
+
+    // RFC 6070
+    const pair<uint32_t, const char*> pbkdf2Vectors[] = {
+        { 1, "0c60c80f961f0e71f3a9b524af6012062fe037a6" },
+        { 2, "ea6c014dc72d6f8ccd1ed92ace1d41f0d8de8957" },
+        { 4096, "4b007901b765489abead49d926f721d065a429c1" },
+    };
+    for (auto& v : pbkdf2Vectors)
+    {
+        uint8_t derived[SHA1_BYTES];
+        pbkdf2Sha1("password", "salt", v.first, derived, sizeof(derived));
+        vectors = vectors && same(derived, v.second);
+    }
+    cout << "cipher known_answers=fips197,rfc4493,rfc5297,rfc6070" << (vectors ? " PASS" : " FAIL") << "\n";
+    bool ok = vectors;
+
+    // The dispatched kernel against the portable one, on random blocks
+    mt19937 rng(5);
+    deriveVaultKey("master", key);
+    {
+        const size_t blocks = 4099;
+        vector<uint8_t> in(blocks * AES_BLOCK), portable(in.size()), dispatched(in.size());
+        for (uint8_t& b : in) b = static_cast<uint8_t>(rng());
+        aesKernelPortable(key.ctrRounds, in.data(), portable.data(), blocks);
+        aesKernel(key.ctrRounds, in.data(), dispatched.data(), blocks);
+        bool pass = portable == dispatched;
+        ok = ok && pass;
+        cout << "cipher kernel=" << aesKernelName << " blocks=" << blocks << (pass ? " PASS" : " FAIL") << "\n";
+    }
+
+    // Every length up to 80 bytes: the lane path agrees with the general S2V,
+    // opens what it sealed, and rejects a record with any one bit flipped
+    {
+        bool pass = true;
+        for (size_t length = 0; length <= 80; length++)
+        {
+            string password(length, '\0');
+            for (char& c : password) c = static_cast<char>(rng());
+            string record = encryptPassword(key, password);
+            sivS2V(key, nullptr, reinterpret_cast<const uint8_t*>(password.data()), length, iv);
+            pass = pass && record.size() == length + SIV_BYTES && memcmp(record.data(), iv, SIV_BYTES) == 0
+                && decryptPassword(key, record) == password;
+            string opened;
+            for (size_t bit = 0; bit < 8 * record.size(); bit += 7)
+            {
+                string tampered = record;
+                tampered[bit / 8] ^= static_cast<char>(1 << bit % 8);
+                pass = pass && !decryptPassword(key, tampered, opened) && opened.empty();
+            }
+        }
+        VaultKey other;
+        pass = pass && decryptPassword(other, encryptPassword(key, "Secret#1")).empty()
+            && encryptPassword(key, "Secret#1") == encryptPassword(key, "Secret#1");
+        ok = ok && pass;
+        cout << "cipher round_trips=0..80 tampered_rejected" << (pass ? " PASS" : " FAIL") << "\n";
+    }
+
+    auto start = chrono::steady_clock::now();
+    deriveVaultKey("master", key);
+    cout << "cipher derive_ms=" << secondsSince(start) * 1000 << " iterations=" << VAULT_KEY_ITERATIONS << "\n";
+
+    // Password-sized records, 8..24 bytes
+    vector<string> passwords(n);
+    size_t plainBytes = 0;
+    for (string& p : passwords)
+    {
+        p.resize(8 + rng() % 17);
+        for (char& c : p) c = static_cast<char>(33 + rng() % 94);
+        plainBytes += p.size();
+    }
+    double memcpyGbPerSec;
+    {
+        string from(plainBytes + SIV_BYTES * static_cast<size_t>(n), 'x');
+        string to(from.size(), '\0');
+        start = chrono::steady_clock::now();
+        for (int r = 0; r < 4; r++)
+        {
+            from[r] = static_cast<char>(r);
+            memcpy(&to[0], from.data(), from.size());
+        }
+        memcpyGbPerSec = 4.0 * from.size() / secondsSince(start) / 1e9;
+        ok = ok && to[3] == 3;
+    }
+
+    vector<unsigned> threadCounts = { 1 };
+    unsigned cores = max(1u, thread::hardware_concurrency());
+    if (cores > 1) threadCounts.push_back(cores);
+    for (unsigned threads : threadCounts)
+    {
+        vector<string> records = passwords;
+        vector<string*> pointers(n);
+        for (int i = 0; i < n; i++) pointers[i] = &records[i];
+        start = chrono::steady_clock::now();
+        encryptPasswordsBatch(key, pointers.data(), n, threads);
+        double sealSeconds = secondsSince(start);
+
+        vector<string_view> views(records.begin(), records.end());
+        vector<string> opened(n);
+        for (int i = 0; i < n; i++) pointers[i] = &opened[i];
+        start = chrono::steady_clock::now();
+        size_t failed = decryptPasswordsBatch(key, views.data(), pointers.data(), n, threads);
+        double openSeconds = secondsSince(start);
+
+        bool pass = failed == 0 && opened == passwords;
+        ok = ok && pass;
+        double bytes = plainBytes + SIV_BYTES * static_cast<double>(n);
+        cout << "cipher n=" << n << " threads=" << threads
+             << " seal_records_per_sec=" << static_cast<long long>(n / max(sealSeconds, 1e-9))
+             << " seal_gb_per_sec=" << bytes / max(sealSeconds, 1e-9) / 1e9
+             << " open_records_per_sec=" << static_cast<long long>(n / max(openSeconds, 1e-9))
+             << " open_gb_per_sec=" << bytes / max(openSeconds, 1e-9) / 1e9
+             << " memcpy_gb_per_sec=" << memcpyGbPerSec
+             << " open_vs_memcpy=" << bytes / max(openSeconds, 1e-9) / 1e9 / memcpyGbPerSec
+             << (pass ? " PASS" : " FAIL") << "\n";
+    }
+
+    // A whole vault opened in one pass, as a full export would
+    {
+        VaultStore store;
+        store.key = key;
+        char name[32];
+        for (int i = 0; i < n; i++)
+        {
+            snprintf(name, sizeof(name), "account%08d", i);
+            store.add(name, encryptPassword(key, passwords[i]));
+        }
+        vector<string_view> views;
+        views.reserve(n);
+        for (VaultIterator it = store.begin(); it.hasNext(); ) views.push_back(it.next()->password);
+        vector<string> opened(views.size());
+        vector<string*> pointers(views.size());
+        for (size_t i = 0; i < views.size(); i++) pointers[i] = &opened[i];
+        start = chrono::steady_clock::now();
+        size_t failed = decryptPasswordsBatch(store.key, views.data(), pointers.data(), views.size());
+        double seconds = secondsSince(start);
+        bool pass = failed == 0 && views.size() == static_cast<size_t>(n);
+        ok = ok && pass;
+        cout << "cipher vault_open n=" << n << " ms=" << seconds * 1000 << (pass ? " PASS" : " FAIL") << "\n";
+    }
+    return ok;
+}
+
+// Peak resident set size of this process in KB (-1 where unsupported)
+long peakRssKB()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#else
+    return -1;
+#endif
+}
+
+// Add/delete churn: fill a vault with n records, then n times delete a random
+// account and add a new one, then log out (clear). Run "churn" (VaultStore with
+// its arena and slab) and "churn-legacy" (heap nodes) as separate processes so
+// each reports its own peak RSS.
+template <typename Store>
+void runChurn(Store& store, const vector<string>& names, const string& password, int n,
+              double& fillSeconds, double& churnSeconds, double& clearSeconds)
+{
+    mt19937 rng(5);
+
+    // live[k] is the name stored in position k; names n..2n-1 arrive during churn
+    vector<int> live(n);
+    for (int i = 0; i < n; i++) live[i] = i;
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < n; i++) store.add(names[i], password);
+    fillSeconds = secondsSince(start);
+
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < n; i++)
+    {
+        int k = static_cast<int>(rng() % n);
+        store.erase(store.find(names[live[k]]));
+        live[k] = n + i;
+        store.add(names[live[k]], password);
+    }
+    churnSeconds = secondsSince(start);
+
+    start = chrono::steady_clock::now();
+    store.clear();
+    clearSeconds = secondsSince(start);
+}
+
+bool benchChurn(int n, bool legacy)
+{
+    vector<string> names(2 * static_cast<size_t>(n));
+    char buffer[48];
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        snprintf(buffer, sizeof(buffer), "user%08zu@example.com", i);
+        names[i] = buffer;
+    }
+    const string password = "ciphertext-0123456789";  // Longer than the SSO buffer
+
+    double fillSeconds, churnSeconds, clearSeconds;
+    bool ok = true;
+    if (legacy)
+    {
+        LegacyVault store;
+        runChurn(store, names, password, n, fillSeconds, churnSeconds, clearSeconds);
+    }
+    else
+    {
+        VaultStore store;
+        runChurn(store, names, password, n, fillSeconds, churnSeconds, clearSeconds);
+        ok = store.size() == 0 && store.records.strings.bytesInUse == 0;
+    }
+
+    cout << "churn layout=" << (legacy ? "legacy" : "vaultstore")
+         << " n=" << n
+         << " fill_ns_per_add=" << fillSeconds * 1e9 / n
+         << " churn_ns_per_delete_add=" << churnSeconds * 1e9 / n
+         << " logout_ms=" << clearSeconds * 1000
+         << " peak_rss_kb=" << peakRssKB()
+         << (ok ? " PASS" : " FAIL") << "\n";
+    return ok;
+}
+
+// Looks up n names in an n-entry tree and counts heap allocations made by the
+// searches (must be zero), for random names and names sharing an 8+ byte prefix
+bool benchSearchAllocations(int n)
+{
+    bool ok = true;
+    const char* shapes[] = { "random", "shared-prefix" };
+    for (const char* shape : shapes)
+    {
+        vector<string> names(n);
+        mt19937_64 rng(9);
+        char name[48];
+        for (int i = 0; i < n; i++)
+        {
+            if (shape[0] == 'r') snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(rng()));
+            else snprintf(name, sizeof(name), "user%08d@example.com", i);
+            names[i] = name;
+        }
+
+        RecordSlab records;
+        AccountBST tree(&records);
+        for (int i = 0; i < n; i++) tree.insert(records.allocate(names[i], "secret"));
+        shuffle(names.begin(), names.end(), mt19937(4));
+
+        unsigned long long before = heapAllocations.load();
+        auto start = chrono::steady_clock::now();
+        int found = 0;
+        for (int i = 0; i < n; i++)
+        {
+            found += tree.search(names[i]) != NIL;
+        }
+        double seconds = secondsSince(start);
+        unsigned long long allocations = heapAllocations.load() - before;
+
+        bool pass = found == n && allocations == 0;
+        ok = ok && pass;
+        cout << "search-allocations keys=" << shape
+             << " n=" << n
+             << " search_ns=" << seconds * 1e9 / n
+             << " allocations_per_search=" << static_cast<double>(allocations) / n
+             << (pass ? " PASS" : " FAIL") << "\n";
+    }
+    return ok;
+}
+
+// ---- Microbenchmark suite: one JSON object per line so runs can be diffed ----
+
+// Results that are otherwise unused land here so the timed loops are kept
+volatile long long suiteSink = 0;
+
+// Accumulates time and heap allocations for one operation across timed sections
+struct SuiteTimer
+{
+    double seconds = 0;
+    unsigned long long allocations = 0;
+    long long ops = 0;
+    chrono::steady_clock::time_point start;
+    unsigned long long allocStart = 0;
+
+    void begin()
+    {
+        allocStart = heapAllocations.load();
+        start = chrono::steady_clock::now();
+    }
+
+    void end(long long count)
+    {
+        seconds += secondsSince(start);
+        allocations += heapAllocations.load() - allocStart;
+        ops += count;
+    }
+};
+
+void reportSuite(const char* op, const string& keys, int n, const SuiteTimer& t)
+{
+    double ops = t.ops ? static_cast<double>(t.ops) : 1.0;
+    cout << "{\"bench\":\"" << op << "\""
+         << ",\"keys\":\"" << keys << "\""
+         << ",\"n\":" << n
+         << ",\"ops\":" << t.ops
+         << ",\"ns_per_op\":" << t.seconds * 1e9 / ops
+         << ",\"allocs_per_op\":" << t.allocations / ops
+         << "}\n";
+}
+
+// n distinct account names in insertion order: "sorted" ascending, "random"
+// shuffled hex, "shared-prefix" shuffled names with a common 8+ byte prefix
+vector<string> suiteKeys(const string& shape, int n)
+{
+    vector<string> names(n);
+    mt19937_64 rng(21);
+    char name[48];
+    for (int i = 0; i < n; i++)
+    {
+        if (shape == "random") snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(rng()));
+        else if (shape == "shared-prefix") snprintf(name, sizeof(name), "user%08d@example.com", i);
+        else snprintf(name, sizeof(name), "account%08d", i);
+        names[i] = name;
+    }
+    if (shape == "shared-prefix") shuffle(names.begin(), names.end(), mt19937(8));
+    return names;
+}
+
+// Operations whose cost depends on the account names: AccountBST, VaultStore and
+// the full PasswordManager add/edit/delete/undo/redo paths
+bool benchSuiteKeyed(const string& shape, int n)
+{
+    vector<string> names = suiteKeys(shape, n);
+    vector<string> lookups = names;
+    shuffle(lookups.begin(), lookups.end(), mt19937(5));
+    vector<string> misses(n);
+    for (int i = 0; i < n; i++) misses[i] = lookups[i] + "~";
+
+    bool ok = true;
+    {
+        RecordSlab records;
+        AccountBST tree(&records);
+        for (int i = 0; i < n; i++) records.allocate(names[i], "secret");
+
+        SuiteTimer insert;
+        insert.begin();
+        for (int i = 0; i < n; i++) tree.insert(static_cast<uint32_t>(i));
+        insert.end(n);
+        reportSuite("bst.insert", shape, n, insert);
+
+        SuiteTimer hit;
+        int found = 0;
+        hit.begin();
+        for (int i = 0; i < n; i++) found += tree.search(lookups[i]) != NIL;
+        hit.end(n);
+        reportSuite("bst.search_hit", shape, n, hit);
+
+        SuiteTimer miss;
+        int missed = 0;
+        miss.begin();
+        for (int i = 0; i < n; i++) missed += tree.search(misses[i]) == NIL;
+        miss.end(n);
+        reportSuite("bst.search_miss", shape, n, miss);
+
+        SuiteTimer remove;
+        remove.begin();
+        for (int i = 0; i < n; i++) tree.remove(tree.search(lookups[i]));
+        remove.end(n);
+        reportSuite("bst.remove", shape, n, remove);
+
+        ok = ok && found == n && missed == n && tree.isEmpty();
+    }
+
+    vector<string> plaintexts(n);
+    char pass[32];
+    for (int i = 0; i < n; i++)
+    {
+        snprintf(pass, sizeof(pass), "Pass#%d", i % 1000);
+        plaintexts[i] = pass;
+    }
+
+    PasswordManager manager;
+
+    SuiteTimer add;
+    int added = 0;
+    add.begin();
+    for (int i = 0; i < n; i++) added += manager.addPasswordEntry(names[i], plaintexts[i], nullOut);
+    add.end(n);
+    reportSuite("pm.add", shape, n, add);
+
+    SuiteTimer find;
+    int located = 0;
+    find.begin();
+    for (int i = 0; i < n; i++) located += manager.vault.find(lookups[i]) != nullptr;
+    find.end(n);
+    reportSuite("vault.find", shape, n, find);
+
+    SuiteTimer scan;
+    size_t bytes = 0;
+    scan.begin();
+    for (VaultIterator it = manager.vault.begin(); it.hasNext(); ) bytes += it.next()->password.size();
+    scan.end(n);
+    reportSuite("vault.scan", shape, n, scan);
+
+    // Every edit stays in the history, so all n can be undone and then redone
+    SuiteTimer edit, undo, redo;
+    int edited = 0;
+    edit.begin();
+    for (int i = 0; i < n; i++) edited += manager.editPasswordEntry(lookups[i], plaintexts[(i + 7) % n], nullOut);
+    edit.end(n);
+
+    undo.begin();
+    for (int i = 0; i < n; i++) manager.undo(nullOut);
+    undo.end(n);
+
+    redo.begin();
+    for (int i = 0; i < n; i++) manager.redo(nullOut);
+    redo.end(n);
+    reportSuite("pm.edit", shape, n, edit);
+    reportSuite("pm.undo", shape, n, undo);
+    reportSuite("pm.redo", shape, n, redo);
+
+    SuiteTimer erase;
+    int deleted = 0;
+    erase.begin();
+    for (int i = 0; i < n; i++) deleted += manager.deletePasswordEntry(lookups[i], nullOut);
+    erase.end(n);
+    reportSuite("pm.delete", shape, n, erase);
+
+    return ok && added == n && located == n && bytes > 0 && edited == n && deleted == n && manager.vault.isEmpty();
+}
+
+// Operations that do not depend on the vault: the undo history, the view-attempt
+// ring, the cipher, the strength checker and the email validator
+bool benchSuiteFixed(int n)
+{
+    VaultKey key;
+    string oldPassword = encryptPassword(key, "OldPass#1");
+    string newPassword = encryptPassword(key, "NewPass#2");
+
+    // Record 50 edits, then undo all 50 (each record also clears the redo log)
+    ActionHistory history;
+    SuiteTimer stack;
+    stack.begin();
+    for (int i = 0; i < n; i += 50)
+    {
+        int batch = min(50, n - i);
+        for (int j = 0; j < batch; j++) history.record(ActionType::Edit, "user00000001@example.com", oldPassword, newPassword);
+        for (int j = 0; j < batch; j++) history.markUndone();
+    }
+    stack.end(n);
+    reportSuite("history.record_undo", "none", n, stack);
+    bool ok = !history.canUndo();
+
+    // One identity failing and being checked, on a clock that moves 1 ms a step
+    AttemptTracker attempts;
+    auto clock = chrono::steady_clock::time_point();
+    SuiteTimer fail;
+    fail.begin();
+    for (int i = 0; i < n; i++) attempts.fail("user00000001@example.com", clock + chrono::milliseconds(i));
+    fail.end(n);
+    reportSuite("attempts.fail", "none", n, fail);
+
+    SuiteTimer check;
+    int lockouts = 0;
+    check.begin();
+    for (int i = 0; i < n; i++) lockouts += attempts.check("user00000001@example.com", clock + chrono::milliseconds(n + i)).locked;
+    check.end(n);
+    reportSuite("attempts.check", "none", n, check);
+
+    vector<string> passwords(1024);
+    mt19937 rng(17);
+    const char alphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789!@#$%^&*";
+    for (string& p : passwords)
+    {
+        int len = 8 + rng() % 17;
+        for (int i = 0; i < len; i++) p += alphabet[rng() % (sizeof(alphabet) - 1)];
+    }
+
+    SuiteTimer encrypt;
+    size_t cipherBytes = 0;
+    encrypt.begin();
+    for (int i = 0; i < n; i++) cipherBytes += encryptPassword(key, passwords[i & 1023]).size();
+    encrypt.end(n);
+    reportSuite("cipher.encrypt", "none", n, encrypt);
+
+    vector<string> sealed(passwords.size());
+    for (size_t i = 0; i < passwords.size(); i++) sealed[i] = encryptPassword(key, passwords[i]);
+    SuiteTimer decrypt;
+    decrypt.begin();
+    for (int i = 0; i < n; i++) cipherBytes += decryptPassword(key, sealed[i & 1023]).size();
+    decrypt.end(n);
+    reportSuite("cipher.decrypt", "none", n, decrypt);
+
+    SuiteTimer strength;
+    int strong = 0;
+    strength.begin();
+    for (int i = 0; i < n; i++) strong += checkAndSuggestStrength(passwords[i & 1023], nullOut);
+    strength.end(n);
+    reportSuite("strength.check", "none", n, strength);
+
+    const string emails[] = { "alice@example.com", "bob.smith@mail.co", "no-at-sign.com", "@missing.local", "trailing@dot.", "x@y.z" };
+    SuiteTimer email;
+    int valid = 0;
+    email.begin();
+    for (int i = 0; i < n; i++) valid += isValidEmail(emails[i % 6]);
+    email.end(n);
+    reportSuite("email.validate", "none", n, email);
+
+    suiteSink = lockouts + strong + valid;
+    return ok && cipherBytes > 0;
+}
+
+// Runs the fixed operations once and the keyed ones for each requested shape
+bool benchSuite(int n, const string& keys)
+{
+    bool ok = benchSuiteFixed(n);
+    const char* shapes[] = { "sorted", "random", "shared-prefix" };
+    for (const char* shape : shapes)
+    {
+        if (keys == "all" || keys == shape) ok = benchSuiteKeyed(shape, n) && ok;
+    }
+    cout << "{\"bench\":\"suite\",\"n\":" << n << ",\"result\":\"" << (ok ? "PASS" : "FAIL") << "\"}\n";
+    return ok;
+}
+
+// n edits spread over 1000 accounts, then n undos and n redos, checking the vault
+// ends where it started and where it finished. A second pass caps the history
+// at 1 MB and checks that eviction keeps it within budget.
+bool benchHistory(int n)
+{
+    const int accounts = 1000;
+    PasswordManager manager;
+    char name[32];
+    char pass[32];
+    vector<string> names(accounts);
+    for (int i = 0; i < accounts; i++)
+    {
+        snprintf(name, sizeof(name), "user%06d@example.com", i);
+        names[i] = name;
+        snprintf(pass, sizeof(pass), "Start#%d", i);
+        manager.addPasswordEntry(names[i], pass, nullOut);
+    }
+    manager.history.clear();
+    manager.history.setBudget(SIZE_MAX);  // First pass keeps every step
+
+    vector<string> plaintexts(n);
+    for (int i = 0; i < n; i++)
+    {
+        snprintf(pass, sizeof(pass), "Edit#%d", i);
+        plaintexts[i] = pass;
+    }
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < n; i++) manager.editPasswordEntry(names[i % accounts], plaintexts[i], nullOut);
+    double editSeconds = secondsSince(start);
+    size_t bytes = manager.history.bytesInUse();
+
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < n; i++) manager.undo(nullOut);
+    double undoSeconds = secondsSince(start);
+
+    bool ok = !manager.history.canUndo();
+    for (int i = 0; i < accounts; i++)
+    {
+        snprintf(pass, sizeof(pass), "Start#%d", i);
+        ok = ok && decryptPassword(manager.vault.key, manager.vault.find(names[i])->password) == pass;
+    }
+
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < n; i++) manager.redo(nullOut);
+    double redoSeconds = secondsSince(start);
+
+    ok = ok && !manager.history.canRedo();
+    for (int i = max(0, n - accounts); i < n; i++)
+    {
+        ok = ok && decryptPassword(manager.vault.key, manager.vault.find(names[i % accounts])->password) == plaintexts[i];
+    }
+
+    // Same edits under a 1 MB budget: the oldest steps are evicted
+    manager.history.clear();
+    manager.history.setBudget(1 << 20);
+    for (int i = 0; i < n; i++) manager.editPasswordEntry(names[i % accounts], plaintexts[i], nullOut);
+    size_t cappedBytes = manager.history.bytesInUse();
+    unsigned long long evicted = manager.history.evicted;
+    unsigned long long undone = 0;
+    while (manager.history.canUndo())
+    {
+        manager.undo(nullOut);
+        undone++;
+    }
+    ok = ok && cappedBytes <= manager.history.budget && undone + evicted == static_cast<unsigned long long>(n);
+
+    cout << "history n=" << n
+         << " edit_ns=" << editSeconds * 1e9 / n
+         << " undo_ns=" << undoSeconds * 1e9 / n
+         << " redo_ns=" << redoSeconds * 1e9 / n
+         << " bytes=" << bytes
+         << " bytes_per_step=" << static_cast<double>(bytes) / n
+         << " old_action_inline_bytes=" << 4 * sizeof(string)
+         << " capped_bytes=" << cappedBytes
+         << " evicted=" << evicted
+         << (ok ? " PASS" : " FAIL") << "\n";
+    return ok;
+}
+
+// n adds and n edits against a journaled vault, first with an fsync after every
+// mutation, then with group commit (one fsync per 64 mutations), and checks that
+// replaying each journal rebuilds the same vault.
+bool benchJournal(int n)
+{
+    const string path = "bench_journal";
+    const int groupSize = 64;
+    vector<string> names(n);
+    char name[32];
+    for (int i = 0; i < n; i++)
+    {
+        snprintf(name, sizeof(name), "account%08d", i);
+        names[i] = name;
+    }
+
+    bool ok = true;
+    for (int group : { 1, groupSize })
+    {
+        remove((path + ".wal").c_str());
+        PasswordManager manager;
+        ok = manager.openVault(path) == 0 && ok;
+
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < 2 * n; i++)
+        {
+            if (i < n) manager.addPasswordEntry(names[i], "Pass#1", nullOut);
+            else manager.editPasswordEntry(names[i - n], "Pass#2", nullOut);
+            if ((i + 1) % group == 0) manager.syncJournal();
+        }
+        manager.syncJournal();
+        double seconds = secondsSince(start);
+        unsigned long long syncs = manager.journal.syncs;
+        ok = manager.clearAllPasswords() && ok;
+
+        PasswordManager restored;
+        restored.vault.key = manager.vault.key;
+        start = chrono::steady_clock::now();
+        int replayed = restored.openVault(path);
+        double replaySeconds = secondsSince(start);
+        bool pass = replayed == 2 * n && restored.vault.size() == static_cast<uint32_t>(n)
+                 && decryptPassword(restored.vault.key, restored.vault.find(names[n - 1])->password) == "Pass#2";
+        ok = ok && pass;
+
+        cout << "journal fsync=" << (group == 1 ? "per-op" : "group") << " n=" << 2 * n
+             << " ops_per_sec=" << static_cast<long long>(2 * n / seconds)
+             << " fsyncs=" << syncs
+             << " replay_ms=" << replaySeconds * 1000
+             << (pass ? " PASS" : " FAIL") << "\n";
+    }
+    remove((path + ".wal").c_str());
+    return ok;
+}
+
+// Builds an n-record journaled vault, checkpoints it in the background while the
+// session keeps adding records, then compares opening the vault by replaying the
+// journal against mapping the snapshot, and times the first lookups after open.
+bool benchSnapshot(int n)
+{
+    const string path = "bench_vault";
+    const char* tsv = "bench_snapshot.tsv";
+    const int extra = 1000;
+    for (const char* ext : { ".snap", ".wal", ".wal.ckpt" }) remove((path + ext).c_str());
+    {
+        ofstream out(tsv);
+        char row[64];
+        for (int i = 0; i < n; i++)
+        {
+            int len = snprintf(row, sizeof(row), "account%08d\tPass#%d\n", i, i % 1000);
+            out.write(row, len);
+        }
+    }
+
+    bool ok = true;
+    PasswordManager manager;
+    ok = manager.openVault(path) == 0 && ok;
+    int skipped = 0;
+    int reused = 0;
+    ok = manager.importFromFile(tsv, skipped, reused) == n && ok;
+    remove(tsv);
+    ok = manager.clearAllPasswords() && ok;
+
+    // Baseline: rebuild the vault by replaying n journal records
+    double replayMs;
+    {
+        PasswordManager replayed;
+        replayed.vault.key = manager.vault.key;
+        auto start = chrono::steady_clock::now();
+        ok = replayed.openVault(path) == n && ok;
+        replayMs = secondsSince(start) * 1000;
+    }
+
+    // Checkpoint in the background while the session keeps mutating
+    ok = manager.openVault(path) == n && ok;
+    auto start = chrono::steady_clock::now();
+    ok = manager.startCheckpoint() && ok;
+    char name[32];
+    for (int i = 0; i < extra; i++)
+    {
+        snprintf(name, sizeof(name), "late%05d", i);
+        manager.addPasswordEntry(name, "Late#1", nullOut);
+        manager.syncJournal();
+    }
+    ok = manager.finishCheckpoint() && ok;
+    double checkpointMs = secondsSince(start) * 1000;
+    ok = manager.clearAllPasswords() && ok;
+
+    PasswordManager opened;
+    opened.vault.key = manager.vault.key;
+    start = chrono::steady_clock::now();
+    int replayed = opened.openVault(path);
+    double openMs = secondsSince(start) * 1000;
+
+    // First lookups go straight to the mapped tables
+    mt19937 rng(3);
+    const int probes = 1000;
+    int correct = 0;
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < probes; i++)
+    {
+        int k = rng() % n;
+        snprintf(name, sizeof(name), "account%08d", k);
+        PasswordNode* node = opened.vault.find(name);
+        correct += node && decryptPassword(opened.vault.key, node->password) == "Pass#" + to_string(k % 1000);
+    }
+    double lookupUs = secondsSince(start) * 1e6 / probes;
+
+    ok = ok && replayed == extra && opened.vault.size() == static_cast<uint32_t>(n + extra)
+            && opened.vault.find("late00999") != nullptr && correct == probes;
+    opened.clearAllPasswords();
+    for (const char* ext : { ".snap", ".wal", ".wal.ckpt" }) remove((path + ext).c_str());
+
+    cout << "snapshot n=" << n
+         << " journal_open_ms=" << replayMs
+         << " checkpoint_ms=" << checkpointMs
+         << " snapshot_open_ms=" << openMs
+         << " first_lookup_us=" << lookupUs
+         << (ok ? " PASS" : " FAIL") << "\n";
+    return ok;
+}
+
+// Runs a generated script of n adds, n searches, n edits, n/10 undo+redo pairs
+// and n deletes through runBatch, once in memory and once logged in (journaled),
+// and reports commands/second.
+bool benchBatch(int n)
+{
+    string script;
+    char line[96];
+    for (int i = 0; i < n; i++)
+    {
+        script.append(line, snprintf(line, sizeof(line), "add\taccount%08d\tPass#%d!A\n", i, i));
+    }
+    for (int i = 0; i < n; i++)
+    {
+        script.append(line, snprintf(line, sizeof(line), "search\taccount%08d\n", (i * 7919) % n));
+    }
+    for (int i = 0; i < n; i++)
+    {
+        script.append(line, snprintf(line, sizeof(line), "edit\taccount%08d\tNew#%d!B\n", i, i));
+        if (i % 10 == 0) script += "undo\nredo\n";
+    }
+    for (int i = 0; i < n; i++)
+    {
+        script.append(line, snprintf(line, sizeof(line), "delete\taccount%08d\n", i));
+    }
+    long long commands = 4LL * n + 2 * ((n + 9) / 10);
+
+    const string email = "batch-bench@example.com";
+    bool ok = true;
+    for (bool journaled : { false, true })
+    {
+        string path = vaultPathFor(email);
+        for (const char* ext : { ".snap", ".wal", ".wal.ckpt" }) remove((path + ext).c_str());
+        PasswordManager manager;
+        istringstream in(journaled ? "login\t" + email + "\n" + script : script);
+        ostringstream out;
+
+        auto start = chrono::steady_clock::now();
+        long long failed = runBatch(in, out, manager);
+        double seconds = secondsSince(start);
+        manager.clearAllPasswords();
+
+        string text = out.str();
+        long long lines = count(text.begin(), text.end(), '\n');
+        long long expected = commands + n + (journaled ? 1 : 0);  // Results plus one "=" line per search
+        bool pass = failed == 0 && lines == expected;
+        ok = ok && pass;
+        cout << "batch mode=" << (journaled ? "journaled" : "memory")
+             << " commands=" << commands
+             << " seconds=" << seconds
+             << " commands_per_sec=" << static_cast<long long>(commands / seconds)
+             << (pass ? " PASS" : " FAIL") << "\n";
+        for (const char* ext : { ".snap", ".wal", ".wal.ckpt" }) remove((path + ext).c_str());
+    }
+    return ok;
+}
+
+// Prefix queries (first 10 matches of a 1-4 letter prefix) over n random names,
+// served by the in-memory tree and then by a mapped snapshot, checked against a
+// sorted vector.
+bool benchPrefix(int n)
+{
+    const int k = 10;
+    const int queries = 100000;
+    mt19937_64 rng(14);
+    vector<string> names(n);
+    char name[32];
+    for (int i = 0; i < n; i++)
+    {
+        int len = 3 + rng() % 6;
+        for (int j = 0; j < len; j++) name[j] = static_cast<char>('a' + rng() % 26);
+        snprintf(name + len, sizeof(name) - len, "%d", static_cast<int>(rng() % 1000));
+        names[i] = name;
+    }
+
+    VaultStore store;
+    for (const string& s : names) store.add(s, "secret");
+    vector<string> sorted(names);
+    sort(sorted.begin(), sorted.end());
+    sorted.erase(unique(sorted.begin(), sorted.end()), sorted.end());
+
+    vector<string> prefixes(queries);
+    for (int i = 0; i < queries; i++) prefixes[i] = names[rng() % n].substr(0, 1 + rng() % 4);
+
+    const char* path = "bench_prefix.snap";
+    bool ok = writeSnapshot(store, path);
+    bool pass = true;
+    for (int layout = 0; layout < 2 && ok; layout++)
+    {
+        VaultStore snapshotStore;
+        snapshotStore.key = store.key;  // Its salt must match the snapshot's
+        if (layout == 1) ok = snapshotStore.attachSnapshot(path) && ok;
+        VaultStore& vault = layout == 0 ? store : snapshotStore;
+
+        string_view matches[k];
+        long long returned = 0;
+        auto start = chrono::steady_clock::now();
+        for (const string& prefix : prefixes) returned += vault.withPrefix(prefix, matches, k);
+        double seconds = secondsSince(start);
+
+        // Check a sample against the sorted vector
+        for (int i = 0; i < queries; i += 97)
+        {
+            int found = vault.withPrefix(prefixes[i], matches, k);
+            auto it = lower_bound(sorted.begin(), sorted.end(), prefixes[i]);
+            int expected = 0;
+            for (; it != sorted.end() && expected < k && it->compare(0, prefixes[i].size(), prefixes[i]) == 0; ++it, ++expected)
+            {
+                pass = pass && expected < found && matches[expected] == *it;
+            }
+            pass = pass && found == expected;
+        }
+
+        cout << "prefix layout=" << (layout == 0 ? "tree" : "snapshot")
+             << " n=" << n
+             << " k=" << k
+             << " query_ns=" << seconds * 1e9 / queries
+             << " avg_matches=" << static_cast<double>(returned) / queries
+             << (pass && ok ? " PASS" : " FAIL") << "\n";
+    }
+    remove(path);
+    return ok && pass;
+}
+
+// Fuzzy lookup of mistyped names (one or two random edits or swaps of a stored name) over
+// the tree and over a mapped snapshot; a sample is checked against a full scan
+bool benchFuzzy(int n)
+{
+    const int k = SUGGESTION_COUNT;
+    const int queries = 300;
+    mt19937_64 rng(15);
+    vector<string> names(n);
+    char name[32];
+    for (int i = 0; i < n; i++)
+    {
+        int len = 4 + rng() % 9;
+        for (int j = 0; j < len; j++) name[j] = static_cast<char>('a' + rng() % 26);
+        snprintf(name + len, sizeof(name) - len, "%d", static_cast<int>(rng() % 100));
+        names[i] = name;
+    }
+
+    VaultStore store;
+    for (const string& s : names) store.add(s, "secret");
+    vector<string> uniqueNames(names);
+    sort(uniqueNames.begin(), uniqueNames.end());
+    uniqueNames.erase(unique(uniqueNames.begin(), uniqueNames.end()), uniqueNames.end());
+
+    vector<string> typed(queries);
+    vector<string> intended(queries);
+    for (int i = 0; i < queries; i++)
+    {
+        string s = names[rng() % n];
+        intended[i] = s;
+        for (int edits = 1 + rng() % 2; edits > 0; edits--)
+        {
+            size_t at = rng() % s.size();
+            char c = static_cast<char>('a' + rng() % 26);
+            switch (rng() % 4)
+            {
+            case 0: s[at] = c; break;
+            case 1: s.insert(s.begin() + at, c); break;
+            case 2: if (at + 1 < s.size()) swap(s[at], s[at + 1]); break;
+            default: if (s.size() > 1) s.erase(at, 1); break;
+            }
+        }
+        typed[i] = s;
+    }
+
+    const char* path = "bench_fuzzy.snap";
+    bool ok = writeSnapshot(store, path);
+    bool pass = true;
+    for (int layout = 0; layout < 2 && ok; layout++)
+    {
+        VaultStore snapshotStore;
+        snapshotStore.key = store.key;  // Its salt must match the snapshot's
+        if (layout == 1) ok = snapshotStore.attachSnapshot(path) && ok;
+        VaultStore& vault = layout == 0 ? store : snapshotStore;
+
+        FuzzyMatch matches[k];
+        auto start = chrono::steady_clock::now();
+        vault.closestNames(typed[0], typoBudget(typed[0].size()), matches, k);
+        double firstSeconds = secondsSince(start);
+
+        long long returned = 0;
+        int recalled = 0;
+        int reachable = 0;
+        double worst = 0;
+        start = chrono::steady_clock::now();
+        for (int i = 0; i < queries; i++)
+        {
+            auto queryStart = chrono::steady_clock::now();
+            int budget = typoBudget(typed[i].size());
+            int found = vault.closestNames(typed[i], budget, matches, k);
+            worst = max(worst, secondsSince(queryStart));
+            returned += found;
+
+            // The intended name must come back unless the typo moved it out of
+            // range or k closer names exist
+            if (editDistance(typed[i], intended[i], budget) <= budget)
+            {
+                reachable++;
+                for (int j = 0; j < found; j++) recalled += matches[j].name == intended[i];
+            }
+        }
+        double seconds = secondsSince(start);
+
+        // Check a few queries against a plain scan of every name
+        for (int i = 0; i < queries; i += 50)
+        {
+            int budget = typoBudget(typed[i].size());
+            vector<pair<int, string>> expected;
+            for (const string& s : uniqueNames)
+            {
+                int d = editDistance(typed[i], s, budget);
+                if (d <= budget) expected.push_back(make_pair(d, s));
+            }
+            sort(expected.begin(), expected.end());
+            int found = vault.closestNames(typed[i], budget, matches, k);
+            pass = pass && found == static_cast<int>(min<size_t>(expected.size(), k));
+            for (int j = 0; j < found && pass; j++)
+            {
+                pass = matches[j].distance == expected[j].first && matches[j].name == expected[j].second;
+            }
+        }
+
+        cout << "fuzzy layout=" << (layout == 0 ? "tree" : "snapshot")
+             << " n=" << n
+             << " k=" << k
+             << " first_query_ms=" << firstSeconds * 1e3
+             << " query_ms=" << seconds * 1e3 / queries
+             << " max_query_ms=" << worst * 1e3
+             << " avg_matches=" << static_cast<double>(returned) / queries
+             << " recall=" << (reachable ? static_cast<double>(recalled) / reachable : 1.0)
+             << (pass && ok ? " PASS" : " FAIL") << "\n";
+    }
+    remove(path);
+    return ok && pass;
+}
+
+// Many users at once. Each thread runs its share of n operations on random
+// sessions: 90% lookups under the session's shared lock, 10% edits under its
+// exclusive lock. "spread" picks among 64 users, so threads rarely meet; "shared"
+// sends every thread to one user, so its reader-writer lock carries all the
+// traffic. Thread counts double up to the core count (at least 4, so the locks
+// are exercised even on small machines). Only "spread" with 2 to cores threads
+// is judged on speed: it must reach minSpeedup per thread of the 1-thread rate.
+// The other lines print SKIP (one core cannot speed anything up, and "shared"
+// is bound by its one lock). Afterwards every edit is undone and each vault
+// must be back to its starting passwords.
+bool benchSessions(int n)
+{
+    const int users = 64;
+    const int accounts = 10000;
+    const int editEvery = 10;
+    const double minSpeedup = 0.5;
+    unsigned cores = max(1u, thread::hardware_concurrency());
+
+    SessionTable table;
+    vector<Session*> sessions(users);
+    vector<string> names(accounts);
+    char text[64];
+    for (int a = 0; a < accounts; a++)
+    {
+        snprintf(text, sizeof(text), "account%05d", a);
+        names[a] = text;
+    }
+    // Each sign-in derives a key, so sign the users in on every core
+    parallelFor(users, cores, [&](size_t u)
+    {
+        char line[64];
+        snprintf(line, sizeof(line), "user%02d@example.com", static_cast<int>(u));
+        int opened = 0;
+        sessions[u] = table.open(line, "pw", false, opened);
+        for (int a = 0; a < accounts; a++)
+        {
+            snprintf(line, sizeof(line), "Start#%d", a);
+            sessions[u]->pm.addPasswordEntry(names[a], line, nullOut);
+        }
+        sessions[u]->pm.history.clear();
+        sessions[u]->pm.history.setBudget(SIZE_MAX);  // Keep every edit for the undo check
+    });
+    bool ok = table.size() == static_cast<size_t>(users);
+
+    atomic<long long> edits(0);
+    atomic<long long> misses(0);
+    for (int shared = 0; shared < 2; shared++)
+    {
+        double baseRate = 0;
+        for (unsigned threads = 1; threads <= max(cores, 4u); threads *= 2)
+        {
+            auto worker = [&](unsigned id)
+            {
+                ostream quiet(nullptr);
+                mt19937 rng(1000 * shared + id);
+                string plaintext = "Edit#" + to_string(id);
+                long long done = 0;
+                int ops = n / static_cast<int>(threads);
+                for (int i = 0; i < ops; i++)
+                {
+                    Session* session = sessions[shared ? 0 : rng() % users];
+                    const string& account = names[rng() % accounts];
+                    if (i % editEvery == 0)
+                    {
+                        unique_lock<shared_mutex> guard(session->lock);
+                        done += session->pm.editPasswordEntry(account, plaintext, quiet);
+                    }
+                    else
+                    {
+                        shared_lock<shared_mutex> guard(session->lock);
+                        string_view encrypted;
+                        if (!session->pm.vault.lookup(account, encrypted)) misses++;
+                    }
+                }
+                edits += done;
+            };
+
+            auto start = chrono::steady_clock::now();
+            vector<thread> pool;
+            for (unsigned t = 0; t < threads; t++) pool.emplace_back(worker, t);
+            for (thread& t : pool) t.join();
+            double seconds = secondsSince(start);
+
+            double rate = n / seconds;
+            if (threads == 1) baseRate = rate;
+            bool judged = !shared && threads > 1 && threads <= cores;
+            bool fast = !judged || rate / baseRate >= minSpeedup * threads;
+            ok = ok && fast;
+            cout << "sessions mode=" << (shared ? "shared" : "spread")
+                 << " users=" << (shared ? 1 : users)
+                 << " threads=" << threads
+                 << " cores=" << cores
+                 << " ops=" << n
+                 << " ops_per_sec=" << static_cast<long long>(rate)
+                 << " speedup=" << rate / baseRate
+                 << (misses != 0 || !fast ? " FAIL" : judged ? " PASS" : " SKIP") << "\n";
+        }
+    }
+
+    // Undo everything: the vaults must hold their starting passwords again
+    long long undone = 0;
+    for (Session* session : sessions)
+    {
+        while (session->pm.history.canUndo())
+        {
+            undone += session->pm.undo(nullOut);
+        }
+        for (int a = 0; a < accounts && ok; a += 97)
+        {
+            snprintf(text, sizeof(text), "Start#%d", a);
+            ok = decryptPassword(session->pm.vault.key, session->pm.vault.find(names[a])->password) == text;
+        }
+    }
+    ok = ok && misses == 0 && undone == edits;
+    for (int u = 0; u < users; u++) table.close(sessions[u]->user.email);
+    ok = ok && table.size() == 0;
+    cout << "sessions edits=" << edits << " undone=" << undone << (ok ? " PASS" : " FAIL") << "\n";
+    return ok;
+}
+
+// Writer latency while a scanner keeps walking the whole vault. One writer edits
+// (and every 16th op adds or deletes a spare account) under the session's
+// exclusive lock while one scanner thread: does nothing, with read views off
+// ("off") and on ("idle"); walks the live tree under the shared lock ("locked",
+// the old way); or walks read views ("views"). Every scan must see one whole
+// version (sorted, n or n + 1 accounts), and "views" must leave the writer's p99
+// latency where "idle" had it. That check needs 2+ cores: on one, the writer's
+// latency also counts the time slices the scanner runs in. With timed unset
+// ("bench check") the writer does a tenth of the writes and only the scans are
+// checked.
+bool benchReadViews(int n, bool timed = true)
+{
+    const int writes = timed ? 200000 : 20000;
+    unsigned cores = max(1u, thread::hardware_concurrency());
+    Session session("readviews-bench@example.com");
+    vector<string> names(n);
+    char text[64];
+    for (int a = 0; a < n; a++)
+    {
+        snprintf(text, sizeof(text), "account%07d", a);
+        names[a] = text;
+        session.pm.addPasswordEntry(names[a], "Start#" + to_string(a), nullOut);
+    }
+    const string spare = "account~spare";
+
+    // A view keeps its version while the vault changes
+    session.pm.vault.enableReadViews();
+    bool ok = true;
+    {
+        VaultReadView before = session.readView();
+        session.pm.editPasswordEntry(names[0], "Changed", nullOut);
+        VaultReadView after = session.readView();
+        ok = decryptPassword(session.pm.vault.key, before.begin().next()->password()) == "Start#0"
+            && decryptPassword(session.pm.vault.key, after.begin().next()->password()) == "Changed";
+    }
+    session.pm.vault.clear();
+    for (int a = 0; a < n; a++) session.pm.addPasswordEntry(names[a], "Start#" + to_string(a), nullOut);
+    session.pm.history.clear();
+
+    double idleP99 = 0;
+    double viewsP99 = 0;
+    for (const char* mode : { "off", "idle", "locked", "views" })
+    {
+        string m = mode;
+        if (m == "idle") session.pm.vault.enableReadViews();
+        atomic<bool> stop(false);
+        atomic<long long> scans(0);
+        atomic<long long> torn(0);
+
+        thread scanner([&]()
+        {
+            while (!stop && (m == "locked" || m == "views"))
+            {
+                uint32_t count = 0;
+                bool sorted = true;
+                string_view last;
+                if (m == "locked")
+                {
+                    shared_lock<shared_mutex> guard(session.lock);
+                    for (VaultIterator it = session.pm.vault.begin(); it.hasNext(); count++)
+                    {
+                        string_view name = it.next()->accountName;
+                        sorted = sorted && (count == 0 || last < name);
+                        last = name;
+                    }
+                }
+                else
+                {
+                    VaultReadView view = session.readView();
+                    for (VersionIterator it = view.begin(); it.hasNext(); count++)
+                    {
+                        string_view name = it.next()->name();
+                        sorted = sorted && (count == 0 || last < name);
+                        last = name;
+                    }
+                }
+                if (!sorted || (count != static_cast<uint32_t>(n) && count != static_cast<uint32_t>(n) + 1)) torn++;
+                scans++;
+                this_thread::yield();
+            }
+        });
+
+        vector<long long> latency(writes);
+        mt19937 rng(7);
+        bool spareStored = false;
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < writes; i++)
+        {
+            auto opStart = chrono::steady_clock::now();
+            {
+                lock_guard<shared_mutex> guard(session.lock);
+                if (i % 16 == 0)
+                {
+                    spareStored = spareStored
+                        ? !session.pm.deletePasswordEntry(spare, nullOut)
+                        : session.pm.addPasswordEntry(spare, "Spare", nullOut);
+                }
+                else
+                {
+                    session.pm.editPasswordEntry(names[rng() % n], "Edit#" + to_string(i), nullOut);
+                }
+            }
+            latency[i] = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - opStart).count();
+        }
+        double seconds = secondsSince(start);
+        stop = true;
+        scanner.join();
+
+        sort(latency.begin(), latency.end());
+        double p50 = latency[writes / 2] / 1000.0;
+        double p99 = latency[writes * 99 / 100] / 1000.0;
+        if (m == "idle") idleP99 = p99;
+        if (m == "views") viewsP99 = p99;
+        ok = ok && torn == 0;
+        cout << "readviews mode=" << m
+             << " n=" << n
+             << " writes_per_sec=" << static_cast<long long>(writes / seconds)
+             << " p50_us=" << p50
+             << " p99_us=" << p99
+             << " max_us=" << latency[writes - 1] / 1000.0
+             << " scans=" << scans
+             << " torn_scans=" << torn
+             << (torn == 0 ? " PASS" : " FAIL") << "\n";
+    }
+
+    bool judged = timed && cores >= 2;
+    ok = ok && (!judged || viewsP99 <= 2 * idleP99 + 2);
+    session.pm.clearAllPasswords();
+    cout << "readviews cores=" << cores << " idle_p99_us=" << idleP99 << " views_p99_us=" << viewsP99
+         << (!timed ? " (latency not judged in a check run)" : cores < 2 ? " (latency not judged on 1 core)" : "")
+         << (ok ? " PASS" : " FAIL") << "\n";
+    return ok;
+}
+
+// Password of generated account i (of n) for the audit benchmark: unique ones
+// missing each character class in turn, some longer than a vector, some with
+// UTF-8 bytes (symbols), and every 10th shared with other accounts (reused).
+string auditBenchPassword(int i, int n, bool& reused)
+{
+    reused = i % 10 == 0 && n > 20;
+    if (reused) return i % 20 == 0 ? "Shared#Pass1" : "sharedpass";
+    string digits = to_string(i);
+    string letters = digits;
+    for (char& c : letters) c = static_cast<char>('a' + (c - '0'));
+    switch (i % 6)
+    {
+        case 0: return "Pass#" + digits + "!x";
+        case 1: return "lower#" + digits;
+        case 2: return "Upper" + digits;
+        case 3: return "NoDigits!" + letters;
+        case 4: return "A long pass phrase with spaces, more than one vector wide " + digits;
+        default: return "\xC3\xA9t\xC3\xA9" + digits + "Z";
+    }
+}
+
+// Fill an empty vault with accounts account00000000.. and auditBenchPassword
+void buildAuditVault(VaultStore& store, int n, vector<uint8_t>& expectReused)
+{
+    vector<pair<string, string>> sorted(n);
+    expectReused.assign(n, 0);
+    char name[32];
+    for (int i = 0; i < n; i++)
+    {
+        bool reused;
+        snprintf(name, sizeof(name), "account%08d", i);
+        sorted[i].first = name;
+        sorted[i].second = auditBenchPassword(i, n, reused);
+        expectReused[i] = reused;
+    }
+    // Scored and sealed the way importFromFile does it
+    vector<uint8_t> strengths = estimateStrengths(sorted);
+    for (auto& row : sorted) row.second = encryptPassword(store.key, row.second);
+    int skipped = 0;
+    int reused = 0;
+    store.bulkLoadSorted(sorted, skipped, reused, &strengths);
+}
+
+// Entries whose verdict disagrees with checkAndSuggestStrength or with reused()
+template <typename Reused>
+long long auditMismatches(VaultStore& store, const AuditReport& report, Reused reused)
+{
+    long long mismatches = 0;
+    long long i = 0;
+    forEachAudited(store, report, [&](PasswordNode* node, uint8_t verdict)
+    {
+        bool strong = checkAndSuggestStrength(decryptPassword(store.key, node->password), nullOut);
+        mismatches += !auditWeak(verdict) != strong
+            || ((verdict & AUDIT_REUSED) != 0) != reused(i++, node);
+        return true;
+    });
+    return mismatches;
+}
+
+// Audits an n-entry vault on one thread and on one per core, checking every
+// verdict against checkAndSuggestStrength and the generator's reuse. The vault
+// is filled like an import, so its records carry their strength scores and the
+// timed audit estimates nothing; the mixed vault below has records without
+// one (snapshot and changed ones), which the audit estimates. Before
+// that, the SIMD kernel is checked against the scalar one on sealed random bytes;
+// after, a vault of snapshot plus in-memory records (min(n, 1M) accounts) is
+// checked against reuse counted by brute force.
+bool benchAudit(int n)
+{
+    bool ok = true;
+    mt19937 rng(11);
+    VaultKey key;
+    const unsigned char zeros[80] = { 0 };
+    for (int t = 0; t < 200000; t++)
+    {
+        string bytes(rng() % 80, '\0');
+        for (char& c : bytes) c = static_cast<char>(rng() % 4 ? 32 + rng() % 95 : rng() % 256);
+        int expected = classKernelScalar(reinterpret_cast<const unsigned char*>(bytes.data()), zeros, bytes.size());
+        ok = ok && passwordClasses(key, encryptPassword(key, bytes)) == expected
+            && (expected == CLASS_ALL) == hasStrengthClasses(bytes);
+    }
+    cout << "audit kernel=" << classKernelName << " random_inputs=200000" << (ok ? " PASS" : " FAIL") << "\n";
+
+    vector<uint8_t> expectReused;
+    {
+        VaultStore store;
+        buildAuditVault(store, n, expectReused);
+        vector<unsigned> threadCounts = { 1 };
+        unsigned cores = max(1u, thread::hardware_concurrency());
+        if (cores > 1) threadCounts.push_back(cores);
+        for (unsigned threads : threadCounts)
+        {
+            AuditReport report = auditVault(store, threads);
+            long long mismatches = auditMismatches(store, report,
+                [&](long long i, PasswordNode*) { return expectReused[i] != 0; });
+            bool pass = mismatches == 0 && report.entries == static_cast<uint64_t>(n);
+            ok = ok && pass;
+            cout << "audit n=" << n
+                 << " threads=" << threads
+                 << " seconds=" << report.seconds
+                 << " entries_per_sec=" << static_cast<long long>(n / max(report.seconds, 1e-9))
+                 << " weak=" << report.weak
+                 << " guessable=" << report.guessable
+                 << " reused=" << report.reused
+                 << " mismatches=" << mismatches
+                 << (pass ? " PASS" : " FAIL") << "\n";
+        }
+    }
+
+    // Snapshot records plus in-memory ones: changed records, some now sharing a
+    // password, and new ones reusing snapshot passwords (making those reused too)
+    int m = min(n, 1000000);
+    const string snap = "bench_audit.snap";
+    VaultStore store;
+    {
+        VaultStore written;
+        written.key = store.key;
+        buildAuditVault(written, m, expectReused);
+        ok = writeSnapshot(written, snap) && ok;
+    }
+    ok = store.attachSnapshot(snap) && ok;
+    char name[32];
+    bool reused;
+    for (int i = 0; i < m; i += 7)
+    {
+        snprintf(name, sizeof(name), "account%08d", i);
+        PasswordNode* node = store.find(name);
+        if (node) store.setPassword(node, encryptPassword(store.key, i % 2 ? "Edited#" + to_string(i) : "Edited#shared"));
+    }
+    for (int i = 0; i < m / 50; i++)
+    {
+        snprintf(name, sizeof(name), "new%08d", i);
+        int other = static_cast<int>(rng() % m);
+        store.add(name, encryptPassword(store.key, i % 3 ? auditBenchPassword(other, m, reused) : "Fresh#" + to_string(i)));
+    }
+
+    unordered_map<string_view, int> uses;
+    for (VaultIterator it = store.begin(); it.hasNext(); ) uses[it.next()->password]++;
+    AuditReport report = auditVault(store);
+    long long mismatches = auditMismatches(store, report,
+        [&](long long, PasswordNode* node) { return uses[node->password] > 1; });
+    bool pass = mismatches == 0 && report.entries == store.size() && store.base.count > 0;
+    ok = ok && pass;
+    cout << "audit mixed snapshot=" << store.base.liveCount()
+         << " memory=" << store.records.liveCount
+         << " seconds=" << report.seconds
+         << " reused=" << report.reused
+         << " mismatches=" << mismatches
+         << (pass ? " PASS" : " FAIL") << "\n";
+    store.clear();
+    remove(snap.c_str());
+    return ok;
+}
+
+// Writes a sorted "HEX:count" breach list of n random hashes plus the SHA-1s of
+// "Breached#k" (k < planted, count k + 1), builds its filter, then times
+// single-password checks of clean and breached passwords, the filter's false
+// positive rate, and the whole-vault check of min(n, 1M) accounts, one in a
+// hundred with a breached password. Every answer is checked.
+bool benchBreach(int n)
+{
+    bool ok = true;
+    const char* vectors[][2] = {
+        { "", "DA39A3EE5E6B4B0D3255BFEF95601890AFD80709" },
+        { "abc", "A9993E364706816ABA3E25717850C26C9CD0D89D" },
+        { "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", "84983E441C3BD26EBAAE4AA1F95129E5E54670F1" },
+    };
+    for (auto& v : vectors) ok = ok && sha1Hex(sha1(v[0])) == v[1];
+    ok = ok && sha1Hex(sha1(string(1000000, 'a'))) == "34AA973CD4C4DAA4F61EEB2BDBAD27316534016F";
+    cout << "breach sha1_vectors=4" << (ok ? " PASS" : " FAIL") << "\n";
+
+    const string path = "bench_breach.txt";
+    int planted = max(1000, n / 1000);
+    auto start = chrono::steady_clock::now();
+    {
+        vector<pair<Sha1Digest, uint32_t>> lines(static_cast<size_t>(n) + planted);
+        mt19937_64 rng(20);
+        for (int i = 0; i < n; i++)
+        {
+            for (int b = 0; b < SHA1_BYTES; b += 4)
+            {
+                uint32_t r = static_cast<uint32_t>(rng());
+                memcpy(lines[i].first.bytes + b, &r, 4);
+            }
+            lines[i].second = 1 + static_cast<uint32_t>(rng() % 1000);
+        }
+        for (int k = 0; k < planted; k++) lines[n + k] = { sha1("Breached#" + to_string(k)), static_cast<uint32_t>(k + 1) };
+        sort(lines.begin(), lines.end(), [](const pair<Sha1Digest, uint32_t>& a, const pair<Sha1Digest, uint32_t>& b) { return a.first < b.first; });
+
+        FILE* file = fopen(path.c_str(), "wb");
+        if (!file)
+        {
+            cout << "breach could not write " << path << " FAIL\n";
+            return false;
+        }
+        string buffer;
+        for (const auto& line : lines)
+        {
+            buffer += sha1Hex(line.first);
+            buffer += ':';
+            buffer += to_string(line.second);
+            buffer += "\r\n";
+            if (buffer.size() >= (1 << 20))
+            {
+                fwrite(buffer.data(), 1, buffer.size(), file);
+                buffer.clear();
+            }
+        }
+        fwrite(buffer.data(), 1, buffer.size(), file);
+        fclose(file);
+    }
+    double generateSeconds = secondsSince(start);
+
+    string error;
+    start = chrono::steady_clock::now();
+    long long keys = BreachList::buildFilter(path, error);
+    double buildSeconds = secondsSince(start);
+    BreachList list;
+    bool opened = list.open(path) && list.hasFilter();
+    bool pass = keys == static_cast<long long>(n) + planted && opened;
+    ok = ok && pass;
+    cout << "breach n=" << n
+         << " planted=" << planted
+         << " list_mb=" << list.list.size / (1 << 20)
+         << " filter_mb=" << list.filter.size / (1 << 20)
+         << " generate_seconds=" << generateSeconds
+         << " index_seconds=" << buildSeconds
+         << (pass ? " PASS" : " FAIL") << "\n";
+    if (!opened)
+    {
+        remove(path.c_str());
+        remove((path + ".bloom").c_str());
+        return false;
+    }
+
+    // Single checks, hashing included, as addPasswordEntry does them
+    for (int breached = 0; breached <= 1; breached++)
+    {
+        int checks = breached ? planted : 200000;
+        vector<double> micros(checks);
+        long long wrong = 0;
+        long long filterPassed = 0;
+        for (int i = 0; i < checks; i++)
+        {
+            string password = (breached ? "Breached#" : "Clean#") + to_string(i);
+            auto t = chrono::steady_clock::now();
+            Sha1Digest digest = sha1(password);
+            uint64_t seen = list.lookup(digest);
+            micros[i] = secondsSince(t) * 1e6;
+            wrong += seen != static_cast<uint64_t>(breached ? i + 1 : 0);
+            filterPassed += !breached && list.mayContain(digest);
+        }
+        sort(micros.begin(), micros.end());
+        double total = 0;
+        for (double m : micros) total += m;
+        pass = wrong == 0;
+        ok = ok && pass;
+        cout << "breach check=" << (breached ? "breached" : "clean")
+             << " checks=" << checks
+             << " avg_us=" << total / checks
+             << " p99_us=" << micros[static_cast<size_t>(checks * 0.99)];
+        if (!breached) cout << " filter_false_positive_rate=" << static_cast<double>(filterPassed) / checks;
+        cout << " wrong=" << wrong << (pass ? " PASS" : " FAIL") << "\n";
+    }
+
+    // Whole vault: one sorted sweep of the list
+    int m = min(n, 1000000);
+    {
+        VaultStore store;
+        char name[32];
+        long long expected = 0;
+        for (int i = 0; i < m; i++)
+        {
+            snprintf(name, sizeof(name), "account%08d", i);
+            bool breached = i % 100 == 0;
+            expected += breached;
+            store.add(name, encryptPassword(store.key, breached ? "Breached#" + to_string(i / 100 % planted) : "Clean#" + to_string(i)));
+        }
+        AuditReport report;
+        report.threads = max(1u, thread::hardware_concurrency());
+        report.slabVerdicts.assign(store.records.highWater, 0);
+        auditBreaches(store, list, report);
+        long long mismatches = 0;
+        long long i = 0;
+        forEachAudited(store, report, [&](PasswordNode*, uint8_t verdict)
+        {
+            mismatches += ((verdict & AUDIT_BREACHED) != 0) != (i++ % 100 == 0);
+            return true;
+        });
+        pass = mismatches == 0 && static_cast<long long>(report.breached) == expected;
+        ok = ok && pass;
+        cout << "breach vault=" << m
+             << " threads=" << report.threads
+             << " seconds=" << report.seconds
+             << " entries_per_sec=" << static_cast<long long>(m / max(report.seconds, 1e-9))
+             << " breached=" << report.breached
+             << " mismatches=" << mismatches
+             << (pass ? " PASS" : " FAIL") << "\n";
+    }
+
+    list.close();
+    remove(path.c_str());
+    remove((path + ".bloom").c_str());
+    return ok;
+}
+
+// Shows passwords of an n-entry vault, nine in ten from 100 hot accounts,
+// opening each record every time and then through the plaintext cache (records
+// are looked up beforehand, so only the opening is timed), for
+// short passwords (one AES block, the fast lane path) and 30+ character ones.
+// Checks the answers, that the cache stays within PLAINTEXT_CACHE_ENTRIES,
+// that a full listing leaves it alone, and that expiry and logout wipe it.
+bool benchPlaintextCache(int n)
+{
+    const int lookups = 1000000;
+    const int hot = 100;
+    mt19937 rng(17);
+    vector<int> order(lookups);
+    for (int& i : order) i = rng() % 10 ? static_cast<int>(rng() % hot) : static_cast<int>(rng() % n);
+    vector<string> names(n);
+    char name[32];
+    for (int i = 0; i < n; i++)
+    {
+        snprintf(name, sizeof(name), "account%08d", i);
+        names[i] = name;
+    }
+
+    bool ok = true;
+    for (bool longPasswords : { false, true })
+    {
+        auto text = [&](int i) { return (longPasswords ? "Correct-Horse-Battery-Staple#" : "Pass#") + to_string(i); };
+        PasswordManager pm;
+        for (int i = 0; i < n; i++) pm.vault.add(names[i], encryptPassword(pm.vault.key, text(i)));
+
+        vector<string_view> records(lookups);
+        for (int k = 0; k < lookups; k++) records[k] = pm.vault.find(names[order[k]])->password;
+
+        bool opened = true;
+        string plain;
+        size_t sink = 0;
+        auto start = chrono::steady_clock::now();
+        for (string_view record : records)
+        {
+            opened = decryptPassword(pm.vault.key, record, plain) && opened;
+            sink += plain.size();
+        }
+        double openSeconds = secondsSince(start);
+
+        start = chrono::steady_clock::now();
+        for (string_view record : records)
+        {
+            opened = pm.revealPassword(record, plain) && opened;
+            sink += plain.size();
+        }
+        double cachedSeconds = secondsSince(start);
+        double hitRate = static_cast<double>(pm.plaintexts.hits) / max<uint64_t>(1, pm.plaintexts.hits + pm.plaintexts.misses);
+
+        long long wrong = 0;
+        for (int i = 0; i < n; i += max(1, n / 100000))
+        {
+            pm.revealPassword(pm.vault.find(names[i])->password, plain);
+            wrong += plain != text(i);
+        }
+        size_t cached = pm.plaintexts.size();
+        for (VaultIterator it = pm.vault.begin(); it.hasNext(); ) pm.revealPassword(it.next()->password, plain, false);
+        bool bounded = cached <= PLAINTEXT_CACHE_ENTRIES && pm.plaintexts.size() == cached;
+        wipeString(plain);
+
+        pm.plaintexts.ttl = chrono::milliseconds(20);
+        this_thread::sleep_for(chrono::milliseconds(40));
+        pm.plaintexts.expire();
+        bool expired = pm.plaintexts.size() == 0;
+        pm.revealPassword(pm.vault.find(names[0])->password, plain);
+        pm.clearAllPasswords();
+        bool wiped = pm.plaintexts.size() == 0 && pm.plaintexts.entries.empty();
+
+        bool pass = opened && wrong == 0 && bounded && expired && wiped && sink > 0;
+        ok = ok && pass;
+        cout << "plaincache passwords=" << (longPasswords ? "long" : "short")
+             << " n=" << n << " lookups=" << lookups << " hot=" << hot
+             << " open_ns_per_op=" << openSeconds * 1e9 / lookups
+             << " cached_ns_per_op=" << cachedSeconds * 1e9 / lookups
+             << " hit_rate=" << hitRate
+             << " cached=" << cached
+             << " speedup=" << openSeconds / max(cachedSeconds, 1e-9)
+             << (pass ? " PASS" : " FAIL") << "\n";
+    }
+    return ok;
+}
+
+// Generates n passwords under a default, a strict (every class in 4 characters)
+// and a long policy, on one thread and on one per core, checking that every
+// one meets its policy and that none repeats; before that, checks the mapping
+// of random bits onto an alphabet for bias (chi-square over 10M draws).
+bool benchGenerate(int n)
+{
+    bool ok = true;
+    {
+        SecureRandom rng;
+        const uint32_t size = 89;
+        const int draws = 10000000;
+        vector<long long> counts(size, 0);
+        for (int i = 0; i < draws; i++) counts[rng.below(size)]++;
+        double expected = static_cast<double>(draws) / size;
+        double chi = 0;
+        for (long long c : counts) chi += (c - expected) * (c - expected) / expected;
+        bool pass = chi < 150;  // 88 degrees of freedom: p < 1e-4 above this
+        ok = ok && pass;
+        cout << "generate draws=" << draws << " alphabet=" << size << " chi_square=" << chi << (pass ? " PASS" : " FAIL") << "\n";
+    }
+
+    PasswordPolicy strict;
+    strict.length = 4;
+    PasswordPolicy longer;
+    longer.length = 64;
+    longer.excludeLookalikes = false;
+    const pair<const char*, PasswordPolicy> policies[] = { { "default", PasswordPolicy() }, { "strict", strict }, { "long", longer } };
+
+    vector<unsigned> threadCounts = { 1 };
+    unsigned cores = max(1u, thread::hardware_concurrency());
+    if (cores > 1) threadCounts.push_back(cores);
+    vector<string> passwords(n);
+    vector<string*> pointers(n);
+    for (int i = 0; i < n; i++) pointers[i] = &passwords[i];
+    for (auto& policy : policies)
+    {
+        PasswordGenerator generator(policy.second);
+        for (unsigned threads : threadCounts)
+        {
+            auto start = chrono::steady_clock::now();
+            generatePasswords(policy.second, pointers.data(), n, threads);
+            double seconds = secondsSince(start);
+
+            long long bad = 0;
+            long long sample = 0;
+            for (const string& password : passwords)
+            {
+                // Policies of GENERATED_LENGTH or more must also pass the strength
+                // estimate at add time (checked on every 64th: it costs microseconds)
+                if (generator.length >= GENERATED_LENGTH && sample++ % 64 == 0) bad += easyToGuess(password);
+                int classes = 0;
+                for (int k = 0; k < generator.classCount; k++)
+                {
+                    classes += password.find_first_of(generator.classes[k]) != string::npos;
+                }
+                bad += static_cast<int>(password.size()) != generator.length || classes != generator.classCount
+                    || password.find_first_not_of(generator.alphabet) != string::npos
+                    || (policy.second.excludeLookalikes && password.find_first_of(LOOKALIKE_CHARS) != string::npos)
+                    || !hasStrengthClasses(password);
+            }
+            // A strict policy allows only ~38M passwords, so repeats are expected there
+            long long repeats = 0;
+            if (generator.length >= 12)
+            {
+                unordered_set<string_view> seen(passwords.begin(), passwords.end());
+                repeats = n - static_cast<long long>(seen.size());
+            }
+            bool pass = bad == 0 && repeats == 0;
+            ok = ok && pass;
+            cout << "generate policy=" << policy.first << " length=" << generator.length
+                 << " alphabet=" << generator.alphabet.size()
+                 << " n=" << n << " threads=" << threads
+                 << " passwords_per_sec=" << static_cast<long long>(n / max(seconds, 1e-9))
+                 << " ns_per_password=" << seconds * 1e9 / n
+                 << " bad=" << bad << " repeats=" << repeats
+                 << (pass ? " PASS" : " FAIL") << "\n";
+        }
+    }
+    for (string& password : passwords) wipeString(password);
+    return ok;
+}
+
+// Checks the estimator against passwords whose verdict is known (common
+// passwords, walks, runs, dates and words must score low; random generated ones
+// must score 4) and that every dictionary word is found, then times n estimates
+// over a mix of human-chosen and generated passwords.
+bool benchStrength(int n)
+{
+    bool ok = true;
+    int found = 0;
+    int words = 0;
+    for (size_t i = 0; DICTIONARY_WORDS[i]; )
+    {
+        size_t start = i;
+        while (DICTIONARY_WORDS[i] && DICTIONARY_WORDS[i] != ' ') i++;
+        size_t length = i - start;
+        if (DICTIONARY_WORDS[i]) i++;
+        if (length < DICTIONARY_MIN_WORD || length > DICTIONARY_MAX_WORD) continue;
+        words++;
+        found += dictionaryRank(DICTIONARY_WORDS + start, length, dictionaryHash(DICTIONARY_WORDS + start, length)) != 0;
+    }
+    bool tablePass = found == words && words == static_cast<int>(DICTIONARY.words);
+    ok = ok && tablePass;
+    cout << "strength dictionary_words=" << words << " slots=" << DICTIONARY_SLOTS
+         << " table_bytes=" << sizeof(DICTIONARY) << " found=" << found << (tablePass ? " PASS" : " FAIL") << "\n";
+
+    const pair<const char*, int> known[] = {
+        { "password", 0 }, { "Password1!", 1 }, { "P@ssw0rd", 1 }, { "qwerty123", 1 }, { "qwertyuiop", 1 },
+        { "1qaz2wsx", 1 }, { "abcdefgh", 1 }, { "aaaaaaaaaa", 1 }, { "abcabcabc", 1 }, { "13/05/1994", 2 },
+        { "19940513", 2 }, { "drowssap", 1 }, { "Tr0ub4dor&3", 4 }, { "correcthorsebatterystaple", 4 },
+    };
+    for (auto& entry : known)
+    {
+        StrengthEstimate estimate = estimateStrength(entry.first);
+        // Human-chosen passwords must score at most their bound; the last two at least theirs
+        bool pass = entry.second == 4 ? estimate.score >= 3 : estimate.score <= entry.second;
+        ok = ok && pass;
+        cout << "strength password=\"" << entry.first << "\" score=" << estimate.score
+             << " log10_guesses=" << estimate.log10Guesses << " via=\"" << estimate.weakness << "\""
+             << (pass ? " PASS" : " FAIL") << "\n";
+    }
+
+    PasswordPolicy policy;
+    vector<string> generated(1024);
+    vector<string*> pointers(generated.size());
+    for (size_t i = 0; i < generated.size(); i++) pointers[i] = &generated[i];
+    generatePasswords(policy, pointers.data(), generated.size());
+    int randomWeak = 0;
+    for (const string& password : generated) randomWeak += estimateStrength(password).score < 4;
+    bool randomPass = randomWeak == 0;
+    ok = ok && randomPass;
+    cout << "strength generated=" << generated.size() << " length=" << policy.length
+         << " below_score_4=" << randomWeak << (randomPass ? " PASS" : " FAIL") << "\n";
+
+    vector<string> mix;
+    for (auto& entry : known) mix.push_back(entry.first);
+    for (int i = 0; static_cast<int>(mix.size()) < 64; i++) mix.push_back(generated[i]);
+    long long total = 0;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < n; i++) total += estimateStrength(mix[i & 63]).score;
+    double seconds = secondsSince(start);
+    cout << "strength n=" << n << " estimates_per_sec=" << static_cast<long long>(n / max(seconds, 1e-9))
+         << " us_per_estimate=" << seconds * 1e6 / n << " score_sum=" << total << "\n";
+    for (string& password : generated) wipeString(password);
+    return ok;
+}
+
+// Simulates a password guesser against an AttemptTracker on a virtual clock.
+// First the streaks and window counts are checked against a brute-force model
+// (every failure time kept) over random failures and successes of 64 users;
+// then one attacker tries a password every millisecond for an hour against one
+// of 50,000 users that also fail now and then, and the check and failure costs
+// are timed; then n distinct identities are sprayed to show memory stays at
+// the tracker's capacity.
+bool benchAttempts(int n)
+{
+    bool ok = true;
+    typedef chrono::steady_clock::time_point Time;
+    const Time epoch;
+    {
+        AttemptTracker tracker;
+        const int users = 64;
+        vector<vector<Time>> failures(users);
+        vector<uint32_t> streaks(users, 0);
+        vector<Time> lockedUntil(users, epoch);
+        mt19937 rng(23);
+        long long mismatches = 0;
+        Time now = epoch;
+        for (int step = 0; step < 400000; step++)
+        {
+            now += chrono::milliseconds(rng() % 400);
+            int u = rng() % users;
+            string identity = "user" + to_string(u) + "@example.com";
+            int64_t bucket = AttemptTracker::bucketOf(now);
+            uint32_t recent = 0;
+            for (Time t : failures[u]) recent += AttemptTracker::bucketOf(t) > bucket - ATTEMPT_BUCKETS;
+            if (rng() % 8 == 0)
+            {
+                AttemptStatus status = tracker.check(identity, now);
+                mismatches += status.streak != streaks[u] || status.recent != recent || status.locked != (lockedUntil[u] > now);
+                tracker.succeed(identity);
+                failures[u].clear();
+                streaks[u] = 0;
+                lockedUntil[u] = epoch;
+            }
+            else
+            {
+                AttemptStatus status = tracker.fail(identity, now);
+                failures[u].push_back(now);
+                streaks[u]++;
+                recent++;
+                if (streaks[u] >= ATTEMPT_FREE_FAILURES)
+                {
+                    long long delay = ATTEMPT_FIRST_LOCK_SECONDS;
+                    for (uint32_t k = ATTEMPT_FREE_FAILURES; k < streaks[u] && delay < ATTEMPT_MAX_LOCK_SECONDS; k++) delay *= 2;
+                    lockedUntil[u] = max(lockedUntil[u], now + chrono::seconds(min<long long>(delay, ATTEMPT_MAX_LOCK_SECONDS)));
+                }
+                if (recent >= ATTEMPT_WINDOW_LIMIT) lockedUntil[u] = max(lockedUntil[u], now + chrono::seconds(ATTEMPT_WINDOW_SECONDS));
+                mismatches += status.streak != streaks[u] || status.recent != recent || status.locked != (lockedUntil[u] > now)
+                    || status.retryAfter != (status.locked ? lockedUntil[u] - now : chrono::steady_clock::duration(0));
+            }
+        }
+        bool pass = mismatches == 0;
+        ok = ok && pass;
+        cout << "attempts model steps=400000 users=" << users << " mismatches=" << mismatches << (pass ? " PASS" : " FAIL") << "\n";
+    }
+
+    {
+        // Lock lengths double from the first lock and stop at the cap; each
+        // failure comes as the previous lock ends
+        AttemptTracker tracker;
+        bool pass = true;
+        Time now = epoch;
+        for (int failure = 1; failure <= 40; failure++)
+        {
+            AttemptStatus status = tracker.fail("victim@example.com", now);
+            long long want = 0;
+            if (failure >= ATTEMPT_FREE_FAILURES)
+            {
+                want = min<long long>(static_cast<long long>(ATTEMPT_FIRST_LOCK_SECONDS) << min(failure - ATTEMPT_FREE_FAILURES, 30),
+                    ATTEMPT_MAX_LOCK_SECONDS);
+            }
+            pass = pass && status.locked == (want > 0) && status.retrySeconds() == want && status.streak == static_cast<uint32_t>(failure);
+            now += max(status.retryAfter, chrono::steady_clock::duration(chrono::seconds(1)));
+            pass = pass && !tracker.check("victim@example.com", now).locked;
+        }
+        ok = ok && pass;
+        cout << "attempts backoff first=" << ATTEMPT_FIRST_LOCK_SECONDS << "s max=" << ATTEMPT_MAX_LOCK_SECONDS << "s" << (pass ? " PASS" : " FAIL") << "\n";
+    }
+
+    {
+        // Brute force: one guess per ms whenever the target is not locked
+        AttemptTracker tracker;
+        const int users = 50000;
+        vector<string> identities(users);
+        for (int u = 0; u < users; u++) identities[u] = "user" + to_string(u) + "@example.com";
+        mt19937 rng(29);
+        const long long steps = 3600LL * 1000;
+        long long guesses = 0;
+        long long checks = 0;
+        long long failures = 0;
+        auto start = chrono::steady_clock::now();
+        for (long long step = 0; step < steps; step++)
+        {
+            Time now = epoch + chrono::milliseconds(step);
+            checks++;
+            if (!tracker.check(identities[0], now).locked)
+            {
+                tracker.fail(identities[0], now);
+                guesses++;
+                failures++;
+            }
+            // Everyone else mistypes now and then, and gets it right after
+            if ((step & 15) == 0)
+            {
+                const string& other = identities[1 + rng() % (users - 1)];
+                if (rng() % 4)
+                {
+                    tracker.fail(other, now);
+                    failures++;
+                }
+                else
+                {
+                    tracker.succeed(other);
+                }
+                checks++;
+            }
+        }
+        double seconds = secondsSince(start);
+        size_t tracked = tracker.size();
+        bool pass = guesses < 50 && tracked <= ATTEMPT_TRACKER_ENTRIES;
+        ok = ok && pass;
+        cout << "attempts bruteforce simulated_seconds=3600 users=" << users << " unthrottled_guesses=" << steps
+             << " guesses=" << guesses << " tracked=" << tracked
+             << " ns_per_op=" << seconds * 1e9 / (checks + failures)
+             << " ops_per_sec=" << static_cast<long long>((checks + failures) / max(seconds, 1e-9))
+             << (pass ? " PASS" : " FAIL") << "\n";
+    }
+
+    {
+        // Spray: n distinct identities in a burst, then on the same thread count per core
+        unsigned cores = max(1u, thread::hardware_concurrency());
+        vector<string> identities(n);
+        for (int i = 0; i < n; i++) identities[i] = "spray" + to_string(i) + "@example.com";
+        AttemptTracker tracker;
+        Time now = epoch;
+        auto start = chrono::steady_clock::now();
+        parallelFor((n + 4095) / 4096, cores, [&](size_t chunk)
+        {
+            size_t end = min<size_t>(n, (chunk + 1) * 4096);
+            for (size_t i = chunk * 4096; i < end; i++) tracker.fail(identities[i], now);
+        });
+        double seconds = secondsSince(start);
+        size_t tracked = tracker.size();
+        size_t bytes = tracker.entries.capacity() * sizeof(AttemptTracker::Entry)
+            + tracker.index.bucket_count() * sizeof(void*) + tracked * (sizeof(pair<string_view, uint32_t>) + 2 * sizeof(void*));
+        bool pass = tracked == min<size_t>(n, ATTEMPT_TRACKER_ENTRIES) && tracker.entries.size() <= ATTEMPT_TRACKER_ENTRIES;
+        ok = ok && pass;
+        cout << "attempts spray n=" << n << " threads=" << cores << " tracked=" << tracked << " capacity=" << ATTEMPT_TRACKER_ENTRIES
+             << " evicted_locked=" << tracker.evictions << " approx_bytes=" << bytes
+             << " ns_per_fail=" << seconds * 1e9 / max(n, 1)
+             << (pass ? " PASS" : " FAIL") << "\n";
+    }
+    return ok;
+}
+
+// "bench [name] [n]" where name is bst-sorted, import, layout, cipher, churn,
+// churn-legacy, alloc, history, journal, snapshot, batch, prefix, fuzzy, sessions,
+// readviews, audit, breach, plaincache, generate, strength, attempts, suite or all;
+// "suite" also takes a key shape (sorted, random, shared-prefix or all) next.
+// "check" is not part of all: it runs the checks whose verdicts do not depend
+// on timing (AVL height, allocation-free search, whole read-view scans) at
+// small sizes, for "make test".
+int runBenchmarks(int argc, char* argv[])
+{
+    string name = argc > 1 ? argv[1] : "all";
+    int n = 0;  // 0 = each benchmark's default size
+    if (argc > 2)
+    {
+        n = atoi(argv[2]);
+    }
+
+    bool ok = true;
+    if (name == "check")
+    {
+        ok = benchSortedInsert(n ? n : 100000) && ok;
+        ok = benchSearchAllocations(n ? n : 100000) && ok;
+        ok = benchReadViews(n ? n : 10000, false) && ok;
+    }
+    if (name == "all" || name == "bst-sorted") ok = benchSortedInsert(n ? n : 1000000) && ok;
+    if (name == "all" || name == "import") ok = benchBulkImport(n ? n : 1000000) && ok;
+    if (name == "all" || name == "layout")
+    {
+        if (n)
+        {
+            ok = benchLayout(n) && ok;
+        }
+        else
+        {
+            ok = benchLayout(10000) && benchLayout(1000000) && benchLayout(10000000) && ok;
+        }
+    }
+    if (name == "all" || name == "cipher") ok = benchCipher(n ? n : 1000000) && ok;
+    if (name == "all" || name == "churn") ok = benchChurn(n ? n : 1000000, false) && ok;
+    if (name == "churn-legacy") ok = benchChurn(n ? n : 1000000, true) && ok;
+    if (name == "all" || name == "alloc") ok = benchSearchAllocations(n ? n : 1000000) && ok;
+    if (name == "all" || name == "history") ok = benchHistory(n ? n : 100000) && ok;
+    if (name == "all" || name == "journal") ok = benchJournal(n ? n : 2000) && ok;
+    if (name == "all" || name == "snapshot") ok = benchSnapshot(n ? n : 1000000) && ok;
+    if (name == "all" || name == "batch") ok = benchBatch(n ? n : 200000) && ok;
+    if (name == "all" || name == "prefix") ok = benchPrefix(n ? n : 1000000) && ok;
+    if (name == "all" || name == "fuzzy") ok = benchFuzzy(n ? n : 1000000) && ok;
+    if (name == "all" || name == "sessions") ok = benchSessions(n ? n : 2000000) && ok;
+    if (name == "all" || name == "readviews") ok = benchReadViews(n ? n : 100000) && ok;
+    if (name == "all" || name == "audit") ok = benchAudit(n ? n : 10000000) && ok;
+    if (name == "all" || name == "breach") ok = benchBreach(n ? n : 5000000) && ok;
+    if (name == "all" || name == "plaincache") ok = benchPlaintextCache(n ? n : 1000000) && ok;
+    if (name == "all" || name == "generate") ok = benchGenerate(n ? n : 2000000) && ok;
+    if (name == "all" || name == "strength") ok = benchStrength(n ? n : 200000) && ok;
+    if (name == "all" || name == "attempts") ok = benchAttempts(n ? n : 1000000) && ok;
+    if (name == "all" || name == "suite") ok = benchSuite(n ? n : 100000, argc > 3 ? argv[3] : "all") && ok;
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+    return runBenchmarks(argc, argv);
+}
@@ -0,0 +1,244 @@
+// Load generator for the vault daemon ("main --serve <socket>").
+//
+//   make loadgen         (or: g++ -std=c++17 -O2 -o loadgen loadgen.cpp)
+//   loadgen <socket> [connections=4] [requests=200000] [depth=16] [accounts=10000] [edit%=10]
+//
+// Each connection signs in as its own memory-only user and stores `accounts`
+// accounts. Then all connections together send `requests` requests, each keeping
+// `depth` of them in flight (pipelined): searches of random stored accounts, and
+// edits for edit% of them. Prints ops/sec and the p50/p99/p99.9 latency from
+// sending a request to reading its response. Exits 1 if any request failed.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "vault_protocol.h"
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+// One client connection and its pipeline
+struct Connection
+{
+    int fd = -1;
+    string email;
+    string out;              // Requests not yet sent, from outStart on
+    size_t outStart = 0;
+    string in;               // Response bytes not yet parsed
+    int inFlight = 0;
+    long long next = 0;      // Requests built so far in this phase
+    long long quota = 0;     // Requests to send in this phase
+    mt19937 rng;
+};
+
+int connectTo(const string& path)
+{
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) return -1;
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+string accountName(long long i)
+{
+    return "account" + to_string(i);
+}
+
+// Drives every connection until each has sent its quota and read every answer.
+// build appends request number i of a connection with the given tag. Latencies
+// (nanoseconds) are collected when latencies is not null. Returns the number of
+// responses that were not Ok, or -1 if a connection failed.
+template <typename Build>
+long long runPhase(vector<Connection>& conns, int depth, Build build, vector<long long>* latencies)
+{
+    vector<Clock::time_point> sentAt;  // By tag
+    vector<pollfd> polls(conns.size());
+    long long errors = 0;
+
+    while (true)
+    {
+        bool busy = false;
+        for (size_t c = 0; c < conns.size(); c++)
+        {
+            Connection& conn = conns[c];
+            Clock::time_point now = Clock::now();
+            while (conn.inFlight < depth && conn.next < conn.quota)
+            {
+                uint32_t tag = static_cast<uint32_t>(sentAt.size());
+                sentAt.push_back(now);
+                build(conn, conn.next++, tag);
+                conn.inFlight++;
+            }
+            while (conn.outStart < conn.out.size())
+            {
+                ssize_t sent = send(conn.fd, conn.out.data() + conn.outStart, conn.out.size() - conn.outStart, MSG_NOSIGNAL);
+                if (sent <= 0) break;
+                conn.outStart += sent;
+            }
+            if (conn.outStart == conn.out.size())
+            {
+                conn.out.clear();
+                conn.outStart = 0;
+            }
+            polls[c].fd = conn.fd;
+            polls[c].events = POLLIN | (conn.out.empty() ? 0 : POLLOUT);
+            polls[c].revents = 0;
+            busy = busy || conn.inFlight > 0;
+        }
+        if (!busy) return errors;
+
+        if (poll(polls.data(), polls.size(), 10000) <= 0)
+        {
+            cerr << "No response from the daemon.\n";
+            return -1;
+        }
+        for (size_t c = 0; c < conns.size(); c++)
+        {
+            if (!(polls[c].revents & (POLLIN | POLLERR | POLLHUP))) continue;
+            Connection& conn = conns[c];
+            char buffer[64 * 1024];
+            ssize_t got = recv(conn.fd, buffer, sizeof(buffer), 0);
+            if (got <= 0)
+            {
+                cerr << "Daemon closed connection " << c << ".\n";
+                return -1;
+            }
+            conn.in.append(buffer, got);
+
+            Clock::time_point now = Clock::now();
+            size_t offset = 0;
+            while (true)
+            {
+                size_t size = protoFrameSize(conn.in.data() + offset, conn.in.size() - offset);
+                if (size == SIZE_MAX)
+                {
+                    cerr << "Malformed response on connection " << c << ".\n";
+                    return -1;
+                }
+                if (size == 0) break;
+                ProtoFrame frame(conn.in.data() + offset, size);
+                offset += size;
+                conn.inFlight--;
+                if (frame.code != static_cast<uint8_t>(ProtoStatus::Ok)) errors++;
+                if (latencies && frame.tag < sentAt.size())
+                {
+                    latencies->push_back(chrono::duration_cast<chrono::nanoseconds>(now - sentAt[frame.tag]).count());
+                }
+            }
+            conn.in.erase(0, offset);
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        cerr << "usage: loadgen <socket> [connections] [requests] [depth] [accounts] [edit%]\n";
+        return 2;
+    }
+    string path = argv[1];
+    int connections = argc > 2 ? max(1, atoi(argv[2])) : 4;
+    long long requests = argc > 3 ? max(1LL, atoll(argv[3])) : 200000;
+    int depth = argc > 4 ? max(1, atoi(argv[4])) : 16;
+    long long accounts = argc > 5 ? max(1LL, atoll(argv[5])) : 10000;
+    int editPercent = argc > 6 ? min(100, max(0, atoi(argv[6]))) : 10;
+
+    vector<Connection> conns(connections);
+    for (int c = 0; c < connections; c++)
+    {
+        conns[c].fd = connectTo(path);
+        if (conns[c].fd < 0)
+        {
+            cerr << "Could not connect to " << path << ".\n";
+            return 1;
+        }
+        conns[c].email = "loadgen" + to_string(getpid()) + "-" + to_string(c) + "@example.com";
+        conns[c].rng.seed(c + 1);
+    }
+
+    // Sign in and store the accounts (request 0 is the Open)
+    for (Connection& conn : conns)
+    {
+        conn.next = 0;
+        conn.quota = accounts + 1;
+    }
+    long long setupErrors = runPhase(conns, depth, [](Connection& conn, long long i, uint32_t tag)
+    {
+        size_t start;
+        if (i == 0)
+        {
+            start = protoBegin(conn.out, static_cast<uint8_t>(ProtoOp::Open), tag);
+            protoField(conn.out, conn.email);
+            protoField(conn.out, "loadgen-password");
+            protoField(conn.out, string(1, static_cast<char>(PROTO_OPEN_MEMORY_ONLY)));
+        }
+        else
+        {
+            start = protoBegin(conn.out, static_cast<uint8_t>(ProtoOp::Add), tag);
+            protoField(conn.out, accountName(i - 1));
+            protoField(conn.out, "Secret#" + to_string(i - 1));
+        }
+        protoEnd(conn.out, start);
+    }, nullptr);
+    if (setupErrors != 0)
+    {
+        cerr << "Setup failed (" << setupErrors << " errors).\n";
+        return 1;
+    }
+
+    // Measured mix of searches and edits
+    for (int c = 0; c < connections; c++)
+    {
+        conns[c].next = 0;
+        conns[c].quota = requests / connections + (c < requests % connections ? 1 : 0);
+    }
+    vector<long long> latencies;
+    latencies.reserve(requests);
+    Clock::time_point start = Clock::now();
+    long long errors = runPhase(conns, depth, [&](Connection& conn, long long i, uint32_t tag)
+    {
+        long long account = conn.rng() % accounts;
+        bool edit = static_cast<int>(conn.rng() % 100) < editPercent;
+        size_t frame = protoBegin(conn.out, static_cast<uint8_t>(edit ? ProtoOp::Edit : ProtoOp::Search), tag);
+        protoField(conn.out, accountName(account));
+        if (edit) protoField(conn.out, "Edited#" + to_string(i));
+        protoEnd(conn.out, frame);
+    }, &latencies);
+    double seconds = chrono::duration<double>(Clock::now() - start).count();
+    if (errors < 0) return 1;
+
+    for (Connection& conn : conns) close(conn.fd);
+
+    sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p)
+    {
+        if (latencies.empty()) return 0.0;
+        size_t index = min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()));
+        return latencies[index] / 1000.0;
+    };
+    printf("connections=%d depth=%d requests=%zu edit_percent=%d\n", connections, depth, latencies.size(), editPercent);
+    printf("ops_per_sec=%.0f p50_us=%.1f p99_us=%.1f p999_us=%.1f errors=%lld\n",
+           latencies.size() / seconds, percentile(0.50), percentile(0.99), percentile(0.999), errors);
+    printf("%s\n", errors == 0 ? "PASS" : "FAIL");
+    return errors == 0 ? 0 : 1;
+}
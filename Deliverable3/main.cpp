@@ -1,1060 +1,8312 @@
 #include <iostream>
 #include <string>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include <random>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <set>
+#include <string_view>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <shared_mutex>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <filesystem>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <csignal>
+#include <cerrno>
+#include <ctime>
+#endif
+#ifdef _WIN32
+#include <io.h>
+#endif
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include "vault_protocol.h"
 using namespace std;
 
 
+const uint8_t STRENGTH_UNKNOWN = 0xFF;  // PasswordNode::strength not estimated yet
+
+// One stored account; records live in the VaultStore slab and are addressed by slot
 struct PasswordNode
 {
-    string accountName;
-    string password;
-    PasswordNode* next;
+    string_view accountName;  // Bytes live in the vault's ByteArena
+    string_view password;     // Encrypted, also in the ByteArena
+    uint32_t slot;       // Own slot id in the RecordSlab
+    uint32_t nextFree;   // Next released slot while this one is free
+    uint32_t reusePrev;  // Neighbours among records sharing this password hash
+    uint32_t reuseNext;
+    bool inUse;
+    uint8_t strength;    // strengthScore of the password, so audits need not estimate
+                         // it again; memory only, never written to the vault files
 
-    PasswordNode(string acc, string pass) 
+    PasswordNode()
     {
-        accountName = acc;
-        password = pass;
-        next = nullptr;
+        slot = 0;
+        nextFree = 0;
+        reusePrev = 0;
+        reuseNext = 0;
+        inUse = false;
+        strength = STRENGTH_UNKNOWN;
     }
 };
 
-struct UserAuth 
+// ==================== RECORD ENCRYPTION ====================
+//
+// Stored passwords are sealed with AES-SIV (RFC 5297, AES-128). A record is a
+// 16-byte synthetic IV followed by the password encrypted in CTR mode under it.
+// The IV is an AES-CMAC of the password: it is the record's own nonce and also
+// its authentication tag, so a damaged record or a wrong key is detected when
+// it is opened. Equal passwords seal to equal records under one key, which the
+// reuse index, the snapshot's reuse table and the audit rely on. A record is
+// exactly 16 bytes longer than its password, so it also gives away the
+// password's length; beyond equality and length it tells nothing.
+//
+// The key pair comes from the user's email and master password through PBKDF2,
+// derived once per login and kept expanded in the VaultKey. Every AES call goes
+// through one kernel that encrypts a run of independent blocks: AES-NI keeps 8
+// of them in flight (its rounds have several cycles of latency), and a portable
+// version covers other CPUs. Batch calls seal or open records 8 at a time, so
+// their AES work lands in those runs, and spread big batches over threads.
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PM_HAS_X86_KERNELS 1
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PM_TARGET(isa) __attribute__((target(isa)))
+#else
+#define PM_TARGET(isa)
+#endif
+
+bool cpuHasAvx2()
 {
-    string email;
-    string password;
-    
-    UserAuth(string e, string p) 
-    {
-        email = e;
-        password = p;
-    }
-};
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER)
+    int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 7) return false;
+    __cpuid(regs, 1);
+    bool osSavesYmm = (regs[2] & (1 << 27)) && ((_xgetbv(0) & 6) == 6);
+    __cpuidex(regs, 7, 0);
+    return osSavesYmm && (regs[1] & (1 << 5));
+#else
+    return false;
+#endif
+}
 
-// Action represents a single change (for undo/redo)
-struct Action 
+bool cpuHasAesni()
 {
-    string actionType;      // "ADD", "EDIT", "DELETE"
-    string accountName;     
-    string oldPassword;     // For EDIT and DELETE
-    string newPassword;     // For ADD and EDIT
-};
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("aes");
+#elif defined(_MSC_VER)
+    int regs[4];
+    __cpuid(regs, 1);
+    return (regs[2] & (1 << 25)) != 0;
+#else
+    return false;
+#endif
+}
+#endif
 
-// Stack for Undo/Redo operations (array-based)
-struct ActionStack 
+// Runs body(item) for every item in [0, count) on up to threads threads. The
+// calling thread works too; returns once every item is done.
+template <typename Body>
+void parallelFor(size_t count, unsigned threads, Body body)
 {
-    Action actions[50];   
-    int top;
-    
-    void init() 
-    {
-        top = -1;
-    }
-    
-    void push(Action action) 
-    {
-        if (top < 49) 
-        {
-            actions[++top] = action;
-        } else 
-        {
-            cout << "⚠️ Undo history full!\n";
-        }
-    }
-    
-    Action pop() 
+    atomic<size_t> next(0);
+    auto worker = [&]()
     {
-        if (top >= 0) 
-        {
-            return actions[top--];
-        }
+        for (size_t item = next++; item < count; item = next++) body(item);
+    };
+    vector<thread> pool;
+    for (unsigned t = 1; t < threads && t < count; t++) pool.emplace_back(worker);
+    worker();
+    for (thread& t : pool) t.join();
+}
 
-        Action empty;
-        empty.actionType = "NONE";
-        return empty;
-    }
-    
-    bool isEmpty() 
+// Overwrite secrets; the volatile stores cannot be dropped as dead like memset
+void wipeBytes(void* p, size_t n)
+{
+    volatile unsigned char* bytes = static_cast<volatile unsigned char*>(p);
+    for (size_t i = 0; i < n; i++) bytes[i] = 0;
+}
+
+void wipeString(string& s)
+{
+    if (!s.empty()) wipeBytes(&s[0], s.size());
+    s.clear();
+}
+
+double secondsSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// ---- SHA-1 and PBKDF2 ----
+
+const int SHA1_BYTES = 20;
+
+struct Sha1Digest
+{
+    uint8_t bytes[SHA1_BYTES];
+
+    bool operator<(const Sha1Digest& other) const
     {
-        return top == -1;
+        return memcmp(bytes, other.bytes, SHA1_BYTES) < 0;
     }
-    
-    void clear() 
+
+    bool operator==(const Sha1Digest& other) const
     {
-        top = -1;
+        return memcmp(bytes, other.bytes, SHA1_BYTES) == 0;
     }
 };
 
-struct ViewAttempt
+inline uint32_t rotl32(uint32_t x, int b)
 {
-    bool success;
-};
-
-const int MAX_VIEW_HISTORY = 10;
+    return (x << b) | (x >> (32 - b));
+}
 
-struct ViewAttemptQueue
+// One 64-byte block of SHA-1 (FIPS 180-4)
+void sha1Block(uint32_t state[5], const unsigned char block[64])
 {
-    ViewAttempt buffer[MAX_VIEW_HISTORY];
-    int front;  // Points to the oldest item
-    int rear;   // Points to where next item will be inserted
-    int count;  // Number of items currently in queue
-
-    ViewAttemptQueue()
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++)
     {
-        front = 0;
-        rear = 0;
-        count = 0;
+        w[i] = static_cast<uint32_t>(block[4 * i]) << 24 | static_cast<uint32_t>(block[4 * i + 1]) << 16
+             | static_cast<uint32_t>(block[4 * i + 2]) << 8 | block[4 * i + 3];
+    }
+    for (int i = 16; i < 80; i++)
+    {
+        w[i] = rotl32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
     }
 
-    void enqueue(ViewAttempt attempt)
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+    for (int i = 0; i < 80; i++)
     {
-        // If queue is full, remove oldest item first (move front forward)
-        if (count == MAX_VIEW_HISTORY)
+        uint32_t f;
+        uint32_t k;
+        if (i < 20)
+        {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        }
+        else if (i < 40)
+        {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        }
+        else if (i < 60)
         {
-            front = (front + 1) % MAX_VIEW_HISTORY;
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
         }
         else
         {
-            count++;
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
         }
-        
-        // Add new item at rear
-        buffer[rear] = attempt;
-        rear = (rear + 1) % MAX_VIEW_HISTORY;
+        uint32_t t = rotl32(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = rotl32(b, 30);
+        b = a;
+        a = t;
     }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+}
 
-    bool getFromEnd(int reverseIndex, ViewAttempt& out) const
+const uint32_t SHA1_INIT[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+
+// Finish a SHA-1 whose state has already taken prefixBytes (a multiple of 64)
+// of input: hash the rest, data, and pad. Leaves state as it was.
+Sha1Digest sha1Finish(const uint32_t start[5], const unsigned char* data, size_t n, uint64_t prefixBytes)
+{
+    uint32_t state[5];
+    memcpy(state, start, sizeof(state));
+    uint64_t bits = (prefixBytes + n) * 8;
+    for (; n >= 64; data += 64, n -= 64)
     {
-        // reverseIndex 0 = most recent, 1 = second most recent, etc.
-        if (reverseIndex >= count || reverseIndex < 0)
-        {
-            return false;
-        }
-        
-        // Most recent item is at (rear - 1 + MAX) % MAX
-        // Go backwards: (rear - 1 - reverseIndex + MAX) % MAX
-        int mostRecentPos = (rear - 1 + MAX_VIEW_HISTORY) % MAX_VIEW_HISTORY;
-        int targetPos = (mostRecentPos - reverseIndex + MAX_VIEW_HISTORY) % MAX_VIEW_HISTORY;
-        
-        out = buffer[targetPos];
-        return true;
+        sha1Block(state, data);
     }
 
-    int size() const 
-    { 
-        return count;
+    // Padding: 0x80, zeros, then the length in bits (big-endian) ending a block
+    unsigned char tail[128] = { 0 };
+    if (n) memcpy(tail, data, n);
+    tail[n] = 0x80;
+    size_t tailSize = n < 56 ? 64 : 128;
+    for (int i = 0; i < 8; i++)
+    {
+        tail[tailSize - 1 - i] = static_cast<unsigned char>(bits >> (8 * i));
     }
-};
+    sha1Block(state, tail);
+    if (tailSize == 128) sha1Block(state, tail + 64);
+    wipeBytes(tail, sizeof(tail));  // It held the end of a password
 
-// BST Node that stores a pointer to PasswordNode
-struct BSTNode
-{
-    PasswordNode* passwordNodePtr;  // Pointer to the actual PasswordNode in linked list
-    BSTNode* left;
-    BSTNode* right;
-
-    BSTNode(PasswordNode* ptr)
+    Sha1Digest digest;
+    for (int i = 0; i < 5; i++)
     {
-        passwordNodePtr = ptr;
-        left = nullptr;
-        right = nullptr;
+        for (int j = 0; j < 4; j++) digest.bytes[4 * i + j] = static_cast<uint8_t>(state[i] >> (24 - 8 * j));
     }
-};
+    wipeBytes(state, sizeof(state));
+    return digest;
+}
 
-// Binary Search Tree structure for account names (stores pointers to PasswordNode)
-struct AccountBST
+// SHA-1 of data. Keys breach-list lookups and drives PBKDF2; nothing here relies
+// on SHA-1 being collision resistant.
+Sha1Digest sha1(string_view data)
 {
-    BSTNode* root;
+    return sha1Finish(SHA1_INIT, reinterpret_cast<const unsigned char*>(data.data()), data.size(), 0);
+}
 
-    // Constructor
-    AccountBST()
+// PBKDF2-HMAC-SHA1 (RFC 8018): outSize bytes from password and salt. Each
+// iteration is two SHA-1 blocks, starting from the precomputed inner and outer
+// HMAC states.
+void pbkdf2Sha1(string_view password, string_view salt, uint32_t iterations, uint8_t* out, size_t outSize)
+{
+    unsigned char pad[64] = { 0 };
+    if (password.size() > 64)
     {
-        root = nullptr;
+        Sha1Digest digest = sha1(password);
+        memcpy(pad, digest.bytes, SHA1_BYTES);
+    }
+    else
+    {
+        if (!password.empty()) memcpy(pad, password.data(), password.size());
     }
+    uint32_t inner[5];
+    uint32_t outer[5];
+    memcpy(inner, SHA1_INIT, sizeof(inner));
+    memcpy(outer, SHA1_INIT, sizeof(outer));
+    for (unsigned char& c : pad) c ^= 0x36;
+    sha1Block(inner, pad);
+    for (unsigned char& c : pad) c ^= 0x36 ^ 0x5c;
+    sha1Block(outer, pad);
+    wipeBytes(pad, sizeof(pad));
 
-    // Helper function for recursive insertion
-    BSTNode* insertHelper(BSTNode* node, PasswordNode* passwordNode)
+    string first(salt);
+    first.append(4, '\0');
+    for (uint32_t block = 1; outSize > 0; block++)
     {
-        // If tree is empty, create new node
-        if (node == nullptr)
+        for (int i = 0; i < 4; i++) first[salt.size() + i] = static_cast<char>(block >> (24 - 8 * i));
+        Sha1Digest u = sha1Finish(inner, reinterpret_cast<const unsigned char*>(first.data()), first.size(), 64);
+        u = sha1Finish(outer, u.bytes, SHA1_BYTES, 64);
+        Sha1Digest sum = u;
+        for (uint32_t i = 1; i < iterations; i++)
         {
-            return new BSTNode(passwordNode);
+            u = sha1Finish(inner, u.bytes, SHA1_BYTES, 64);
+            u = sha1Finish(outer, u.bytes, SHA1_BYTES, 64);
+            for (int b = 0; b < SHA1_BYTES; b++) sum.bytes[b] ^= u.bytes[b];
         }
+        size_t take = min<size_t>(outSize, SHA1_BYTES);
+        memcpy(out, sum.bytes, take);
+        out += take;
+        outSize -= take;
+        wipeBytes(&u, sizeof(u));
+        wipeBytes(&sum, sizeof(sum));
+    }
+    wipeBytes(inner, sizeof(inner));
+    wipeBytes(outer, sizeof(outer));
+}
 
-        // Compare based on account name from the PasswordNode
-        string accountName = passwordNode->accountName;
-        string nodeAccountName = node->passwordNodePtr->accountName;
+// ---- AES-128 ----
 
-        if (accountName < nodeAccountName)
-        {
-            // Insert in left subtree
-            node->left = insertHelper(node->left, passwordNode);
-        }
-        else if (accountName > nodeAccountName)
-        {
-            // Insert in right subtree
-            node->right = insertHelper(node->right, passwordNode);
-        }
-        // If accountName == nodeAccountName, do nothing (duplicate)
+const int AES_ROUNDS = 10;
+const size_t AES_BLOCK = 16;
 
-        return node;
-    }
+typedef uint8_t AesRoundKeys[AES_ROUNDS + 1][AES_BLOCK];
+
+const uint8_t AES_SBOX[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
+};
+
+inline uint8_t aesXtime(uint8_t x)
+{
+    return static_cast<uint8_t>((x << 1) ^ ((x >> 7) * 0x1b));
+}
 
-    // Insert pointer to PasswordNode into BST
-    void insert(PasswordNode* passwordNode)
+// FIPS-197 key schedule; AES-NI uses the same round keys
+void aesExpandKey(const uint8_t key[AES_BLOCK], AesRoundKeys rounds)
+{
+    memcpy(rounds[0], key, AES_BLOCK);
+    uint8_t rcon = 1;
+    for (int r = 1; r <= AES_ROUNDS; r++)
     {
-        root = insertHelper(root, passwordNode);
+        const uint8_t* prev = rounds[r - 1];
+        uint8_t* next = rounds[r];
+        next[0] = prev[0] ^ AES_SBOX[prev[13]] ^ rcon;
+        next[1] = prev[1] ^ AES_SBOX[prev[14]];
+        next[2] = prev[2] ^ AES_SBOX[prev[15]];
+        next[3] = prev[3] ^ AES_SBOX[prev[12]];
+        for (size_t i = 4; i < AES_BLOCK; i++) next[i] = prev[i] ^ next[i - 4];
+        rcon = aesXtime(rcon);
     }
+}
 
-    // Search for a PasswordNode by account name
-    PasswordNode* search(const string& accountName)
+// Encrypts blocks independent 16-byte blocks (ECB); in and out may be the same
+typedef void (*AesKernel)(const AesRoundKeys rounds, const uint8_t* in, uint8_t* out, size_t blocks);
+
+void aesKernelPortable(const AesRoundKeys rounds, const uint8_t* in, uint8_t* out, size_t blocks)
+{
+    uint8_t s[AES_BLOCK];
+    uint8_t t[AES_BLOCK];
+    for (size_t b = 0; b < blocks; b++)
     {
-        BSTNode* current = root;
-        while (current != nullptr)
+        for (size_t i = 0; i < AES_BLOCK; i++) s[i] = in[AES_BLOCK * b + i] ^ rounds[0][i];
+        for (int r = 1; r <= AES_ROUNDS; r++)
         {
-            string currentAccountName = current->passwordNodePtr->accountName;
-            if (accountName == currentAccountName)
+            // SubBytes and ShiftRows (the state is column-major: s[4 * column + row])
+            for (int c = 0; c < 4; c++)
             {
-                return current->passwordNodePtr;
+                for (int row = 0; row < 4; row++) t[4 * c + row] = AES_SBOX[s[4 * ((c + row) & 3) + row]];
             }
-            else if (accountName < currentAccountName)
+            if (r < AES_ROUNDS)
             {
-                current = current->left;
+                for (int c = 0; c < 4; c++)
+                {
+                    uint8_t* a = t + 4 * c;
+                    uint8_t all = a[0] ^ a[1] ^ a[2] ^ a[3];
+                    s[4 * c] = a[0] ^ all ^ aesXtime(a[0] ^ a[1]);
+                    s[4 * c + 1] = a[1] ^ all ^ aesXtime(a[1] ^ a[2]);
+                    s[4 * c + 2] = a[2] ^ all ^ aesXtime(a[2] ^ a[3]);
+                    s[4 * c + 3] = a[3] ^ all ^ aesXtime(a[3] ^ a[0]);
+                }
             }
             else
             {
-                current = current->right;
+                memcpy(s, t, AES_BLOCK);
             }
+            for (size_t i = 0; i < AES_BLOCK; i++) s[i] ^= rounds[r][i];
         }
-        return nullptr;
+        memcpy(out + AES_BLOCK * b, s, AES_BLOCK);
     }
+    wipeBytes(s, sizeof(s));
+    wipeBytes(t, sizeof(t));
+}
 
-    // Helper function to find and delete a node from BST
-    BSTNode* deleteHelper(BSTNode* node, PasswordNode* passwordNodeToDelete)
+#ifdef PM_HAS_X86_KERNELS
+PM_TARGET("aes,sse2")
+void aesKernelAesni(const AesRoundKeys rounds, const uint8_t* in, uint8_t* out, size_t blocks)
+{
+    __m128i k[AES_ROUNDS + 1];
+    for (int r = 0; r <= AES_ROUNDS; r++) k[r] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rounds[r]));
+    const __m128i* src = reinterpret_cast<const __m128i*>(in);
+    __m128i* dst = reinterpret_cast<__m128i*>(out);
+    size_t b = 0;
+    for (; b + 8 <= blocks; b += 8)
     {
-        if (node == nullptr) 
-        
-        
+        __m128i x0 = _mm_xor_si128(_mm_loadu_si128(src + b), k[0]);
+        __m128i x1 = _mm_xor_si128(_mm_loadu_si128(src + b + 1), k[0]);
+        __m128i x2 = _mm_xor_si128(_mm_loadu_si128(src + b + 2), k[0]);
+        __m128i x3 = _mm_xor_si128(_mm_loadu_si128(src + b + 3), k[0]);
+        __m128i x4 = _mm_xor_si128(_mm_loadu_si128(src + b + 4), k[0]);
+        __m128i x5 = _mm_xor_si128(_mm_loadu_si128(src + b + 5), k[0]);
+        __m128i x6 = _mm_xor_si128(_mm_loadu_si128(src + b + 6), k[0]);
+        __m128i x7 = _mm_xor_si128(_mm_loadu_si128(src + b + 7), k[0]);
+        for (int r = 1; r < AES_ROUNDS; r++)
         {
-            return nullptr;
+            x0 = _mm_aesenc_si128(x0, k[r]);
+            x1 = _mm_aesenc_si128(x1, k[r]);
+            x2 = _mm_aesenc_si128(x2, k[r]);
+            x3 = _mm_aesenc_si128(x3, k[r]);
+            x4 = _mm_aesenc_si128(x4, k[r]);
+            x5 = _mm_aesenc_si128(x5, k[r]);
+            x6 = _mm_aesenc_si128(x6, k[r]);
+            x7 = _mm_aesenc_si128(x7, k[r]);
         }
+        _mm_storeu_si128(dst + b, _mm_aesenclast_si128(x0, k[AES_ROUNDS]));
+        _mm_storeu_si128(dst + b + 1, _mm_aesenclast_si128(x1, k[AES_ROUNDS]));
+        _mm_storeu_si128(dst + b + 2, _mm_aesenclast_si128(x2, k[AES_ROUNDS]));
+        _mm_storeu_si128(dst + b + 3, _mm_aesenclast_si128(x3, k[AES_ROUNDS]));
+        _mm_storeu_si128(dst + b + 4, _mm_aesenclast_si128(x4, k[AES_ROUNDS]));
+        _mm_storeu_si128(dst + b + 5, _mm_aesenclast_si128(x5, k[AES_ROUNDS]));
+        _mm_storeu_si128(dst + b + 6, _mm_aesenclast_si128(x6, k[AES_ROUNDS]));
+        _mm_storeu_si128(dst + b + 7, _mm_aesenclast_si128(x7, k[AES_ROUNDS]));
+    }
+    for (; b < blocks; b++)
+    {
+        __m128i x = _mm_xor_si128(_mm_loadu_si128(src + b), k[0]);
+        for (int r = 1; r < AES_ROUNDS; r++) x = _mm_aesenc_si128(x, k[r]);
+        _mm_storeu_si128(dst + b, _mm_aesenclast_si128(x, k[AES_ROUNDS]));
+    }
+}
+#endif
 
-        string accountName = passwordNodeToDelete->accountName;
-        string nodeAccountName = node->passwordNodePtr->accountName;
+// Fastest AES kernel this CPU can run
+AesKernel pickAesKernel(const char** name)
+{
+#ifdef PM_HAS_X86_KERNELS
+    if (cpuHasAesni())
+    {
+        *name = "aesni";
+        return aesKernelAesni;
+    }
+#endif
+    *name = "portable";
+    return aesKernelPortable;
+}
 
-        if (accountName < nodeAccountName)
-        {
-            node->left = deleteHelper(node->left, passwordNodeToDelete);
-        }
-        else if (accountName > nodeAccountName)
-        {
-            node->right = deleteHelper(node->right, passwordNodeToDelete);
-        }
-        else
-        {
-            // Found the node to delete
-            // Check if it's the exact same PasswordNode pointer
-            if (node->passwordNodePtr == passwordNodeToDelete)
-            {
-                // Case 1: No children
-                if (node->right == nullptr && node->left == nullptr)
-                {
-                    delete node;
-                    return nullptr;
-                }
-                // Case 2: One child - only left child exists
-                else if (node->right == nullptr)
-                {
-                    BSTNode* temp = node->left;
-                    delete node;
-                    return temp;
-                }
+const char* aesKernelName = "";
+const AesKernel aesKernel = pickAesKernel(&aesKernelName);
 
-                else if (node->left == nullptr)
-                {
-                    BSTNode* temp = node->right;
-                    delete node;
-                    return temp;
-                }
-                // Case 4: Two children - get inorder successor (smallest in right subtree)
-                else
-                {
-                    BSTNode* temp = node->right;
-                    while (temp->left != nullptr)
-                    {
-                        temp = temp->left;
-                    }
+// ---- AES-SIV records ----
 
-                    // Copy the pointer (not the data)
-                    node->passwordNodePtr = temp->passwordNodePtr;
-                    
-                    // Delete the inorder successor
-                    node->right = deleteHelper(node->right, temp->passwordNodePtr);
-                }
-            }
-        }
-        return node;
-    }
+const size_t SIV_BYTES = 16;          // Synthetic IV at the front of every record
+const size_t VAULT_KEY_BYTES = 32;    // MAC key (S2V) then CTR key
+const size_t VAULT_SALT_BYTES = 16;   // Random PBKDF2 salt of a vault, kept in its file headers
+const size_t SIV_LANES = 8;           // Records whose AES calls are interleaved
+const size_t CIPHER_GRAIN = 4096;     // Records per work item of a batch call
+const uint32_t VAULT_KEY_ITERATIONS = 100000;  // PBKDF2 iterations per login
 
-    // Delete a PasswordNode pointer from BST
-    void remove(PasswordNode* passwordNode)
-    {
-        root = deleteHelper(root, passwordNode);
-    }
+// Doubling in GF(2^128) as CMAC and S2V define it
+void sivDouble(uint8_t block[AES_BLOCK])
+{
+    uint8_t carry = block[0] >> 7;
+    for (size_t i = 0; i + 1 < AES_BLOCK; i++) block[i] = static_cast<uint8_t>(block[i] << 1 | block[i + 1] >> 7);
+    block[AES_BLOCK - 1] = static_cast<uint8_t>(block[AES_BLOCK - 1] << 1) ^ (carry * 0x87);
+}
+
+inline void xorBlock(uint8_t* out, const uint8_t* a, const uint8_t* b)
+{
+    for (size_t i = 0; i < AES_BLOCK; i++) out[i] = a[i] ^ b[i];
+}
+
+// A user's record key, expanded once at login (wiped when it goes away). A
+// default-constructed key is random, and so is its salt: a memory-only vault
+// that never signs in still seals its records, and a new vault keeps the salt.
+struct VaultKey
+{
+    uint8_t salt[VAULT_SALT_BYTES];     // What deriveVaultKey salts PBKDF2 with
+    AesRoundKeys macRounds;             // S2V / CMAC key
+    AesRoundKeys ctrRounds;             // CTR key
+    uint8_t cmacComplete[AES_BLOCK];    // CMAC subkey for a complete last block
+    uint8_t cmacPadded[AES_BLOCK];      // CMAC subkey for a padded last block
+    uint8_t s2vStart[AES_BLOCK];        // CMAC of the zero block, where S2V starts
+    uint8_t fullMask[AES_BLOCK];        // What a 16-byte password is XORed with before its one CMAC block
+    uint8_t shortMask[AES_BLOCK];       // The same for a padded, shorter one
 
-    // Helper function for in-order traversal to collect pointers
-    void inOrderCollect(BSTNode* node, PasswordNode* nodes[], int& index, int maxSize)
+    VaultKey()
     {
-        if (node != nullptr && index < maxSize)
+        uint8_t material[VAULT_KEY_BYTES];
+        random_device rd;
+        for (size_t i = 0; i < VAULT_KEY_BYTES; i += 4)
         {
-            inOrderCollect(node->left, nodes, index, maxSize);
-            if (index < maxSize)
-            {
-                nodes[index++] = node->passwordNodePtr;
-            }
-            inOrderCollect(node->right, nodes, index, maxSize);
+            uint32_t r = rd();
+            memcpy(material + i, &r, 4);
+        }
+        set(material);
+        wipeBytes(material, sizeof(material));
+        for (size_t i = 0; i < VAULT_SALT_BYTES; i += 4)
+        {
+            uint32_t r = rd();
+            memcpy(salt + i, &r, 4);
         }
     }
 
-    // Get all PasswordNode pointers in sorted order (returns count)
-    int getAllNodes(PasswordNode* nodes[], int maxSize)
+    ~VaultKey()
     {
-        int count = 0;
-        inOrderCollect(root, nodes, count, maxSize);
-        return count;
+        wipeBytes(this, sizeof(*this));
     }
 
-    // Check if BST is empty
-    bool isEmpty()
+    void set(const uint8_t material[VAULT_KEY_BYTES])
     {
-        return root == nullptr;
+        aesExpandKey(material, macRounds);
+        aesExpandKey(material + AES_BLOCK, ctrRounds);
+        uint8_t zero[AES_BLOCK] = { 0 };
+        aesKernel(macRounds, zero, cmacComplete, 1);
+        sivDouble(cmacComplete);
+        memcpy(cmacPadded, cmacComplete, AES_BLOCK);
+        sivDouble(cmacPadded);
+
+        // s2vStart = CMAC(zero block) = AES(zero ^ cmacComplete); a password
+        // shorter than a block is padded and XORed with dbl(s2vStart), a whole
+        // block with s2vStart, and either ends a one-block CMAC
+        aesKernel(macRounds, cmacComplete, s2vStart, 1);
+        xorBlock(fullMask, s2vStart, cmacComplete);
+        memcpy(shortMask, s2vStart, AES_BLOCK);
+        sivDouble(shortMask);
+        xorBlock(shortMask, shortMask, cmacComplete);
     }
 };
 
-// ==================== GLOBAL VARIABLES ====================
-
-UserAuth* currentUser = nullptr;
-ViewAttemptQueue viewAttempts;
-ActionStack undoStack;
-ActionStack redoStack;
-
-// ==================== HELPER FUNCTIONS ====================
-
-void recordViewAttempt(bool success)
-{
-    viewAttempts.enqueue({ success });
-}
-
-bool lastKViewAttemptsFailed(int k)
+// AES-CMAC (RFC 4493) of n bytes under the key's MAC half
+void sivCmac(const VaultKey& key, const uint8_t* data, size_t n, uint8_t mac[AES_BLOCK])
 {
-    if (viewAttempts.size() < k) return false;
-    int failed = 0;
-    for (int i = 0; i < k; ++i)
+    uint8_t x[AES_BLOCK] = { 0 };
+    size_t before = n == 0 ? 0 : (n - 1) / AES_BLOCK;  // Blocks before the last
+    for (size_t b = 0; b < before; b++)
     {
-        ViewAttempt a;
-        if (viewAttempts.getFromEnd(i, a))
-        {
-            if (!a.success) ++failed;
-        }
+        xorBlock(x, x, data + AES_BLOCK * b);
+        aesKernel(key.macRounds, x, x, 1);
+    }
+    size_t last = n - AES_BLOCK * before;
+    uint8_t block[AES_BLOCK] = { 0 };
+    if (last) memcpy(block, data + AES_BLOCK * before, last);
+    if (last == AES_BLOCK)
+    {
+        xorBlock(block, block, key.cmacComplete);
     }
-    return failed == k;
+    else
+    {
+        block[last] = 0x80;
+        xorBlock(block, block, key.cmacPadded);
+    }
+    xorBlock(x, x, block);
+    aesKernel(key.macRounds, x, mac, 1);
+    wipeBytes(x, sizeof(x));
+    wipeBytes(block, sizeof(block));
 }
 
-string xorCipher(const string& data, const string& key)
+// S2V (RFC 5297) of an optional associated-data string and the plaintext: the
+// synthetic IV. Vault records have no associated data (it would make equal
+// passwords seal differently); it is here for the RFC's test vectors.
+void sivS2V(const VaultKey& key, const string_view* associated, const uint8_t* plain, size_t n, uint8_t iv[AES_BLOCK])
 {
-    if (key.empty()) 
+    uint8_t d[AES_BLOCK];
+    memcpy(d, key.s2vStart, AES_BLOCK);
+    if (associated)
     {
-        return data;
+        uint8_t mac[AES_BLOCK];
+        sivCmac(key, reinterpret_cast<const uint8_t*>(associated->data()), associated->size(), mac);
+        sivDouble(d);
+        xorBlock(d, d, mac);
     }
-
-    string out = data;
-    for (size_t i = 0; i < data.size(); ++i)
+    if (n >= AES_BLOCK)
     {
-        out[i] = static_cast<char>(data[i] ^ key[i % key.size()]);
+        vector<uint8_t> t(plain, plain + n);
+        xorBlock(&t[n - AES_BLOCK], &t[n - AES_BLOCK], d);
+        sivCmac(key, t.data(), n, iv);
+        wipeBytes(t.data(), n);
+    }
+    else
+    {
+        uint8_t t[AES_BLOCK] = { 0 };
+        if (n) memcpy(t, plain, n);
+        t[n] = 0x80;
+        sivDouble(d);
+        xorBlock(t, t, d);
+        sivCmac(key, t, AES_BLOCK, iv);
+        wipeBytes(t, sizeof(t));
     }
-    return out;
 }
 
-string encryptPassword(const string& password)
+// Counter block number index of the record with this IV (RFC 5297 clears two
+// bits so the counter can be added to 32- and 64-bit words without carries)
+inline void sivCounter(const uint8_t* iv, uint32_t index, uint8_t counter[AES_BLOCK])
 {
-    const string key = "X0rKey!2025";
-    return xorCipher(password, key);
+    memcpy(counter, iv, AES_BLOCK);
+    counter[8] &= 0x7f;
+    counter[12] &= 0x7f;
+    uint32_t low = (static_cast<uint32_t>(counter[12]) << 24 | counter[13] << 16 | counter[14] << 8 | counter[15]) + index;
+    for (int i = 0; i < 4; i++) counter[12 + i] = static_cast<uint8_t>(low >> (24 - 8 * i));
 }
 
-string decryptPassword(const string& encryptedPassword)
+// Key stream blocks [first, first + blocks) of the record with this IV
+void sivKeystream(const VaultKey& key, const uint8_t* iv, uint32_t first, size_t blocks, uint8_t* out)
 {
-    const string key = "X0rKey!2025";
-    return xorCipher(encryptedPassword, key);
+    for (size_t b = 0; b < blocks; b++) sivCounter(iv, first + static_cast<uint32_t>(b), out + AES_BLOCK * b);
+    aesKernel(key.ctrRounds, out, out, blocks);
 }
 
-bool isValidEmail(const string& email) 
+// out = in XOR the record's key stream (CTR both ways)
+void sivCtr(const VaultKey& key, const uint8_t* iv, const uint8_t* in, uint8_t* out, size_t n)
 {
-    if (email.empty()) 
+    uint8_t stream[4 * AES_BLOCK];
+    for (size_t i = 0; i < n; i += sizeof(stream))
     {
-        return false;
+        size_t chunk = min(sizeof(stream), n - i);
+        sivKeystream(key, iv, static_cast<uint32_t>(i / AES_BLOCK), (chunk + AES_BLOCK - 1) / AES_BLOCK, stream);
+        for (size_t j = 0; j < chunk; j++) out[i + j] = in[i + j] ^ stream[j];
     }
-    
-    // Check if email contains @ symbol
-    int atPos = email.find('@');
-    if (atPos == string::npos || atPos == 0) 
+    wipeBytes(stream, sizeof(stream));
+}
+
+// Constant-time equality of two IVs
+inline bool sivEqual(const uint8_t* a, const uint8_t* b)
+{
+    uint8_t diff = 0;
+    for (size_t i = 0; i < AES_BLOCK; i++) diff |= a[i] ^ b[i];
+    return diff == 0;
+}
+
+// Seal count (at most SIV_LANES) passwords; out[i] gets plain[i].size() +
+// SIV_BYTES bytes. Passwords of up to one block need one CMAC block and one key
+// stream block each, so theirs go through the AES kernel together.
+void sealLanes(const VaultKey& key, const string_view plain[], uint8_t* const out[], size_t count)
+{
+    uint8_t blocks[SIV_LANES][AES_BLOCK];
+    size_t lane[SIV_LANES];
+    size_t lanes = 0;
+    for (size_t i = 0; i < count; i++)
     {
-        return false;
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(plain[i].data());
+        size_t n = plain[i].size();
+        if (n > AES_BLOCK)
+        {
+            sivS2V(key, nullptr, p, n, out[i]);
+            sivCtr(key, out[i], p, out[i] + SIV_BYTES, n);
+            continue;
+        }
+        uint8_t* block = blocks[lanes];
+        memset(block, 0, AES_BLOCK);
+        if (n) memcpy(block, p, n);
+        if (n < AES_BLOCK) block[n] = 0x80;
+        xorBlock(block, block, n == AES_BLOCK ? key.fullMask : key.shortMask);
+        lane[lanes++] = i;
     }
-    
-    // Check if there's text before @
-    if (atPos == 0) 
+    if (lanes == 0) return;
+    aesKernel(key.macRounds, blocks[0], blocks[0], lanes);
+    for (size_t l = 0; l < lanes; l++)
     {
-        return false;
+        memcpy(out[lane[l]], blocks[l], SIV_BYTES);
+        sivCounter(blocks[l], 0, blocks[l]);
     }
-    
-    // Extract domain part (after @)
-    string domain = email.substr(atPos + 1);
-    if (domain.empty()) 
+    aesKernel(key.ctrRounds, blocks[0], blocks[0], lanes);
+    for (size_t l = 0; l < lanes; l++)
     {
-        return false;
+        size_t i = lane[l];
+        for (size_t j = 0; j < plain[i].size(); j++) out[i][SIV_BYTES + j] = static_cast<uint8_t>(plain[i][j]) ^ blocks[l][j];
     }
-    
-    // Check if domain contains a dot (for extension like .com, .org, etc.)
-    int dotPos = domain.find('.');
-    if (dotPos == string::npos || dotPos == 0) 
+    wipeBytes(blocks, sizeof(blocks));
+}
+
+// Open count (at most SIV_LANES) records into out[i] (size record.size() -
+// SIV_BYTES). A record that fails authentication leaves its out wiped and
+// clears its bit in the returned mask.
+uint32_t openLanes(const VaultKey& key, const string_view records[], uint8_t* const out[], size_t count)
+{
+    uint8_t blocks[SIV_LANES][AES_BLOCK];
+    size_t lane[SIV_LANES];
+    size_t lanes = 0;
+    uint32_t opened = 0;
+    for (size_t i = 0; i < count; i++)
     {
-        return false;
+        const uint8_t* r = reinterpret_cast<const uint8_t*>(records[i].data());
+        if (records[i].size() < SIV_BYTES) continue;
+        size_t n = records[i].size() - SIV_BYTES;
+        if (n > AES_BLOCK)
+        {
+            uint8_t iv[AES_BLOCK];
+            sivCtr(key, r, r + SIV_BYTES, out[i], n);
+            sivS2V(key, nullptr, out[i], n, iv);
+            if (sivEqual(iv, r)) opened |= 1u << i;
+            else wipeBytes(out[i], n);
+            continue;
+        }
+        sivCounter(r, 0, blocks[lanes]);
+        lane[lanes++] = i;
     }
-    
-    return true;
+    if (lanes == 0) return opened;
+    aesKernel(key.ctrRounds, blocks[0], blocks[0], lanes);
+    for (size_t l = 0; l < lanes; l++)
+    {
+        size_t i = lane[l];
+        size_t n = records[i].size() - SIV_BYTES;
+        const uint8_t* c = reinterpret_cast<const uint8_t*>(records[i].data()) + SIV_BYTES;
+        for (size_t j = 0; j < n; j++) out[i][j] = c[j] ^ blocks[l][j];
+        memset(blocks[l], 0, AES_BLOCK);
+        if (n) memcpy(blocks[l], out[i], n);
+        if (n < AES_BLOCK) blocks[l][n] = 0x80;
+        xorBlock(blocks[l], blocks[l], n == AES_BLOCK ? key.fullMask : key.shortMask);
+    }
+    aesKernel(key.macRounds, blocks[0], blocks[0], lanes);
+    for (size_t l = 0; l < lanes; l++)
+    {
+        size_t i = lane[l];
+        if (sivEqual(blocks[l], reinterpret_cast<const uint8_t*>(records[i].data()))) opened |= 1u << i;
+        else wipeBytes(out[i], records[i].size() - SIV_BYTES);
+    }
+    wipeBytes(blocks, sizeof(blocks));
+    return opened;
 }
 
-bool checkAndSuggestStrength(const string& password) 
+// Derive the record key of a login from the master password and key.salt, the
+// vault's random salt (so equal passwords of two vaults give unrelated keys and
+// no guess can be worked out ahead for a known email). Slow on purpose: done once
+// per sign-in. PBKDF2 runs over HMAC-SHA1: SHA-1 is already here for the breach
+// list, and its collision weakness does not carry over to HMAC, so it is still
+// a sound PRF; the iteration count sets the cost of each guess. If verifier is
+// given it gets an HMAC of the key material, which confirms the password later
+// without keeping it (see UserAuth).
+void deriveVaultKey(string_view password, VaultKey& key, uint8_t* verifier = nullptr)
 {
-    bool hasUpper = false;
-    bool hasDigit = false;
-    bool hasSymbol = false;
-
-    for (char c : password) 
+    uint8_t material[VAULT_KEY_BYTES];
+    pbkdf2Sha1(password, string_view(reinterpret_cast<const char*>(key.salt), VAULT_SALT_BYTES),
+        VAULT_KEY_ITERATIONS, material, sizeof(material));
+    key.set(material);
+    if (verifier)
     {
-        bool isUppercase = (c >= 'A' && c <= 'Z');
-        bool isLowercase = (c >= 'a' && c <= 'z');
-        bool isNumeric   = (c >= '0' && c <= '9');
-        bool isAlnum     = isUppercase || isLowercase || isNumeric;
-
-        if (!hasUpper && isUppercase) hasUpper = true;
-        if (!hasDigit && isNumeric) hasDigit = true;
-        if (!hasSymbol && !isAlnum) hasSymbol = true;
-
-        if (hasUpper && hasDigit && hasSymbol) break;
+        // One PBKDF2 round is a plain HMAC-SHA1 keyed by the material
+        pbkdf2Sha1(string_view(reinterpret_cast<const char*>(material), sizeof(material)),
+            "login verifier", 1, verifier, SHA1_BYTES);
     }
+    wipeBytes(material, sizeof(material));
+}
 
-    if (hasUpper && hasDigit && hasSymbol) 
+// A signed-in user. Their master password is not kept: salt and verifier are
+// what deriveVaultKey() made of it at sign-in, and matches() derives again and
+// compares in constant time, so neither memory nor timing gives it away.
+struct UserAuth 
+{
+    string email;
+    uint8_t salt[VAULT_SALT_BYTES] = {};
+    uint8_t verifier[SHA1_BYTES] = {};
+    
+    UserAuth(string e) 
     {
-        cout << "✅ Password looks strong.\n";
-        return true;
+        email = e;
     }
 
-    cout << "⚠️ Password could be stronger. Consider adding:\n";
-    if (!hasUpper) 
+    ~UserAuth()
     {
-        cout << "   - Uppercase letters (A-Z)\n";
+        wipeBytes(verifier, sizeof(verifier));
     }
 
-    if (!hasDigit) 
+    // Whether password is the one signed in with; slow, like a sign-in
+    bool matches(string_view password) const
     {
-        cout << "   - Numbers (0-9)\n";
+        VaultKey key;
+        memcpy(key.salt, salt, sizeof(salt));
+        uint8_t check[SHA1_BYTES];
+        deriveVaultKey(password, key, check);
+        uint8_t diff = 0;
+        for (size_t i = 0; i < sizeof(check); i++) diff |= check[i] ^ verifier[i];
+        wipeBytes(check, sizeof(check));
+        return diff == 0;
     }
+};
 
-    if (!hasSymbol) 
+string encryptPassword(const VaultKey& key, string_view password)
+{
+    string out(password.size() + SIV_BYTES, '\0');
+    uint8_t* target = reinterpret_cast<uint8_t*>(&out[0]);
+    sealLanes(key, &password, &target, 1);
+    return out;
+}
+
+// Open a record into out; false (out empty) if it is damaged or sealed under
+// another key
+bool decryptPassword(const VaultKey& key, string_view record, string& out)
+{
+    wipeString(out);
+    if (record.size() < SIV_BYTES) return false;
+    out.resize(record.size() - SIV_BYTES);
+    uint8_t* target = reinterpret_cast<uint8_t*>(&out[0]);
+    if (openLanes(key, &record, &target, 1) == 0)
     {
-        cout << "   - Symbols (!@#$%^&* etc.)\n";
+        out.clear();
+        return false;
     }
+    return true;
+}
 
-    return false;
+// The password in a record (empty if it cannot be opened)
+string decryptPassword(const VaultKey& key, string_view record)
+{
+    string out;
+    decryptPassword(key, record, out);
+    return out;
 }
 
-bool authenticateUser() 
+// Seal many passwords in place on up to threads threads (0 = one per core);
+// the plaintexts are wiped
+void encryptPasswordsBatch(const VaultKey& key, string* const passwords[], size_t count, unsigned threads = 0)
 {
-    string email, password;
-    
-    cout << "\n========== LOGIN REQUIRED ==========" << endl;
-    
-    // Loop until valid email is entered
-    while (true)
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    parallelFor((count + CIPHER_GRAIN - 1) / CIPHER_GRAIN, threads, [&](size_t item)
     {
-        cout << "Enter your email: ";
-        cin >> email;
-        
-        // Validate email format
-        if (isValidEmail(email))
+        size_t last = min(count, (item + 1) * CIPHER_GRAIN);
+        string sealed[SIV_LANES];
+        string_view plain[SIV_LANES];
+        uint8_t* out[SIV_LANES];
+        for (size_t first = item * CIPHER_GRAIN; first < last; first += SIV_LANES)
         {
-            break; 
+            size_t lanes = min(SIV_LANES, last - first);
+            for (size_t l = 0; l < lanes; l++)
+            {
+                plain[l] = *passwords[first + l];
+                sealed[l].assign(plain[l].size() + SIV_BYTES, '\0');
+                out[l] = reinterpret_cast<uint8_t*>(&sealed[l][0]);
+            }
+            sealLanes(key, plain, out, lanes);
+            for (size_t l = 0; l < lanes; l++)
+            {
+                wipeString(*passwords[first + l]);
+                passwords[first + l]->swap(sealed[l]);
+            }
         }
-        else
+    });
+}
+
+// Open many records on up to threads threads (0 = one per core): out[i] gets
+// the password of records[i], or stays empty if it cannot be opened. Returns
+// how many could not.
+size_t decryptPasswordsBatch(const VaultKey& key, const string_view records[], string* const out[], size_t count, unsigned threads = 0)
+{
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    atomic<size_t> failed(0);
+    parallelFor((count + CIPHER_GRAIN - 1) / CIPHER_GRAIN, threads, [&](size_t item)
+    {
+        size_t last = min(count, (item + 1) * CIPHER_GRAIN);
+        uint8_t* target[SIV_LANES];
+        size_t bad = 0;
+        for (size_t first = item * CIPHER_GRAIN; first < last; first += SIV_LANES)
         {
-            cout << "❌ Invalid email format. Please try again.\n";
+            size_t lanes = min(SIV_LANES, last - first);
+            for (size_t l = 0; l < lanes; l++)
+            {
+                string& plain = *out[first + l];
+                plain.resize(records[first + l].size() >= SIV_BYTES ? records[first + l].size() - SIV_BYTES : 0);
+                target[l] = reinterpret_cast<uint8_t*>(&plain[0]);
+            }
+            uint32_t opened = openLanes(key, records + first, target, lanes);
+            for (size_t l = 0; l < lanes; l++)
+            {
+                if (opened >> l & 1) continue;
+                out[first + l]->clear();
+                bad++;
+            }
         }
+        failed += bad;
+    });
+    return failed;
+}
+
+// ==================== VAULT STORE ====================
+//
+// One storage engine for the vault. Records live in a chunked slab (each chunk is
+// one contiguous array, so PasswordNode pointers stay valid as the vault grows),
+// and both indexes refer to records by 32-bit slot id instead of heap pointers:
+//   - AccountBST: an AVL tree of 24-byte nodes packed in one array, ordered by name
+//   - PasswordReuseIndex: an open-addressing table of (hash, slot) pairs
+//   - VaultVersions: once read views are wanted, immutable published copies
+
+const uint32_t NIL = 0xFFFFFFFF;        // "No slot / no node"
+const int SLAB_CHUNK_SHIFT = 12;         // 4096 records per slab chunk
+const uint32_t SLAB_CHUNK_SIZE = 1u << SLAB_CHUNK_SHIFT;
+
+const size_t ARENA_BLOCK_SIZE = 1 << 20;     // Bytes per arena block
+const int ARENA_SIZE_CLASSES = 12;           // Pooled sizes 16 B .. 32 KB (powers of two)
+
+// Per-session byte arena for account names and encrypted passwords.
+// Small strings are bump-allocated from 1 MB blocks; released ones go onto a free
+// list per power-of-two size class and are reused, so add/delete churn does not
+// grow the arena. Freed bytes are wiped immediately, and reset() wipes and drops
+// every block at once instead of freeing strings one by one.
+struct ByteArena
+{
+    vector<char*> blocks;
+    vector<pair<char*, size_t>> oversized;  // Strings larger than the biggest class
+    char* cursor;                 // Next free byte in the newest block
+    size_t remaining;             // Bytes left after cursor
+    char* freeLists[ARENA_SIZE_CLASSES];
+    size_t bytesInUse;
+
+    ByteArena()
+    {
+        cursor = nullptr;
+        remaining = 0;
+        bytesInUse = 0;
+        for (int c = 0; c < ARENA_SIZE_CLASSES; c++) freeLists[c] = nullptr;
     }
-    
-    // Loop until non-empty password is entered
-    while (true)
+
+    ~ByteArena()
     {
-        cout << "Enter your password: ";
-        cin >> password;
-        
-        if (!password.empty())
+        reset();
+    }
+
+    // Smallest class (16 << c bytes) that fits n, or -1 if n is oversized
+    static int classOf(size_t n)
+    {
+        int c = 0;
+        while (c < ARENA_SIZE_CLASSES && (static_cast<size_t>(16) << c) < n) c++;
+        return c < ARENA_SIZE_CLASSES ? c : -1;
+    }
+
+    char* allocate(size_t n)
+    {
+        int c = classOf(n);
+        if (c < 0)
         {
-            break; // Valid password, exit loop
+            oversized.emplace_back(new char[n], n);
+            bytesInUse += n;
+            return oversized.back().first;
         }
-        else
+
+        size_t size = static_cast<size_t>(16) << c;
+        bytesInUse += size;
+        if (freeLists[c])
         {
-            cout << "❌ Password cannot be empty. Please try again.\n";
+            char* p = freeLists[c];
+            memcpy(&freeLists[c], p, sizeof(char*));
+            return p;
+        }
+        if (remaining < size)
+        {
+            blocks.push_back(new char[ARENA_BLOCK_SIZE]);
+            cursor = blocks.back();
+            remaining = ARENA_BLOCK_SIZE;
         }
+        char* p = cursor;
+        cursor += size;
+        remaining -= size;
+        return p;
     }
-    
-    currentUser = new UserAuth(email, password);
-    cout << "✅ Login successful! Welcome to Password Manager.\n";
-    return true;
-}
 
-bool verifyPassword() 
+    // Wipe a string and return its bytes to the pool
+    void release(const char* data, size_t n)
+    {
+        if (n == 0) return;
+        char* p = const_cast<char*>(data);
+        memset(p, 0, n);
+
+        int c = classOf(n);
+        if (c < 0)
+        {
+            for (size_t i = 0; i < oversized.size(); i++)
+            {
+                if (oversized[i].first == p)
+                {
+                    oversized[i] = oversized.back();
+                    oversized.pop_back();
+                    break;
+                }
+            }
+            delete[] p;
+            bytesInUse -= n;
+            return;
+        }
+        memcpy(p, &freeLists[c], sizeof(char*));
+        freeLists[c] = p;
+        bytesInUse -= static_cast<size_t>(16) << c;
+    }
+
+    // Copy s into the arena
+    string_view store(string_view s)
+    {
+        if (s.empty()) return string_view();
+        char* p = allocate(s.size());
+        memcpy(p, s.data(), s.size());
+        return string_view(p, s.size());
+    }
+
+    // Wipe and free everything; cost is per block, not per string
+    void reset()
+    {
+        for (char* block : blocks)
+        {
+            memset(block, 0, ARENA_BLOCK_SIZE);
+            delete[] block;
+        }
+        for (auto& big : oversized)
+        {
+            memset(big.first, 0, big.second);
+            delete[] big.first;
+        }
+        blocks.clear();
+        oversized.clear();
+        cursor = nullptr;
+        remaining = 0;
+        bytesInUse = 0;
+        for (int c = 0; c < ARENA_SIZE_CLASSES; c++) freeLists[c] = nullptr;
+    }
+};
+
+// Fixed-size slab of PasswordNode records addressed by slot id.
+// Records hold views into the slab's ByteArena, so they need no destructor and
+// the whole slab can be dropped in one step on logout.
+struct RecordSlab
 {
-    string inputPassword;
-    cout << "\nEnter your password to view passwords: ";
-    cin >> inputPassword;
-    
-    if (currentUser && inputPassword == currentUser->password) 
+    vector<PasswordNode*> chunks;
+    ByteArena strings;    // Account name and password bytes
+    uint32_t highWater;   // Slots [0, highWater) have been handed out at least once
+    uint32_t freeHead;    // Released slots, threaded through PasswordNode::nextFree
+    uint32_t liveCount;
+
+    RecordSlab()
     {
-        cout << "✅ Password verified!\n";
-        return true;
-    } 
-    else 
+        highWater = 0;
+        freeHead = NIL;
+        liveCount = 0;
+    }
+
+    ~RecordSlab()
     {
-        cout << "❌ Incorrect password! Access denied.\n";
-        return false;
+        for (PasswordNode* chunk : chunks)
+        {
+            delete[] chunk;
+        }
     }
-}
 
-bool logout() 
+    PasswordNode& at(uint32_t slot)
+    {
+        return chunks[slot >> SLAB_CHUNK_SHIFT][slot & (SLAB_CHUNK_SIZE - 1)];
+    }
+
+    const PasswordNode& at(uint32_t slot) const
+    {
+        return chunks[slot >> SLAB_CHUNK_SHIFT][slot & (SLAB_CHUNK_SIZE - 1)];
+    }
+
+    // Take a free slot (reusing released ones first) and fill it
+    uint32_t allocate(string_view accountName, string_view password)
+    {
+        uint32_t slot;
+        if (freeHead != NIL)
+        {
+            slot = freeHead;
+            freeHead = at(slot).nextFree;
+        }
+        else
+        {
+            if ((highWater >> SLAB_CHUNK_SHIFT) == chunks.size())
+            {
+                chunks.push_back(new PasswordNode[SLAB_CHUNK_SIZE]);
+            }
+            slot = highWater++;
+        }
+
+        PasswordNode& record = at(slot);
+        record.accountName = strings.store(accountName);
+        record.password = strings.store(password);
+        record.slot = slot;
+        record.inUse = true;
+        record.strength = STRENGTH_UNKNOWN;
+        liveCount++;
+        return slot;
+    }
+
+    // Replace a record's password (the old bytes are wiped and pooled)
+    void setPassword(uint32_t slot, string_view password)
+    {
+        PasswordNode& record = at(slot);
+        string_view old = record.password;
+        record.strength = STRENGTH_UNKNOWN;
+        record.password = strings.store(password);
+        strings.release(old.data(), old.size());
+    }
+
+    // Wipe the record and put its slot on the free list
+    void release(uint32_t slot)
+    {
+        PasswordNode& record = at(slot);
+        strings.release(record.password.data(), record.password.size());
+        strings.release(record.accountName.data(), record.accountName.size());
+        record.password = string_view();
+        record.accountName = string_view();
+        record.inUse = false;
+        record.nextFree = freeHead;
+        freeHead = slot;
+        liveCount--;
+    }
+
+    // Drop every record at once: the arena wipes its blocks and the slab keeps
+    // only its first chunk. No per-record work, so logout cost does not grow
+    // with the vault.
+    void reset()
+    {
+        strings.reset();
+        for (size_t c = 1; c < chunks.size(); c++)
+        {
+            delete[] chunks[c];
+        }
+        chunks.resize(chunks.empty() ? 0 : 1);
+        highWater = 0;
+        freeHead = NIL;
+        liveCount = 0;
+    }
+};
+
+// First 8 bytes of a name packed big-endian (zero padded), so comparing two
+// prefixes as integers orders them exactly like comparing the strings' starts
+uint64_t keyPrefix(string_view name)
 {
-    cout << "\n========== LOGOUT ==========" << endl;
-    cout << "Are you sure you want to logout? (y/n): ";
-    char choice;
-    cin >> choice;
-    
-    if (choice == 'y' || choice == 'Y') 
+    uint64_t prefix = 0;
+    size_t n = name.size() < 8 ? name.size() : 8;
+    for (size_t i = 0; i < 8; i++)
     {
-        cout << "✅ Logged out successfully!\n";
-        return true;
+        prefix = (prefix << 8) | (i < n ? static_cast<unsigned char>(name[i]) : 0);
     }
-    return false;
+    return prefix;
 }
 
-// ==================== PASSWORD MANAGER ====================
+// Compact AVL node (24 bytes): refers to its record by slot id and to children by
+// index, and caches the key prefix so most comparisons never leave the node
+struct BSTNode
+{
+    uint64_t prefix;    // keyPrefix() of the account name
+    uint32_t slot;      // Slot of the PasswordNode in the RecordSlab
+    uint32_t left;      // Index of left child in AccountBST::nodes (NIL if none)
+    uint32_t right;     // Index of right child (also links free nodes)
+    int32_t height;     // Height of the subtree rooted here (leaf = 1)
+};
 
-struct PasswordManager 
+// An AVL tree of n nodes is at most 1.44 * log2(n) tall, so 64 levels covers any vault
+const int MAX_TREE_DEPTH = 64;
+
+struct AccountBST;
+
+// Streaming in-order iterator over the tree using an explicit stack (no recursion,
+// no heap allocation, constant memory regardless of vault size)
+struct AccountIterator
 {
-    PasswordNode* head;
-    AccountBST bst;  // BST stores pointers to PasswordNodes for fast searching
+    AccountBST* tree;
+    uint32_t stack[MAX_TREE_DEPTH];
+    int depth;
 
-    PasswordManager() 
+    AccountIterator(AccountBST* t);
+    void pushLeftSpine(uint32_t node);
+
+    // Reposition at the first account name >= key
+    void seek(string_view key);
+
+    bool hasNext() const
     {
-        head = nullptr;
+        return depth > 0;
     }
 
-    // Destructor to clean up memory
-    ~PasswordManager()
+    // Returns the next PasswordNode in account-name order
+    PasswordNode* next();
+};
+
+// Self-balancing (AVL) search tree over account names.
+// Nodes are packed in one array and store slot ids, so a descent touches 24-byte
+// nodes instead of chasing heap pointers. Keys are compared as string_views after
+// an integer prefix check, so no comparison ever allocates and most finish inside
+// the node. Keeps height <= 1.44 * log2(n).
+struct AccountBST
+{
+    RecordSlab* records;
+    vector<BSTNode> nodes;
+    uint32_t root;
+    uint32_t freeNodes;   // Released node indices, threaded through BSTNode::right
+    uint32_t count;
+
+    // Constructor
+    AccountBST(RecordSlab* slab)
     {
-        clearAllPasswords();
+        records = slab;
+        root = NIL;
+        freeNodes = NIL;
+        count = 0;
     }
 
-    // Find node by account name
-    PasswordNode* findNodeByAccount(const string& account)
+    string_view keyOf(uint32_t node)
     {
-        PasswordNode* temp = head;
-        while (temp)
-        {
-            if (temp->accountName == account) return temp;
-            temp = temp->next;
-        }
-        return nullptr;
+        return records->at(nodes[node].slot).accountName;
     }
 
-    // Check if password is already used by another account
-    string findAccountWithPassword(const string& encryptedPassword, const string& excludeAccount)
+    // Three-way compare of (name, its prefix) against a node's key.
+    // Only equal prefixes need the full string from the record.
+    int compareTo(uint32_t node, string_view accountName, uint64_t prefix)
     {
-        PasswordNode* temp = head;
-        while (temp)
+        uint64_t nodePrefix = nodes[node].prefix;
+        if (prefix != nodePrefix)
         {
-            if (temp->password == encryptedPassword && temp->accountName != excludeAccount)
-            {
-                return temp->accountName;
-            }
-            temp = temp->next;
+            return prefix < nodePrefix ? -1 : 1;
         }
-        return "";
+        return accountName.compare(keyOf(node));
     }
 
-    // Add a new password
-    void addPassword() 
+    int heightOf(uint32_t node)
     {
-        cin.ignore(); // Clear the input buffer (removes leftover newline from previous cin >> choice)
-        string account, pass;
-        
-        // Loop until non-empty account name is entered
-        while (true)
+        return node == NIL ? 0 : nodes[node].height;
+    }
+
+    void updateHeight(uint32_t node)
+    {
+        int lh = heightOf(nodes[node].left);
+        int rh = heightOf(nodes[node].right);
+        nodes[node].height = 1 + (lh > rh ? lh : rh);
+    }
+
+    uint32_t rotateRight(uint32_t node)
+    {
+        uint32_t pivot = nodes[node].left;
+        nodes[node].left = nodes[pivot].right;
+        nodes[pivot].right = node;
+        updateHeight(node);
+        updateHeight(pivot);
+        return pivot;
+    }
+
+    uint32_t rotateLeft(uint32_t node)
+    {
+        uint32_t pivot = nodes[node].right;
+        nodes[node].right = nodes[pivot].left;
+        nodes[pivot].left = node;
+        updateHeight(node);
+        updateHeight(pivot);
+        return pivot;
+    }
+
+    // Restore the AVL property at node after one of its subtrees changed height
+    uint32_t rebalance(uint32_t node)
+    {
+        updateHeight(node);
+        int balance = heightOf(nodes[node].left) - heightOf(nodes[node].right);
+
+        if (balance > 1)
         {
-            cout << "\nEnter Account Name (e.g., Gmail, Facebook, Bank): ";
-            getline(cin, account);
-            
-            if (!account.empty())
+            // Left-Right case: rotate the left child first
+            uint32_t child = nodes[node].left;
+            if (heightOf(nodes[child].left) < heightOf(nodes[child].right))
             {
-                break; // Valid account name, exit loop
+                nodes[node].left = rotateLeft(child);
             }
-            else
+            return rotateRight(node);
+        }
+        if (balance < -1)
+        {
+            // Right-Left case: rotate the right child first
+            uint32_t child = nodes[node].right;
+            if (heightOf(nodes[child].right) < heightOf(nodes[child].left))
             {
-                cout << "❌ Account name cannot be empty. Please try again.\n";
+                nodes[node].right = rotateRight(child);
             }
+            return rotateLeft(node);
         }
+        return node;
+    }
 
-        cout << "Enter Password for " << account << ": ";
-        getline(cin, pass);
+    uint32_t newNode(uint32_t slot)
+    {
+        uint32_t node;
+        if (freeNodes != NIL)
+        {
+            node = freeNodes;
+            freeNodes = nodes[node].right;
+        }
+        else
+        {
+            node = static_cast<uint32_t>(nodes.size());
+            nodes.push_back(BSTNode());
+        }
+        nodes[node] = { keyPrefix(records->at(slot).accountName), slot, NIL, NIL, 1 };
+        count++;
+        return node;
+    }
 
-        checkAndSuggestStrength(pass);
+    void freeNode(uint32_t node)
+    {
+        nodes[node].right = freeNodes;
+        freeNodes = node;
+        count--;
+    }
 
-        string encrypted = encryptPassword(pass);
-        
-        // Check if this password is already used by another account
-        string existingAccount = findAccountWithPassword(encrypted, account);
-        if (!existingAccount.empty())
+    // Helper function for recursive insertion (depth is bounded by the tree height)
+    uint32_t insertHelper(uint32_t node, uint32_t slot, string_view accountName, uint64_t prefix, bool& inserted)
+    {
+        // If tree is empty, create new node
+        if (node == NIL)
         {
-            cout << "⚠️ Warning: This password is already used for account \"" << existingAccount << "\". Try a new password for better security.\n";
+            inserted = true;
+            return newNode(slot);
         }
-        
-        PasswordNode* newNode = new PasswordNode(account, encrypted);
 
-        if (!head) 
+        int cmp = compareTo(node, accountName, prefix);
+        int oldChildHeight;
+        int newChildHeight;
+        if (cmp < 0)
+        {
+            // Insert in left subtree
+            oldChildHeight = heightOf(nodes[node].left);
+            uint32_t child = insertHelper(nodes[node].left, slot, accountName, prefix, inserted);
+            nodes[node].left = child;
+            newChildHeight = heightOf(child);
+        }
+        else if (cmp > 0)
         {
-            head = newNode;
-        } else 
+            // Insert in right subtree
+            oldChildHeight = heightOf(nodes[node].right);
+            uint32_t child = insertHelper(nodes[node].right, slot, accountName, prefix, inserted);
+            nodes[node].right = child;
+            newChildHeight = heightOf(child);
+        }
+        else
         {
-            PasswordNode* temp = head;
-            while (temp->next) temp = temp->next;
-            temp->next = newNode;
+            // If accountName == nodeAccountName, do nothing (duplicate)
+            return node;
         }
 
-        // Insert pointer to PasswordNode into BST (for fast searching and sorted display)
-        bst.insert(newNode);
+        // Heights above an unchanged subtree cannot change, so skip the rebalance
+        // (and the sibling read it needs) for the rest of the path
+        if (newChildHeight == oldChildHeight)
+        {
+            return node;
+        }
+        return rebalance(node);
+    }
 
-        // Record action for undo
-        Action action;
-        action.actionType = "ADD";
-        action.accountName = account;
-        action.newPassword = encrypted;
-        undoStack.push(action);
-        redoStack.clear(); // Clear redo stack after new action
+    // Insert a record slot into the tree (returns false if the name is already present)
+    bool insert(uint32_t slot)
+    {
+        bool inserted = false;
+        string_view accountName = records->at(slot).accountName;
+        root = insertHelper(root, slot, accountName, keyPrefix(accountName), inserted);
+        return inserted;
+    }
 
-        cout << "✅ Password for " << account << " added successfully!\n";
+    // Search for a record slot by account name (NIL if not found)
+    uint32_t search(string_view accountName)
+    {
+        uint64_t prefix = keyPrefix(accountName);
+        uint32_t current = root;
+        while (current != NIL)
+        {
+            // One three-way comparison per level, usually decided by the cached prefix
+            int cmp = compareTo(current, accountName, prefix);
+            if (cmp == 0)
+            {
+                return nodes[current].slot;
+            }
+            else if (cmp < 0)
+            {
+                current = nodes[current].left;
+            }
+            else
+            {
+                current = nodes[current].right;
+            }
+        }
+        return NIL;
     }
 
-    // View all passwords (using BST for sorted display)
-    void viewPasswords() 
+    // Helper function to find and delete a node from the tree
+    uint32_t deleteHelper(uint32_t node, string_view accountName, uint64_t prefix, uint32_t slot)
     {
-        if (!verifyPassword()) 
+        if (node == NIL)
+        {
+            return NIL;
+        }
+
+        int cmp = compareTo(node, accountName, prefix);
+        uint32_t child;
+        int oldChildHeight;
+        if (cmp < 0)
+        {
+            oldChildHeight = heightOf(nodes[node].left);
+            child = deleteHelper(nodes[node].left, accountName, prefix, slot);
+            nodes[node].left = child;
+        }
+        else if (cmp > 0)
+        {
+            oldChildHeight = heightOf(nodes[node].right);
+            child = deleteHelper(nodes[node].right, accountName, prefix, slot);
+            nodes[node].right = child;
+        }
+        else
         {
-            recordViewAttempt(false);
-            if (lastKViewAttemptsFailed(3))
+            // Found the node to delete
+            // Check if it's the exact same record slot
+            if (nodes[node].slot != slot)
             {
-                cout << "⚠️ Multiple failed view attempts detected (last 3).\n";
+                return node;
             }
-            return;
+
+            uint32_t left = nodes[node].left;
+            uint32_t right = nodes[node].right;
+
+            // Case 1-3: at most one child
+            if (left == NIL || right == NIL)
+            {
+                freeNode(node);
+                return left == NIL ? right : left;
+            }
+
+            // Case 4: Two children - get inorder successor (smallest in right subtree)
+            uint32_t successor = right;
+            while (nodes[successor].left != NIL)
+            {
+                successor = nodes[successor].left;
+            }
+
+            // Copy the slot and its key prefix (not the data), then delete the inorder successor
+            uint32_t successorSlot = nodes[successor].slot;
+            uint64_t successorPrefix = nodes[successor].prefix;
+            nodes[node].slot = successorSlot;
+            nodes[node].prefix = successorPrefix;
+            oldChildHeight = heightOf(right);
+            child = deleteHelper(right, records->at(successorSlot).accountName, successorPrefix, successorSlot);
+            nodes[node].right = child;
         }
-        recordViewAttempt(true);
-        
-        if (!head || bst.isEmpty()) 
+
+        // As in insert: if the changed subtree kept its height, nothing above moves
+        if (heightOf(child) == oldChildHeight)
         {
-            cout << "\nNo passwords saved yet.\n";
-            return;
+            return node;
         }
+        return rebalance(node);
+    }
+
+    // Delete a record slot from the tree
+    void remove(uint32_t slot)
+    {
+        string_view accountName = records->at(slot).accountName;
+        root = deleteHelper(root, accountName, keyPrefix(accountName), slot);
+    }
+
+    // Iterator positioned at the smallest account name
+    AccountIterator begin()
+    {
+        return AccountIterator(this);
+    }
+
+    // Get up to maxSize PasswordNode pointers in sorted order (returns count)
+    int getAllNodes(PasswordNode* out[], int maxSize)
+    {
+        int n = 0;
+        for (AccountIterator it = begin(); it.hasNext() && n < maxSize; )
+        {
+            out[n++] = it.next();
+        }
+        return n;
+    }
+
+    // Build a perfectly balanced subtree from slots[lo..hi) (sorted, no duplicates)
+    uint32_t buildHelper(const uint32_t slots[], int lo, int hi)
+    {
+        if (lo >= hi)
+        {
+            return NIL;
+        }
+        int mid = lo + (hi - lo) / 2;
+        uint32_t node = newNode(slots[mid]);
+        uint32_t left = buildHelper(slots, lo, mid);
+        uint32_t right = buildHelper(slots, mid + 1, hi);
+        nodes[node].left = left;
+        nodes[node].right = right;
+        updateHeight(node);
+        return node;
+    }
+
+    // Replace the tree with one built from a sorted, duplicate-free slot array in O(n)
+    void buildFromSorted(const uint32_t slots[], int n)
+    {
+        clear();
+        nodes.reserve(n);
+        root = buildHelper(slots, 0, n);
+    }
+
+    // Height of the whole tree (0 when empty)
+    int height()
+    {
+        return heightOf(root);
+    }
+
+    // Check if BST is empty
+    bool isEmpty()
+    {
+        return root == NIL;
+    }
+
+    void clear()
+    {
+        vector<BSTNode>().swap(nodes);  // Release the node array, not just empty it
+        root = NIL;
+        freeNodes = NIL;
+        count = 0;
+    }
+};
+
+AccountIterator::AccountIterator(AccountBST* t)
+{
+    tree = t;
+    depth = 0;
+    pushLeftSpine(tree->root);
+}
+
+void AccountIterator::pushLeftSpine(uint32_t node)
+{
+    while (node != NIL)
+    {
+        stack[depth++] = node;
+        node = tree->nodes[node].left;
+    }
+}
+
+// Keeps exactly the ancestors where the descent went left, so the top of the
+// stack is the smallest name >= key and next() continues in order: O(log n)
+void AccountIterator::seek(string_view key)
+{
+    depth = 0;
+    uint64_t prefix = keyPrefix(key);
+    uint32_t node = tree->root;
+    while (node != NIL)
+    {
+        if (tree->compareTo(node, key, prefix) <= 0)
+        {
+            stack[depth++] = node;
+            node = tree->nodes[node].left;
+        }
+        else
+        {
+            node = tree->nodes[node].right;
+        }
+    }
+}
+
+PasswordNode* AccountIterator::next()
+{
+    uint32_t node = stack[--depth];
+    pushLeftSpine(tree->nodes[node].right);
+    return &tree->records->at(tree->nodes[node].slot);
+}
+
+// Keyed 64-bit hash (SipHash-2-4) of a stored password.
+// The key is random per session, so the index never exposes a stable fingerprint.
+uint64_t rotl64(uint64_t x, int b)
+{
+    return (x << b) | (x >> (64 - b));
+}
+
+void sipRound(uint64_t& v0, uint64_t& v1, uint64_t& v2, uint64_t& v3)
+{
+    v0 += v1; v1 = rotl64(v1, 13); v1 ^= v0; v0 = rotl64(v0, 32);
+    v2 += v3; v3 = rotl64(v3, 16); v3 ^= v2;
+    v0 += v3; v3 = rotl64(v3, 21); v3 ^= v0;
+    v2 += v1; v1 = rotl64(v1, 17); v1 ^= v2; v2 = rotl64(v2, 32);
+}
+
+uint64_t keyedHash(string_view data, uint64_t k0, uint64_t k1)
+{
+    uint64_t v0 = 0x736f6d6570736575ULL ^ k0;
+    uint64_t v1 = 0x646f72616e646f6dULL ^ k1;
+    uint64_t v2 = 0x6c7967656e657261ULL ^ k0;
+    uint64_t v3 = 0x7465646279746573ULL ^ k1;
+
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data.data());
+    size_t len = data.size();
+    size_t fullWords = len / 8;
+
+    for (size_t w = 0; w < fullWords; w++)
+    {
+        uint64_t m = 0;
+        for (int i = 7; i >= 0; i--) m = (m << 8) | p[w * 8 + i];
+        v3 ^= m;
+        sipRound(v0, v1, v2, v3);
+        sipRound(v0, v1, v2, v3);
+        v0 ^= m;
+    }
+
+    // Last block: remaining bytes plus the length in the top byte
+    uint64_t last = static_cast<uint64_t>(len & 0xff) << 56;
+    for (size_t i = 0; i < (len & 7); i++)
+    {
+        last |= static_cast<uint64_t>(p[fullWords * 8 + i]) << (8 * i);
+    }
+    v3 ^= last;
+    sipRound(v0, v1, v2, v3);
+    sipRound(v0, v1, v2, v3);
+    v0 ^= last;
+
+    v2 ^= 0xff;
+    for (int i = 0; i < 4; i++) sipRound(v0, v1, v2, v3);
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+// One group of accounts sharing a (hashed) password
+struct ReuseEntry
+{
+    uint32_t hash;      // Low 32 bits of the keyed hash (also picks the home bucket)
+    uint32_t slot;      // First record of the group, NIL if the bucket is empty
+};
+
+// Reverse index: keyed hash of the stored password -> record slots using it.
+// Open addressing with linear probing and backward-shift deletion over distinct
+// hashes; the records of one group are chained through PasswordNode::reusePrev/
+// reuseNext, so add/remove/lookup stay O(1) on average even when thousands of
+// accounts share one password.
+struct PasswordReuseIndex
+{
+    RecordSlab* records;
+    ReuseEntry* table;
+    uint32_t capacity;    // Power of two
+    uint32_t count;       // Distinct hashes in the table
+    uint64_t key0;
+    uint64_t key1;
+
+    PasswordReuseIndex(RecordSlab* slab)
+    {
+        records = slab;
+        capacity = 64;
+        count = 0;
+        table = new ReuseEntry[capacity];
+        for (uint32_t i = 0; i < capacity; i++) table[i] = { 0, NIL };
+
+        random_device rd;
+        key0 = (static_cast<uint64_t>(rd()) << 32) | rd();
+        key1 = (static_cast<uint64_t>(rd()) << 32) | rd();
+    }
+
+    ~PasswordReuseIndex()
+    {
+        delete[] table;
+    }
+
+    uint32_t hashOf(string_view encryptedPassword)
+    {
+        return static_cast<uint32_t>(keyedHash(encryptedPassword, key0, key1));
+    }
+
+    // Bucket holding hash, or the empty bucket where it would go
+    uint32_t findBucket(uint32_t hash)
+    {
+        uint32_t mask = capacity - 1;
+        uint32_t i = hash & mask;
+        while (table[i].slot != NIL && table[i].hash != hash)
+        {
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+    // Double the table once it is half full
+    void grow()
+    {
+        ReuseEntry* old = table;
+        uint32_t oldCapacity = capacity;
+
+        capacity *= 2;
+        table = new ReuseEntry[capacity];
+        for (uint32_t i = 0; i < capacity; i++) table[i] = { 0, NIL };
+        for (uint32_t i = 0; i < oldCapacity; i++)
+        {
+            if (old[i].slot != NIL) table[findBucket(old[i].hash)] = old[i];
+        }
+        delete[] old;
+    }
+
+    // Index a record under its current password
+    void add(uint32_t slot)
+    {
+        if ((count + 1) * 2 > capacity)
+        {
+            grow();
+        }
+
+        PasswordNode& record = records->at(slot);
+        uint32_t hash = hashOf(record.password);
+        uint32_t i = findBucket(hash);
+
+        record.reusePrev = NIL;
+        record.reuseNext = table[i].slot;  // NIL when starting a new group
+        if (table[i].slot == NIL)
+        {
+            count++;
+        }
+        else
+        {
+            records->at(table[i].slot).reusePrev = slot;
+        }
+        table[i] = { hash, slot };
+    }
+
+    // Drop a record from the index (call before its password changes or it is released)
+    void remove(uint32_t slot)
+    {
+        PasswordNode& record = records->at(slot);
+        uint32_t i = findBucket(hashOf(record.password));
+        if (table[i].slot == NIL) return;  // Not indexed
+
+        // Unlink from the group chain
+        if (record.reuseNext != NIL) records->at(record.reuseNext).reusePrev = record.reusePrev;
+        if (record.reusePrev != NIL)
+        {
+            records->at(record.reusePrev).reuseNext = record.reuseNext;
+            return;
+        }
+        table[i].slot = record.reuseNext;
+        if (table[i].slot != NIL) return;
+
+        // Group is empty: backward-shift the rest of the probe run (no tombstones needed)
+        uint32_t mask = capacity - 1;
+        uint32_t j = i;
+        while (true)
+        {
+            j = (j + 1) & mask;
+            if (table[j].slot == NIL) break;
+            uint32_t home = table[j].hash & mask;
+            if (((j - home) & mask) >= ((j - i) & mask))
+            {
+                table[i] = table[j];
+                i = j;
+            }
+        }
+        table[i] = { 0, NIL };
+        count--;
+    }
+
+    // Any account other than excludeAccount whose stored password equals encryptedPassword
+    PasswordNode* findOther(string_view encryptedPassword, string_view excludeAccount)
+    {
+        uint32_t i = findBucket(hashOf(encryptedPassword));
+        for (uint32_t slot = table[i].slot; slot != NIL; )
+        {
+            PasswordNode& record = records->at(slot);
+            if (record.password == encryptedPassword && record.accountName != excludeAccount)
+            {
+                return &record;
+            }
+            slot = record.reuseNext;
+        }
+        return nullptr;
+    }
+
+    // Back to an empty 64-bucket table
+    void clear()
+    {
+        if (capacity != 64)
+        {
+            delete[] table;
+            capacity = 64;
+            table = new ReuseEntry[capacity];
+        }
+        for (uint32_t i = 0; i < capacity; i++) table[i] = { 0, NIL };
+        count = 0;
+    }
+};
+
+// Exact-match index: keyed hash of the account name -> record slot.
+// Open addressing with linear probing and backward-shift deletion, so a lookup
+// costs one probe run plus the record it lands on instead of a tree descent.
+struct AccountHashIndex
+{
+    RecordSlab* records;
+    ReuseEntry* table;    // hash = low 32 bits of keyedHash(name), slot = NIL if empty
+    uint32_t capacity;    // Power of two
+    uint32_t count;
+    uint64_t key0;
+    uint64_t key1;
+
+    AccountHashIndex(RecordSlab* slab)
+    {
+        records = slab;
+        capacity = 64;
+        count = 0;
+        table = new ReuseEntry[capacity];
+        for (uint32_t i = 0; i < capacity; i++) table[i] = { 0, NIL };
+
+        random_device rd;
+        key0 = (static_cast<uint64_t>(rd()) << 32) | rd();
+        key1 = (static_cast<uint64_t>(rd()) << 32) | rd();
+    }
+
+    ~AccountHashIndex()
+    {
+        delete[] table;
+    }
+
+    uint32_t hashOf(string_view accountName) const
+    {
+        return static_cast<uint32_t>(keyedHash(accountName, key0, key1));
+    }
+
+    // Bucket holding accountName, or the empty bucket where it would go
+    uint32_t findBucket(string_view accountName, uint32_t hash) const
+    {
+        uint32_t mask = capacity - 1;
+        uint32_t i = hash & mask;
+        while (table[i].slot != NIL)
+        {
+            if (table[i].hash == hash && records->at(table[i].slot).accountName == accountName)
+            {
+                break;
+            }
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+    // Double the table once it is half full
+    void grow()
+    {
+        ReuseEntry* old = table;
+        uint32_t oldCapacity = capacity;
+
+        capacity *= 2;
+        uint32_t mask = capacity - 1;
+        table = new ReuseEntry[capacity];
+        for (uint32_t i = 0; i < capacity; i++) table[i] = { 0, NIL };
+        for (uint32_t i = 0; i < oldCapacity; i++)
+        {
+            if (old[i].slot == NIL) continue;
+            uint32_t j = old[i].hash & mask;
+            while (table[j].slot != NIL) j = (j + 1) & mask;
+            table[j] = old[i];
+        }
+        delete[] old;
+    }
+
+    // Slot for an account name (NIL if not found)
+    uint32_t search(string_view accountName) const
+    {
+        return table[findBucket(accountName, hashOf(accountName))].slot;
+    }
+
+    // Index a record under its name (the caller guarantees the name is new)
+    void add(uint32_t slot)
+    {
+        if ((count + 1) * 2 > capacity)
+        {
+            grow();
+        }
+        string_view accountName = records->at(slot).accountName;
+        uint32_t hash = hashOf(accountName);
+        table[findBucket(accountName, hash)] = { hash, slot };
+        count++;
+    }
+
+    // Drop a record from the index (call before it is released)
+    void remove(uint32_t slot)
+    {
+        string_view accountName = records->at(slot).accountName;
+        uint32_t i = findBucket(accountName, hashOf(accountName));
+        if (table[i].slot != slot) return;  // Not indexed
+
+        // Backward-shift the rest of the probe run (no tombstones needed)
+        uint32_t mask = capacity - 1;
+        uint32_t j = i;
+        while (true)
+        {
+            j = (j + 1) & mask;
+            if (table[j].slot == NIL) break;
+            uint32_t home = table[j].hash & mask;
+            if (((j - home) & mask) >= ((j - i) & mask))
+            {
+                table[i] = table[j];
+                i = j;
+            }
+        }
+        table[i] = { 0, NIL };
+        count--;
+    }
+
+    // Back to an empty 64-bucket table
+    void clear()
+    {
+        if (capacity != 64)
+        {
+            delete[] table;
+            capacity = 64;
+            table = new ReuseEntry[capacity];
+        }
+        for (uint32_t i = 0; i < capacity; i++) table[i] = { 0, NIL };
+        count = 0;
+    }
+};
+
+// CRC-32 (IEEE, reflected) used to detect torn journal records and bad snapshot headers
+struct Crc32Table
+{
+    uint32_t entries[256];
+
+    Crc32Table()
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            entries[i] = c;
+        }
+    }
+};
+
+uint32_t crc32(const char* data, size_t n, uint32_t crc = 0)
+{
+    static const Crc32Table table;  // Built once, thread-safe (checkpoints run on a thread)
+    crc = ~crc;
+    for (size_t i = 0; i < n; i++)
+    {
+        crc = table.entries[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+// Read-only view of a whole file: mapped where mmap exists, otherwise read into memory
+struct MappedFile
+{
+    const char* data;
+    size_t size;
+    vector<char> copy;    // Used when the file cannot be mapped
+
+    MappedFile()
+    {
+        data = nullptr;
+        size = 0;
+    }
+
+    ~MappedFile()
+    {
+        close();
+    }
+
+    bool open(const string& path)
+    {
+        close();
+#if defined(__unix__) || defined(__APPLE__)
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        void* p = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return false;
+        data = static_cast<const char*>(p);
+        size = static_cast<size_t>(info.st_size);
+        return true;
+#else
+        ifstream in(path, ios::binary);
+        if (!in) return false;
+        copy.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+        data = copy.data();
+        size = copy.size();
+        return size > 0;
+#endif
+    }
+
+    void close()
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        if (data) munmap(const_cast<char*>(data), size);
+#endif
+        vector<char>().swap(copy);
+        data = nullptr;
+        size = 0;
+    }
+
+    // Tell the kernel whether the mapping is about to be read front to back
+    // (read ahead) or at random (read only the pages touched)
+    void advise(bool sequential) const
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        if (data) madvise(const_cast<char*>(data), size, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+#else
+        (void)sequential;
+#endif
+    }
+};
+
+const char SNAPSHOT_MAGIC[8] = { 'P', 'M', 'S', 'N', 'A', 'P', '0', '1' };
+const uint32_t SNAPSHOT_ENDIAN_TAG = 0x01020304;
+
+// Header at offset 0 of a snapshot file. The tables follow it, 8-byte aligned:
+//   uint64_t prefixes[count]       keyPrefix() of each name, in name order
+//   SnapshotEntry entries[count]   where each name and password lives in the data
+//   SnapshotReuse reuse[count]     (password hash, entry) sorted by hash
+//   name and password bytes
+struct SnapshotHeader
+{
+    char magic[8];
+    uint32_t count;
+    uint32_t endianTag;     // SNAPSHOT_ENDIAN_TAG as written by the host
+    uint64_t hashKey0;      // keyedHash keys of the reuse table
+    uint64_t hashKey1;
+    uint8_t keySalt[VAULT_SALT_BYTES];  // VaultKey::salt the records are sealed under
+    uint64_t prefixOffset;
+    uint64_t entryOffset;
+    uint64_t reuseOffset;
+    uint64_t dataOffset;
+    uint64_t fileSize;
+    uint32_t headerCrc;     // crc32 of every field above
+    uint32_t reserved;
+};
+
+struct SnapshotEntry
+{
+    uint32_t nameOffset;      // Relative to dataOffset
+    uint32_t nameSize;
+    uint32_t passwordOffset;
+    uint32_t passwordSize;
+};
+
+struct SnapshotReuse
+{
+    uint32_t hash;    // Low 32 bits of keyedHash(encrypted password)
+    uint32_t entry;
+};
+
+// Read-only, name-sorted base layer of a VaultStore, backed by a snapshot file.
+// Opening maps the file and checks the header; no record is parsed or copied.
+// Lookups binary-search the prefix table. Records that were changed or deleted
+// since are hidden by a bitmap, allocated on the first change.
+struct VaultSnapshot
+{
+    MappedFile file;
+    const SnapshotHeader* header;
+    const uint64_t* prefixes;
+    const SnapshotEntry* entries;
+    const SnapshotReuse* reuse;
+    const char* data;
+    uint64_t dataSize;
+    uint32_t count;
+    vector<uint64_t> hidden;
+    uint32_t hiddenCount;
+
+    VaultSnapshot()
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        header = nullptr;
+        prefixes = nullptr;
+        entries = nullptr;
+        reuse = nullptr;
+        data = nullptr;
+        dataSize = 0;
+        count = 0;
+        vector<uint64_t>().swap(hidden);
+        hiddenCount = 0;
+    }
+
+    // Map a snapshot; false if it is missing or fails the header checks
+    bool open(const string& path)
+    {
+        close();
+        if (!file.open(path)) return false;
+
+        const SnapshotHeader* h = reinterpret_cast<const SnapshotHeader*>(file.data);
+        uint64_t n = file.size >= sizeof(SnapshotHeader) ? h->count : 0;
+        bool valid = file.size >= sizeof(SnapshotHeader)
+            && memcmp(h->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0
+            && h->endianTag == SNAPSHOT_ENDIAN_TAG
+            && h->headerCrc == crc32(file.data, offsetof(SnapshotHeader, headerCrc))
+            && h->fileSize == file.size
+            && h->prefixOffset % 8 == 0 && h->entryOffset % 8 == 0 && h->reuseOffset % 8 == 0
+            && h->prefixOffset >= sizeof(SnapshotHeader)
+            && h->entryOffset >= h->prefixOffset + n * sizeof(uint64_t)
+            && h->reuseOffset >= h->entryOffset + n * sizeof(SnapshotEntry)
+            && h->dataOffset >= h->reuseOffset + n * sizeof(SnapshotReuse)
+            && h->dataOffset <= file.size;
+        if (!valid)
+        {
+            file.close();
+            return false;
+        }
+
+        header = h;
+        prefixes = reinterpret_cast<const uint64_t*>(file.data + h->prefixOffset);
+        entries = reinterpret_cast<const SnapshotEntry*>(file.data + h->entryOffset);
+        reuse = reinterpret_cast<const SnapshotReuse*>(file.data + h->reuseOffset);
+        data = file.data + h->dataOffset;
+        dataSize = file.size - h->dataOffset;
+        count = h->count;
+        return true;
+    }
+
+    void close()
+    {
+        file.close();
+        reset();
+    }
+
+    // Bytes of a record; out-of-range offsets (a damaged file) read as empty
+    string_view bytesAt(uint32_t offset, uint32_t size) const
+    {
+        if (static_cast<uint64_t>(offset) + size > dataSize) return string_view();
+        return string_view(data + offset, size);
+    }
+
+    string_view nameAt(uint32_t i) const
+    {
+        return bytesAt(entries[i].nameOffset, entries[i].nameSize);
+    }
+
+    string_view passwordAt(uint32_t i) const
+    {
+        return bytesAt(entries[i].passwordOffset, entries[i].passwordSize);
+    }
+
+    bool isHidden(uint32_t i) const
+    {
+        return !hidden.empty() && (hidden[i >> 6] >> (i & 63) & 1);
+    }
+
+    void hide(uint32_t i)
+    {
+        if (hidden.empty()) hidden.assign((count + 63) / 64, 0);
+        if (!isHidden(i))
+        {
+            hidden[i >> 6] |= 1ULL << (i & 63);
+            hiddenCount++;
+        }
+    }
+
+    uint32_t liveCount() const
+    {
+        return count - hiddenCount;
+    }
+
+    // First record whose name is >= name (count if none)
+    uint32_t lowerBound(string_view name) const
+    {
+        uint64_t prefix = keyPrefix(name);
+        uint32_t lo = 0;
+        uint32_t hi = count;
+        while (lo < hi)
+        {
+            uint32_t mid = lo + (hi - lo) / 2;
+            bool less = prefixes[mid] != prefix ? prefixes[mid] < prefix : nameAt(mid) < name;
+            if (less) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    // Visible record with this name (NIL if none)
+    uint32_t search(string_view name) const
+    {
+        uint32_t i = lowerBound(name);
+        return i < count && !isHidden(i) && nameAt(i) == name ? i : NIL;
+    }
+
+    // Keyed hash of a stored password, as the reuse table is sorted by
+    uint32_t reuseHash(string_view encryptedPassword) const
+    {
+        return static_cast<uint32_t>(keyedHash(encryptedPassword, header->hashKey0, header->hashKey1));
+    }
+
+    // First row of the reuse table whose hash is >= hash (count if none)
+    uint32_t reuseRow(uint32_t hash) const
+    {
+        uint32_t lo = 0;
+        uint32_t hi = count;
+        while (lo < hi)
+        {
+            uint32_t mid = lo + (hi - lo) / 2;
+            if (reuse[mid].hash < hash) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    // Visible record other than excludeAccount storing this password (NIL if none)
+    uint32_t findOther(string_view encryptedPassword, string_view excludeAccount) const
+    {
+        if (count == 0) return NIL;
+        uint32_t hash = reuseHash(encryptedPassword);
+        for (uint32_t i = reuseRow(hash); i < count && reuse[i].hash == hash; i++)
+        {
+            uint32_t e = reuse[i].entry;
+            if (e < count && !isHidden(e) && passwordAt(e) == encryptedPassword && nameAt(e) != excludeAccount)
+            {
+                return e;
+            }
+        }
+        return NIL;
+    }
+};
+
+// In-order walk over a VaultStore, merging the in-memory tree with the visible
+// snapshot records. A record that comes from the snapshot is returned through a
+// scratch node that stays valid only until the following next().
+struct VaultIterator
+{
+    AccountIterator tree;
+    const VaultSnapshot* base;
+    uint32_t baseIndex;
+    PasswordNode* treeNext;
+    PasswordNode scratch;
+
+    VaultIterator(AccountBST* bst, const VaultSnapshot* snapshot) : tree(bst)
+    {
+        base = snapshot;
+        baseIndex = 0;
+        skipHidden();
+        treeNext = tree.hasNext() ? tree.next() : nullptr;
+        scratch.slot = NIL;
+    }
+
+    void skipHidden()
+    {
+        while (baseIndex < base->count && base->isHidden(baseIndex)) baseIndex++;
+    }
+
+    // Reposition at the first account name >= key
+    void seek(string_view key)
+    {
+        tree.seek(key);
+        treeNext = tree.hasNext() ? tree.next() : nullptr;
+        baseIndex = base->count ? base->lowerBound(key) : 0;
+        skipHidden();
+    }
+
+    bool hasNext() const
+    {
+        return treeNext || baseIndex < base->count;
+    }
+
+    PasswordNode* next()
+    {
+        if (baseIndex < base->count && (!treeNext || base->nameAt(baseIndex) < treeNext->accountName))
+        {
+            scratch.accountName = base->nameAt(baseIndex);
+            scratch.password = base->passwordAt(baseIndex);
+            baseIndex++;
+            skipHidden();
+            return &scratch;
+        }
+        PasswordNode* node = treeNext;
+        treeNext = tree.hasNext() ? tree.next() : nullptr;
+        return node;
+    }
+};
+
+// ---- Read views ----
+//
+// Scans that must not hold up writers (a long listing next to busy edits) read a
+// published version of the vault instead of the live indexes: a persistent AVL
+// tree of (name, stored password) nodes that never change once published. A
+// change copies only the nodes on its path, O(log n), and publishes the new root
+// with one atomic store, so a reader keeps one consistent version for as long as
+// it likes without taking a lock. Replaced nodes are freed by epoch-based
+// reclamation: each is tagged with the epoch it was retired in and freed once
+// every open view was pinned after that.
+
+const int READ_VIEW_SLOTS = 128;    // Views open at once over all vaults (more wait)
+const size_t RETIRE_BATCH = 64;     // Retired nodes between reclamation passes
+
+// Epochs pinned by open read views (0 = free slot), one cache line per slot so
+// readers on different cores do not write to the same line
+struct EpochDomain
+{
+    struct alignas(64) Slot
+    {
+        atomic<uint64_t> pinned{ 0 };
+    };
+
+    atomic<uint64_t> epoch{ 1 };
+    Slot slots[READ_VIEW_SLOTS];
+
+    // Pin the current epoch in a free slot
+    int enter()
+    {
+        int start = static_cast<int>(hash<thread::id>()(this_thread::get_id()) % READ_VIEW_SLOTS);
+        while (true)
+        {
+            for (int i = 0; i < READ_VIEW_SLOTS; i++)
+            {
+                int s = (start + i) % READ_VIEW_SLOTS;
+                uint64_t free = 0;
+                if (slots[s].pinned.load() == 0 && slots[s].pinned.compare_exchange_strong(free, epoch.load()))
+                {
+                    return s;
+                }
+            }
+            this_thread::yield();
+        }
+    }
+
+    void leave(int slot)
+    {
+        slots[slot].pinned.store(0);
+    }
+
+    // Oldest epoch an open view is pinned at (UINT64_MAX if none)
+    uint64_t oldestPinned()
+    {
+        uint64_t oldest = UINT64_MAX;
+        for (Slot& slot : slots)
+        {
+            uint64_t pinned = slot.pinned.load();
+            if (pinned != 0 && pinned < oldest) oldest = pinned;
+        }
+        return oldest;
+    }
+};
+
+EpochDomain readEpochs;
+
+// One node of a published version: children, AVL height, and the record's name
+// and stored password in the same allocation, right after the node
+struct VersionNode
+{
+    VersionNode* left;
+    VersionNode* right;
+    uint64_t change;        // Change that created it (only the change being built edits nodes)
+    int32_t height;
+    uint32_t nameSize;
+    uint32_t passwordSize;
+
+    string_view name() const
+    {
+        return string_view(reinterpret_cast<const char*>(this + 1), nameSize);
+    }
+
+    string_view password() const
+    {
+        return string_view(reinterpret_cast<const char*>(this + 1) + nameSize, passwordSize);
+    }
+};
+
+// In-order walk over one version, same explicit-stack scheme as AccountIterator
+struct VersionIterator
+{
+    const VersionNode* stack[MAX_TREE_DEPTH];
+    int depth;
+
+    VersionIterator(const VersionNode* root)
+    {
+        depth = 0;
+        pushLeftSpine(root);
+    }
+
+    void pushLeftSpine(const VersionNode* node)
+    {
+        for (; node; node = node->left) stack[depth++] = node;
+    }
+
+    // Reposition at the first name >= key in the version rooted at root
+    void seek(const VersionNode* root, string_view key)
+    {
+        depth = 0;
+        while (root)
+        {
+            if (key <= root->name())
+            {
+                stack[depth++] = root;
+                root = root->left;
+            }
+            else
+            {
+                root = root->right;
+            }
+        }
+    }
+
+    bool hasNext() const
+    {
+        return depth > 0;
+    }
+
+    const VersionNode* next()
+    {
+        const VersionNode* node = stack[--depth];
+        pushLeftSpine(node->right);
+        return node;
+    }
+};
+
+// Writer side of the read views of one vault. Changed only by the vault's writer
+// (under the session's exclusive lock); readers only load published.
+struct VaultVersions
+{
+    atomic<VersionNode*> published{ nullptr };
+    atomic<bool> enabled{ false };  // Kept up to date by the vault; off until a view is wanted
+    VersionNode* root = nullptr;    // The writer's copy of published
+    uint64_t change = 1;            // Serial of the change being built
+    vector<VersionNode*> superseded;               // Replaced by the change being built
+    vector<pair<uint64_t, VersionNode*>> retired;  // (epoch, node) waiting for views, oldest first
+    size_t collectAt = RETIRE_BATCH;
+
+    VaultVersions() = default;
+    VaultVersions(const VaultVersions&) = delete;
+    VaultVersions& operator=(const VaultVersions&) = delete;
+
+    // No view of this vault may still be open
+    ~VaultVersions()
+    {
+        destroy(root);
+        for (VersionNode* node : superseded) release(node);
+        for (auto& entry : retired) release(entry.second);
+    }
+
+    VersionNode* make(string_view name, string_view password, VersionNode* left, VersionNode* right)
+    {
+        VersionNode* node = static_cast<VersionNode*>(::operator new(sizeof(VersionNode) + name.size() + password.size()));
+        node->left = left;
+        node->right = right;
+        node->change = change;
+        node->nameSize = static_cast<uint32_t>(name.size());
+        node->passwordSize = static_cast<uint32_t>(password.size());
+        char* bytes = reinterpret_cast<char*>(node + 1);
+        memcpy(bytes, name.data(), name.size());
+        memcpy(bytes + name.size(), password.data(), password.size());
+        updateHeight(node);
+        return node;
+    }
+
+    // Free a node, wiping its bytes first like the arena does
+    static void release(VersionNode* node)
+    {
+        memset(node + 1, 0, node->nameSize + node->passwordSize);
+        ::operator delete(node);
+    }
+
+    static void destroy(VersionNode* node)
+    {
+        if (!node) return;
+        destroy(node->left);
+        destroy(node->right);
+        release(node);
+    }
+
+    // Retire every node of a version (it is replaced as a whole)
+    void supersedeAll(VersionNode* node)
+    {
+        if (!node) return;
+        supersedeAll(node->left);
+        supersedeAll(node->right);
+        superseded.push_back(node);
+    }
+
+    static int heightOf(const VersionNode* node)
+    {
+        return node ? node->height : 0;
+    }
+
+    static void updateHeight(VersionNode* node)
+    {
+        int lh = heightOf(node->left);
+        int rh = heightOf(node->right);
+        node->height = 1 + (lh > rh ? lh : rh);
+    }
+
+    // The node itself if this change created it, else a copy that replaces it
+    VersionNode* writable(VersionNode* node)
+    {
+        if (node->change == change) return node;
+        superseded.push_back(node);
+        return make(node->name(), node->password(), node->left, node->right);
+    }
+
+    // Rotations and rebalancing as in AccountBST, on nodes of the change being
+    // built (a child that moves is copied first)
+    VersionNode* rotateRight(VersionNode* node)
+    {
+        VersionNode* pivot = writable(node->left);
+        node->left = pivot->right;
+        pivot->right = node;
+        updateHeight(node);
+        updateHeight(pivot);
+        return pivot;
+    }
+
+    VersionNode* rotateLeft(VersionNode* node)
+    {
+        VersionNode* pivot = writable(node->right);
+        node->right = pivot->left;
+        pivot->left = node;
+        updateHeight(node);
+        updateHeight(pivot);
+        return pivot;
+    }
+
+    VersionNode* rebalance(VersionNode* node)
+    {
+        updateHeight(node);
+        int balance = heightOf(node->left) - heightOf(node->right);
+        if (balance > 1)
+        {
+            if (heightOf(node->left->left) < heightOf(node->left->right))
+            {
+                node->left = rotateLeft(writable(node->left));
+            }
+            return rotateRight(node);
+        }
+        if (balance < -1)
+        {
+            if (heightOf(node->right->right) < heightOf(node->right->left))
+            {
+                node->right = rotateRight(writable(node->right));
+            }
+            return rotateLeft(node);
+        }
+        return node;
+    }
+
+    VersionNode* insertAt(VersionNode* node, string_view name, string_view password)
+    {
+        if (!node) return make(name, password, nullptr, nullptr);
+        int cmp = name.compare(node->name());
+        if (cmp == 0)
+        {
+            superseded.push_back(node);
+            return make(name, password, node->left, node->right);
+        }
+        node = writable(node);
+        if (cmp < 0) node->left = insertAt(node->left, name, password);
+        else node->right = insertAt(node->right, name, password);
+        return rebalance(node);
+    }
+
+    // Remove a name that is present
+    VersionNode* eraseAt(VersionNode* node, string_view name)
+    {
+        if (!node) return nullptr;
+        int cmp = name.compare(node->name());
+        if (cmp == 0)
+        {
+            superseded.push_back(node);
+            if (!node->left || !node->right) return node->left ? node->left : node->right;
+
+            // Two children: the in-order successor's record moves up into a new node
+            const VersionNode* successor = node->right;
+            while (successor->left) successor = successor->left;
+            VersionNode* moved = make(successor->name(), successor->password(), node->left, nullptr);
+            moved->right = eraseAt(node->right, moved->name());
+            return rebalance(moved);
+        }
+        node = writable(node);
+        if (cmp < 0) node->left = eraseAt(node->left, name);
+        else node->right = eraseAt(node->right, name);
+        return rebalance(node);
+    }
+
+    VersionNode* buildHelper(const vector<pair<string_view, string_view>>& sorted, size_t lo, size_t hi)
+    {
+        if (lo >= hi) return nullptr;
+        size_t mid = lo + (hi - lo) / 2;
+        VersionNode* left = buildHelper(sorted, lo, mid);
+        VersionNode* right = buildHelper(sorted, mid + 1, hi);
+        return make(sorted[mid].first, sorted[mid].second, left, right);
+    }
+
+    // Make root the version views see, and retire what it replaced
+    void publish()
+    {
+        published.store(root);
+        change++;
+        if (superseded.empty()) return;
+        uint64_t epoch = readEpochs.epoch.fetch_add(1);
+        for (VersionNode* node : superseded) retired.emplace_back(epoch, node);
+        superseded.clear();
+        if (retired.size() >= collectAt) collect();
+    }
+
+    // Free the retired nodes no open view can reach any more
+    void collect()
+    {
+        uint64_t oldest = readEpochs.oldestPinned();
+        size_t n = 0;
+        while (n < retired.size() && retired[n].first < oldest) release(retired[n++].second);
+        retired.erase(retired.begin(), retired.begin() + n);
+        collectAt = retired.size() + RETIRE_BATCH;
+    }
+
+    // Insert or replace one record
+    void put(string_view name, string_view password)
+    {
+        root = insertAt(root, name, password);
+        publish();
+    }
+
+    void erase(string_view name)
+    {
+        root = eraseAt(root, name);
+        publish();
+    }
+
+    // Publish a version built from name-sorted records in O(n) and keep it current
+    void rebuild(const vector<pair<string_view, string_view>>& sorted)
+    {
+        supersedeAll(root);
+        root = buildHelper(sorted, 0, sorted.size());
+        publish();
+        enabled = true;
+    }
+
+    // Stop keeping versions (the vault is being dropped); open views keep theirs
+    void disable()
+    {
+        enabled = false;
+        supersedeAll(root);
+        root = nullptr;
+        publish();
+    }
+};
+
+// A consistent version of one vault, readable without any lock and pinned until
+// the view is destroyed. Writers keep changing the vault meanwhile; the view
+// does not see those changes. Must be closed before the vault is dropped.
+struct VaultReadView
+{
+    int slot;
+    const VersionNode* root;
+
+    explicit VaultReadView(const VaultVersions& versions)
+    {
+        slot = readEpochs.enter();
+        root = versions.published.load();
+    }
+
+    VaultReadView(VaultReadView&& other)
+    {
+        slot = other.slot;
+        root = other.root;
+        other.slot = -1;
+    }
+
+    VaultReadView(const VaultReadView&) = delete;
+    VaultReadView& operator=(const VaultReadView&) = delete;
+
+    ~VaultReadView()
+    {
+        if (slot >= 0) readEpochs.leave(slot);
+    }
+
+    bool isEmpty() const
+    {
+        return root == nullptr;
+    }
+
+    VersionIterator begin() const
+    {
+        return VersionIterator(root);
+    }
+
+    // Iterator positioned at the first account name >= key
+    VersionIterator lowerBound(string_view key) const
+    {
+        VersionIterator it(nullptr);
+        it.seek(root, key);
+        return it;
+    }
+};
+
+// ---- Fuzzy name lookup ----
+
+const int FUZZY_MAX_DISTANCE = 4;         // Most edits a fuzzy lookup will allow
+const uint8_t FUZZY_LENGTH_CAP = 250;     // Longer names are filtered as if this long
+const uint8_t FUZZY_NO_NAME = 255;        // Length of a free slot; never passes the filter
+const size_t FUZZY_HEAD_BYTES = 16;       // Names this short are matched from the filter's own copy
+
+inline unsigned char foldCase(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c - 'A' + 'a') : static_cast<unsigned char>(c);
+}
+
+inline int popCount(uint64_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(x);
+#else
+    int n = 0;
+    for (; x; x &= x - 1) n++;
+    return n;
+#endif
+}
+
+// 128-bit set of hashed case-folded bigrams. One edit destroys at most three
+// bigrams of a name (a swap of xy in axyb: ax, xy and yb), so a name within k
+// edits of a query lacks at most 3k of the query's bits.
+struct BigramMask
+{
+    uint64_t bits[2];
+
+    // Query bits this mask lacks
+    int missing(const BigramMask& query) const
+    {
+        return popCount(query.bits[0] & ~bits[0]) + popCount(query.bits[1] & ~bits[1]);
+    }
+};
+
+// Byte class of a name byte for the presence filter: the case-folded byte mod 64.
+// An edit drops at most one byte, so a name within k edits of a query lacks at
+// most k of the query's classes.
+inline int byteClass(char c)
+{
+    return foldCase(c) & 63;
+}
+
+BigramMask bigramMask(string_view s)
+{
+    BigramMask mask = { { 0, 0 } };
+    for (size_t i = 1; i < s.size(); i++)
+    {
+        uint32_t bit = ((foldCase(s[i - 1]) << 8 | foldCase(s[i])) * 0x9E3779B1u) >> 25;
+        mask.bits[bit >> 6] |= 1ULL << (bit & 63);
+    }
+    return mask;
+}
+
+// Case-insensitive edit distance of a name from a query of at most 64 bytes,
+// counting insertions, deletions, substitutions and swaps of adjacent bytes
+// (optimal string alignment, so "gmial" is one edit from "gmail"). Computed 64
+// cells at a time with Hyyro's bit-vector form of Myers' algorithm. Gives up and
+// returns maxDistance + 1 once the distance cannot come back within maxDistance.
+struct BitParallelMatcher
+{
+    uint64_t peq[256];    // Bit i set where the query has that (folded) byte
+    uint64_t last;        // Bit of the query's last position
+    int m;
+
+    explicit BitParallelMatcher(string_view query)
+    {
+        memset(peq, 0, sizeof(peq));
+        m = static_cast<int>(query.size());
+        for (int i = 0; i < m; i++) peq[foldCase(query[i])] |= 1ULL << i;
+        last = m ? 1ULL << (m - 1) : 0;
+    }
+
+    int distance(string_view text, int maxDistance) const
+    {
+        int n = static_cast<int>(text.size());
+        if (m == 0) return min(n, maxDistance + 1);
+        uint64_t vp = m == 64 ? ~0ULL : (1ULL << m) - 1;
+        uint64_t vn = 0;
+        uint64_t d0 = 0;
+        uint64_t previousEq = 0;
+        int score = m;
+        for (int j = 0; j < n; j++)
+        {
+            uint64_t eq = peq[foldCase(text[j])];
+            uint64_t swapped = ((~d0 & eq) << 1) & previousEq;
+            d0 = (((eq & vp) + vp) ^ vp) | eq | vn | swapped;
+            uint64_t hp = vn | ~(d0 | vp);
+            uint64_t hn = d0 & vp;
+            if (hp & last) score++;
+            else if (hn & last) score--;
+            hp = (hp << 1) | 1;   // Row 0 of the table grows by one per text byte
+            hn <<= 1;
+            vp = hn | ~(d0 | hp);
+            vn = hp & d0;
+            previousEq = eq;
+            if (score - (n - j - 1) > maxDistance) return maxDistance + 1;
+        }
+        return min(score, maxDistance + 1);
+    }
+};
+
+// The same distance by plain dynamic programming, for queries longer than one
+// machine word
+int editDistance(string_view a, string_view b, int maxDistance)
+{
+    size_t width = b.size() + 1;
+    vector<int> rows(3 * width);
+    int* before = &rows[0];
+    int* above = &rows[width];
+    int* row = &rows[2 * width];
+    for (size_t j = 0; j < width; j++) above[j] = static_cast<int>(j);
+    for (size_t i = 1; i <= a.size(); i++)
+    {
+        row[0] = static_cast<int>(i);
+        int best = row[0];
+        for (size_t j = 1; j < width; j++)
+        {
+            unsigned char x = foldCase(a[i - 1]);
+            unsigned char y = foldCase(b[j - 1]);
+            row[j] = min({ above[j] + 1, row[j - 1] + 1, above[j - 1] + (x != y) });
+            if (i > 1 && j > 1 && x == foldCase(b[j - 2]) && foldCase(a[i - 2]) == y)
+            {
+                row[j] = min(row[j], before[j - 2] + 1);
+            }
+            best = min(best, row[j]);
+        }
+        if (best > maxDistance) return maxDistance + 1;
+        int* oldest = before;
+        before = above;
+        above = row;
+        row = oldest;
+    }
+    return min(above[b.size()], maxDistance + 1);
+}
+
+// A query ready for matching: bit-parallel when it fits in a machine word
+struct FuzzyQuery
+{
+    string_view text;
+    BitParallelMatcher matcher;
+
+    explicit FuzzyQuery(string_view query) : text(query), matcher(query.size() <= 64 ? query : string_view())
+    {
+    }
+
+    int distance(string_view name, int maxDistance) const
+    {
+        return text.size() <= 64 ? matcher.distance(name, maxDistance) : editDistance(text, name, maxDistance);
+    }
+};
+
+// First bytes of a name, stored next to its filter signature
+struct NameHead
+{
+    char bytes[FUZZY_HEAD_BYTES];
+};
+
+// Filter signatures of the names with one capped length. Byte-class presence is
+// stored bit-sliced: per block of 64 names, one word per class with bit p set if
+// name p has it, so a query counts misses for 64 names at once over its own
+// classes only.
+struct FuzzyBucket
+{
+    vector<uint32_t> ids;
+    vector<BigramMask> masks;
+    vector<NameHead> heads;
+    vector<uint64_t> classBits;   // 64 words per block of 64 names
+
+    void push(uint32_t id, string_view name)
+    {
+        size_t p = ids.size();
+        if (p % 64 == 0) classBits.resize(p + 64, 0);
+        uint64_t* block = &classBits[p / 64 * 64];
+        for (char c : name) block[byteClass(c)] |= 1ULL << (p % 64);
+        NameHead head;
+        memcpy(head.bytes, name.data(), min(name.size(), FUZZY_HEAD_BYTES));
+        ids.push_back(id);
+        masks.push_back(bigramMask(name));
+        heads.push_back(head);
+    }
+
+    // Remove the name at position at by moving the last one into its place;
+    // returns the id that moved
+    uint32_t removeAt(size_t at)
+    {
+        size_t last = ids.size() - 1;
+        uint64_t* from = &classBits[last / 64 * 64];
+        uint64_t* to = &classBits[at / 64 * 64];
+        for (int c = 0; c < 64; c++)
+        {
+            uint64_t bit = from[c] >> (last % 64) & 1;
+            to[c] = (to[c] & ~(1ULL << (at % 64))) | bit << (at % 64);
+            from[c] &= ~(1ULL << (last % 64));
+        }
+        uint32_t moved = ids[last];
+        ids[at] = moved;
+        masks[at] = masks[last];
+        heads[at] = heads[last];
+        ids.pop_back();
+        masks.pop_back();
+        heads.pop_back();
+        if (last % 64 == 0) classBits.resize(last);
+        return moved;
+    }
+};
+
+// Per-record filter signatures grouped by capped name length, so a query reads
+// only the buckets within maxDistance of its own length. Names that pass the
+// filters are matched from their heads when they fit, so only names longer than
+// FUZZY_HEAD_BYTES are fetched from the records.
+struct FuzzySignatures
+{
+    vector<FuzzyBucket> buckets;   // By capped length
+    vector<uint8_t> lengths;       // Id -> bucket (FUZZY_NO_NAME if unset)
+    vector<uint32_t> positions;    // Id -> index in its bucket
+
+    void set(uint32_t i, string_view name)
+    {
+        unset(i);
+        if (i >= lengths.size())
+        {
+            lengths.resize(i + 1, FUZZY_NO_NAME);
+            positions.resize(i + 1);
+        }
+        if (buckets.empty()) buckets.resize(FUZZY_LENGTH_CAP + 1);
+
+        uint8_t length = static_cast<uint8_t>(min<size_t>(name.size(), FUZZY_LENGTH_CAP));
+        lengths[i] = length;
+        positions[i] = static_cast<uint32_t>(buckets[length].ids.size());
+        buckets[length].push(i, name);
+    }
+
+    void unset(uint32_t i)
+    {
+        if (i >= lengths.size() || lengths[i] == FUZZY_NO_NAME) return;
+        uint32_t moved = buckets[lengths[i]].removeAt(positions[i]);
+        positions[moved] = positions[i];
+        lengths[i] = FUZZY_NO_NAME;
+    }
+
+    // Calls visit(id, distance) for every id within maxDistance edits of the
+    // query; nameOf(id) supplies names too long for their head
+    template <typename NameOf, typename Visit>
+    void scan(const FuzzyQuery& query, int maxDistance, NameOf nameOf, Visit visit) const
+    {
+        if (buckets.empty()) return;
+        int m = static_cast<int>(min<size_t>(query.text.size(), FUZZY_LENGTH_CAP));
+        BigramMask queryMask = bigramMask(query.text);
+        uint64_t queryClasses = 0;
+        for (char c : query.text) queryClasses |= 1ULL << byteClass(c);
+        int classes[64];
+        int classCount = 0;
+        for (int c = 0; c < 64; c++)
+        {
+            if (queryClasses >> c & 1) classes[classCount++] = c;
+        }
+
+        int first = max(0, m - maxDistance);
+        int last = min<int>(FUZZY_LENGTH_CAP, m + maxDistance);
+        for (int length = first; length <= last; length++)
+        {
+            const FuzzyBucket& bucket = buckets[length];
+            size_t n = bucket.ids.size();
+            for (size_t start = 0; start < n; start += 64)
+            {
+                // within[e]: names in this block lacking exactly e of the query's classes
+                const uint64_t* block = &bucket.classBits[start];
+                uint64_t within[FUZZY_MAX_DISTANCE + 1] = { ~0ULL };
+                for (int c = 0; c < classCount; c++)
+                {
+                    uint64_t lacking = ~block[classes[c]];
+                    for (int e = maxDistance; e > 0; e--)
+                    {
+                        within[e] = (within[e] & ~lacking) | (within[e - 1] & lacking);
+                    }
+                    within[0] &= ~lacking;
+                }
+                uint64_t pass = 0;
+                for (int e = 0; e <= maxDistance; e++) pass |= within[e];
+                if (n - start < 64) pass &= (1ULL << (n - start)) - 1;
+
+                for (size_t j = start; pass; j++, pass >>= 1)
+                {
+                    if (!(pass & 1) || bucket.masks[j].missing(queryMask) > 3 * maxDistance) continue;
+                    string_view name = static_cast<size_t>(length) <= FUZZY_HEAD_BYTES
+                        ? string_view(bucket.heads[j].bytes, length)
+                        : nameOf(bucket.ids[j]);
+                    int d = query.distance(name, maxDistance);
+                    if (d <= maxDistance) visit(bucket.ids[j], d);
+                }
+            }
+        }
+    }
+
+    void reset()
+    {
+        vector<FuzzyBucket>().swap(buckets);
+        vector<uint8_t>().swap(lengths);
+        vector<uint32_t>().swap(positions);
+    }
+};
+
+// A fuzzy match: a name and its edit distance from the query
+struct FuzzyMatch
+{
+    string_view name;
+    int distance;
+};
+
+// Edits tolerated when suggesting names for a typed one of this length
+int typoBudget(size_t length)
+{
+    return length <= 5 ? 1 : length <= 12 ? 2 : 3;
+}
+
+// The vault: record slab plus the name and reuse indexes, kept in sync here.
+// An optional snapshot sits underneath as a read-only base layer; a snapshot
+// record is copied into the slab and indexes (and hidden in the base) the first
+// time it is looked up, so every PasswordNode* handed out is a slab record.
+struct VaultStore
+{
+    RecordSlab records;
+    AccountBST bst;                 // Account name -> slot, sorted (listing, import)
+    AccountHashIndex nameIndex;     // Account name -> slot, exact-match lookups
+    PasswordReuseIndex reuseIndex;  // Stored password hash -> slots using it
+    VaultSnapshot base;             // Records from the last checkpoint (may be empty)
+    FuzzySignatures signatures;     // Slot -> fuzzy filter signature
+    FuzzySignatures baseSignatures; // Snapshot record -> signature, built on first fuzzy lookup
+    vector<uint8_t> baseStrengths;  // Snapshot record -> strength score, filled in by audits
+    VaultVersions versions;         // Published versions for read views, once enabled
+    VaultKey key;                   // Seals and opens the records' passwords (kept by clear())
+
+    VaultStore() : bst(&records), nameIndex(&records), reuseIndex(&records)
+    {
+    }
+
+    // Serve an empty vault from a snapshot file; false if it is missing, invalid,
+    // or sealed under another salt than key's (part of some other vault)
+    bool attachSnapshot(const string& path)
+    {
+        clear();
+        if (!base.open(path)) return false;
+        if (memcmp(base.header->keySalt, key.salt, VAULT_SALT_BYTES) == 0) return true;
+        base.close();
+        return false;
+    }
+
+    // Copy snapshot record i into the slab and indexes and hide it in the base
+    PasswordNode* promote(uint32_t i)
+    {
+        uint32_t slot = records.allocate(base.nameAt(i), base.passwordAt(i));
+        if (!baseStrengths.empty()) records.at(slot).strength = baseStrengths[i];
+        signatures.set(slot, base.nameAt(i));
+        bst.insert(slot);
+        nameIndex.add(slot);
+        reuseIndex.add(slot);
+        base.hide(i);
+        return &records.at(slot);
+    }
+
+    // Record for an account name (nullptr if not found)
+    PasswordNode* find(string_view accountName)
+    {
+        uint32_t slot = nameIndex.search(accountName);
+        if (slot != NIL)
+        {
+            return &records.at(slot);
+        }
+        uint32_t i = base.count ? base.search(accountName) : NIL;
+        return i == NIL ? nullptr : promote(i);
+    }
+
+    // Stored (encrypted) password of an account without changing the vault: a
+    // snapshot record is read in place instead of promoted, so any number of
+    // readers may call this at once. False if not found.
+    bool lookup(string_view accountName, string_view& encryptedPassword) const
+    {
+        uint32_t slot = nameIndex.search(accountName);
+        if (slot != NIL)
+        {
+            encryptedPassword = records.at(slot).password;
+            return true;
+        }
+        uint32_t i = base.count ? base.search(accountName) : NIL;
+        if (i == NIL)
+        {
+            return false;
+        }
+        encryptedPassword = base.passwordAt(i);
+        return true;
+    }
+
+    // Store a new record (nullptr if the account name is already taken);
+    // strength is the password's strengthScore if the caller knows it
+    PasswordNode* add(string_view accountName, string_view encryptedPassword, uint8_t strength = STRENGTH_UNKNOWN)
+    {
+        if (nameIndex.search(accountName) != NIL || (base.count && base.search(accountName) != NIL))
+        {
+            return nullptr;
+        }
+        uint32_t slot = records.allocate(accountName, encryptedPassword);
+        records.at(slot).strength = strength;
+        signatures.set(slot, accountName);
+        bst.insert(slot);
+        nameIndex.add(slot);
+        reuseIndex.add(slot);
+        if (versions.enabled) versions.put(accountName, encryptedPassword);
+        return &records.at(slot);
+    }
+
+    // Remove a record from both indexes and wipe it
+    void erase(PasswordNode* record)
+    {
+        uint32_t slot = record->slot;
+        if (versions.enabled) versions.erase(record->accountName);
+        bst.remove(slot);
+        nameIndex.remove(slot);
+        reuseIndex.remove(slot);
+        signatures.unset(slot);
+        records.release(slot);
+    }
+
+    void setPassword(PasswordNode* record, string_view encryptedPassword, uint8_t strength = STRENGTH_UNKNOWN)
+    {
+        reuseIndex.remove(record->slot);
+        records.setPassword(record->slot, encryptedPassword);
+        record->strength = strength;
+        reuseIndex.add(record->slot);
+        if (versions.enabled) versions.put(record->accountName, encryptedPassword);
+    }
+
+    // Another account already using this stored password (nullptr if none)
+    PasswordNode* findOtherWithPassword(string_view encryptedPassword, string_view excludeAccount)
+    {
+        PasswordNode* other = reuseIndex.findOther(encryptedPassword, excludeAccount);
+        if (other || base.count == 0)
+        {
+            return other;
+        }
+        uint32_t i = base.findOther(encryptedPassword, excludeAccount);
+        return i == NIL ? nullptr : promote(i);
+    }
+
+    // Merge name-sorted (account, encrypted password) pairs into the vault.
+    // Names already stored and repeated names are skipped. The snapshot stays
+    // mapped: each new name is looked up in its sorted table, and only the tree is
+    // rebuilt, from its own slots merged with the new ones in O(n). strengths, if
+    // given, holds each row's strength score. Returns the number of records added.
+    int bulkLoadSorted(const vector<pair<string, string>>& sorted, int& skipped, int& reused,
+        const vector<uint8_t>* strengths = nullptr)
+    {
+        vector<uint32_t> merged;
+        merged.reserve(bst.count + sorted.size());
+
+        AccountIterator it = bst.begin();
+        PasswordNode* current = it.hasNext() ? it.next() : nullptr;
+        size_t j = 0;
+        int added = 0;
+
+        while (current || j < sorted.size())
+        {
+            if (j == sorted.size() || (current && current->accountName <= sorted[j].first))
+            {
+                merged.push_back(current->slot);
+                current = it.hasNext() ? it.next() : nullptr;
+                continue;
+            }
+
+            const pair<string, string>& incoming = sorted[j++];
+            if ((!merged.empty() && records.at(merged.back()).accountName == incoming.first)
+                || (base.count && base.search(incoming.first) != NIL))
+            {
+                skipped++;
+                continue;
+            }
+
+            if (reuseIndex.findOther(incoming.second, incoming.first)
+                || (base.count && base.findOther(incoming.second, incoming.first) != NIL))
+            {
+                reused++;
+            }
+            uint32_t slot = records.allocate(incoming.first, incoming.second);
+            if (strengths) records.at(slot).strength = (*strengths)[j - 1];
+            signatures.set(slot, incoming.first);
+            nameIndex.add(slot);
+            reuseIndex.add(slot);
+            merged.push_back(slot);
+            added++;
+        }
+
+        bst.buildFromSorted(merged.data(), static_cast<int>(merged.size()));
+        if (versions.enabled) enableReadViews(true);
+        return added;
+    }
+
+    // Start publishing versions for VaultReadView (a no-op once on unless rebuild
+    // is set): one O(n) copy of the vault, then O(log n) extra work per change
+    void enableReadViews(bool rebuild = false)
+    {
+        if (versions.enabled && !rebuild) return;
+        vector<pair<string_view, string_view>> sorted;
+        sorted.reserve(size());
+        for (VaultIterator it = begin(); it.hasNext(); )
+        {
+            PasswordNode* node = it.next();
+            sorted.emplace_back(node->accountName, node->password);
+        }
+        versions.rebuild(sorted);
+    }
+
+    VaultIterator begin()
+    {
+        return VaultIterator(&bst, &base);
+    }
+
+    // Iterator positioned at the first account name >= key
+    VaultIterator lowerBound(string_view key)
+    {
+        VaultIterator it(&bst, &base);
+        it.seek(key);
+        return it;
+    }
+
+    // Up to maxCount account names starting with prefix, in sorted order, in
+    // O(log n + maxCount). The views stay valid until the vault next changes.
+    int withPrefix(string_view prefix, string_view out[], int maxCount)
+    {
+        int n = 0;
+        for (VaultIterator it = lowerBound(prefix); it.hasNext() && n < maxCount; )
+        {
+            string_view name = it.next()->accountName;
+            if (name.compare(0, prefix.size(), prefix) != 0) break;
+            out[n++] = name;
+        }
+        return n;
+    }
+
+    // Up to maxCount account names within maxDistance edits of query (case
+    // ignored), closest first, ties by name. Length and bigram filters rule out
+    // most names from flat arrays; the rest get the bit-parallel distance.
+    // The views stay valid until the vault next changes.
+    int closestNames(string_view query, int maxDistance, FuzzyMatch out[], int maxCount)
+    {
+        if (maxCount <= 0) return 0;
+        maxDistance = max(0, min(maxDistance, FUZZY_MAX_DISTANCE));
+        if (base.count && baseSignatures.lengths.empty())
+        {
+            for (uint32_t i = 0; i < base.count; i++) baseSignatures.set(i, base.nameAt(i));
+        }
+
+        FuzzyQuery fuzzy(query);
+        int n = 0;
+        auto consider = [&](string_view name, int d)
+        {
+            FuzzyMatch match = { name, d };
+            auto closer = [](const FuzzyMatch& a, const FuzzyMatch& b)
+            {
+                return a.distance != b.distance ? a.distance < b.distance : a.name < b.name;
+            };
+            if (n == maxCount && !closer(match, out[n - 1])) return;
+            int i = n < maxCount ? n++ : n - 1;
+            for (; i > 0 && closer(match, out[i - 1]); i--) out[i] = out[i - 1];
+            out[i] = match;
+        };
+
+        signatures.scan(fuzzy, maxDistance,
+            [&](uint32_t slot) { return records.at(slot).accountName; },
+            [&](uint32_t slot, int d) { consider(records.at(slot).accountName, d); });
+        baseSignatures.scan(fuzzy, maxDistance,
+            [&](uint32_t i) { return base.nameAt(i); },
+            [&](uint32_t i, int d) { if (!base.isHidden(i)) consider(base.nameAt(i), d); });
+        return n;
+    }
+
+    uint32_t size()
+    {
+        return records.liveCount + base.liveCount();
+    }
+
+    bool isEmpty()
+    {
+        return size() == 0;
+    }
+
+    // Drop the whole vault (logout): wipes every string and returns the memory.
+    // Each structure resets in one step rather than freeing records one by one.
+    void clear()
+    {
+        if (versions.enabled) versions.disable();
+        base.close();
+        signatures.reset();
+        baseSignatures.reset();
+        vector<uint8_t>().swap(baseStrengths);
+        bst.clear();
+        nameIndex.clear();
+        reuseIndex.clear();
+        records.reset();
+    }
+};
+
+// ==================== UNDO HISTORY ====================
+
+const size_t HISTORY_BUDGET_BYTES = 16 << 20;  // Default cap on undo + redo memory
+
+enum class ActionType : uint8_t
+{
+    Add,
+    Edit,
+    Delete
+};
+
+// One undo/redo step in 32 bytes. The account name is an id in the history's
+// NameTable and the encrypted passwords live in the history's ByteArena.
+struct Action
+{
+    const char* oldData;    // For Edit and Delete
+    const char* newData;    // For Add and Edit
+    uint32_t oldSize;
+    uint32_t newSize;
+    uint32_t name;
+    ActionType type;
+
+    string_view oldPassword() const
+    {
+        return string_view(oldData, oldSize);
+    }
+
+    string_view newPassword() const
+    {
+        return string_view(newData, newSize);
+    }
+};
+
+// Account names referenced by the history, stored once and reference-counted,
+// so a session that edits one account 100k times keeps a single copy of its name
+struct NameTable
+{
+    struct Name
+    {
+        string_view text;
+        uint32_t hash;
+        uint32_t refs;      // 0 = free id
+    };
+
+    vector<Name> names;
+    vector<uint32_t> freeIds;
+    vector<uint32_t> table;   // Open addressing over ids, NIL if empty
+    uint32_t count;
+    ByteArena bytes;
+    uint64_t key0;
+    uint64_t key1;
+
+    NameTable()
+    {
+        table.assign(64, NIL);
+        count = 0;
+
+        random_device rd;
+        key0 = (static_cast<uint64_t>(rd()) << 32) | rd();
+        key1 = (static_cast<uint64_t>(rd()) << 32) | rd();
+    }
+
+    // Bucket holding name, or the empty bucket where it would go
+    uint32_t findBucket(string_view name, uint32_t hash)
+    {
+        uint32_t mask = static_cast<uint32_t>(table.size()) - 1;
+        uint32_t i = hash & mask;
+        while (table[i] != NIL)
+        {
+            const Name& entry = names[table[i]];
+            if (entry.hash == hash && entry.text == name) break;
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+    // Double the table once it is half full
+    void grow()
+    {
+        vector<uint32_t> old(table.size() * 2, NIL);
+        old.swap(table);
+        uint32_t mask = static_cast<uint32_t>(table.size()) - 1;
+        for (uint32_t id : old)
+        {
+            if (id == NIL) continue;
+            uint32_t j = names[id].hash & mask;
+            while (table[j] != NIL) j = (j + 1) & mask;
+            table[j] = id;
+        }
+    }
+
+    // Id for name, storing it on first use; every acquire needs a release
+    uint32_t acquire(string_view name)
+    {
+        uint32_t hash = static_cast<uint32_t>(keyedHash(name, key0, key1));
+        uint32_t bucket = findBucket(name, hash);
+        if (table[bucket] != NIL)
+        {
+            names[table[bucket]].refs++;
+            return table[bucket];
+        }
+
+        if ((count + 1) * 2 > table.size())
+        {
+            grow();
+            bucket = findBucket(name, hash);
+        }
+
+        uint32_t id;
+        if (!freeIds.empty())
+        {
+            id = freeIds.back();
+            freeIds.pop_back();
+        }
+        else
+        {
+            id = static_cast<uint32_t>(names.size());
+            names.push_back(Name());
+        }
+        names[id] = { bytes.store(name), hash, 1 };
+        table[bucket] = id;
+        count++;
+        return id;
+    }
+
+    // Drop one reference; the last one unindexes and wipes the name
+    void release(uint32_t id)
+    {
+        Name& entry = names[id];
+        if (--entry.refs > 0) return;
+
+        // Backward-shift the rest of the probe run (no tombstones needed)
+        uint32_t mask = static_cast<uint32_t>(table.size()) - 1;
+        uint32_t i = findBucket(entry.text, entry.hash);
+        uint32_t j = i;
+        while (true)
+        {
+            j = (j + 1) & mask;
+            if (table[j] == NIL) break;
+            uint32_t home = names[table[j]].hash & mask;
+            if (((j - home) & mask) >= ((j - i) & mask))
+            {
+                table[i] = table[j];
+                i = j;
+            }
+        }
+        table[i] = NIL;
+        count--;
+
+        bytes.release(entry.text.data(), entry.text.size());
+        entry.text = string_view();
+        freeIds.push_back(id);
+    }
+
+    string_view text(uint32_t id) const
+    {
+        return names[id].text;
+    }
+
+    size_t bytesInUse() const
+    {
+        return count * sizeof(Name) + bytes.bytesInUse;
+    }
+
+    void clear()
+    {
+        vector<Name>().swap(names);
+        vector<uint32_t>().swap(freeIds);
+        table.assign(64, NIL);
+        table.shrink_to_fit();
+        count = 0;
+        bytes.reset();
+    }
+};
+
+// Double-ended ring of Actions: undo and redo work at the back, eviction
+// drops from the front. Capacity is a power of two and grows by doubling.
+struct ActionLog
+{
+    vector<Action> ring;
+    uint32_t head;      // Oldest entry
+    uint32_t count;
+
+    ActionLog()
+    {
+        head = 0;
+        count = 0;
+    }
+
+    void pushBack(const Action& action)
+    {
+        if (count == ring.size())
+        {
+            vector<Action> bigger(ring.empty() ? 64 : ring.size() * 2);
+            for (uint32_t i = 0; i < count; i++) bigger[i] = ring[(head + i) & (ring.size() - 1)];
+            ring.swap(bigger);
+            head = 0;
+        }
+        ring[(head + count) & (ring.size() - 1)] = action;
+        count++;
+    }
+
+    const Action& back() const
+    {
+        return ring[(head + count - 1) & (ring.size() - 1)];
+    }
+
+    Action popBack()
+    {
+        Action action = back();
+        count--;
+        return action;
+    }
+
+    Action popFront()
+    {
+        Action action = ring[head];
+        head = (head + 1) & (ring.size() - 1);
+        count--;
+        return action;
+    }
+
+    bool isEmpty() const
+    {
+        return count == 0;
+    }
+
+    void reset()
+    {
+        vector<Action>().swap(ring);
+        head = 0;
+        count = 0;
+    }
+};
+
+// Unbounded undo and redo logs sharing one name table and payload arena.
+// Memory is capped by budget: past it the oldest undo steps are evicted first,
+// then the oldest redo steps. Undo and redo move a 32-byte record between the
+// logs without copying any strings.
+struct ActionHistory
+{
+    NameTable names;
+    ByteArena payloads;
+    ActionLog undoLog;
+    ActionLog redoLog;
+    size_t budget;
+    unsigned long long evicted;   // Steps dropped to stay within budget
+
+    ActionHistory()
+    {
+        budget = HISTORY_BUDGET_BYTES;
+        evicted = 0;
+    }
+
+    size_t bytesInUse() const
+    {
+        return (undoLog.count + redoLog.count) * sizeof(Action) + payloads.bytesInUse + names.bytesInUse();
+    }
+
+    void release(const Action& action)
+    {
+        names.release(action.name);
+        payloads.release(action.oldData, action.oldSize);
+        payloads.release(action.newData, action.newSize);
+    }
+
+    // Record a new change; like any new change it invalidates the redo log
+    void record(ActionType type, string_view accountName, string_view oldPassword, string_view newPassword)
+    {
+        clearRedo();
+
+        Action action;
+        action.type = type;
+        action.name = names.acquire(accountName);
+        string_view oldStored = payloads.store(oldPassword);
+        string_view newStored = payloads.store(newPassword);
+        action.oldData = oldStored.data();
+        action.oldSize = static_cast<uint32_t>(oldStored.size());
+        action.newData = newStored.data();
+        action.newSize = static_cast<uint32_t>(newStored.size());
+        undoLog.pushBack(action);
+
+        enforceBudget();
+    }
+
+    // Evict oldest steps until within budget (the newest step is always kept)
+    void enforceBudget()
+    {
+        while (bytesInUse() > budget && undoLog.count > 1)
+        {
+            release(undoLog.popFront());
+            evicted++;
+        }
+        while (bytesInUse() > budget && !redoLog.isEmpty())
+        {
+            release(redoLog.popFront());
+            evicted++;
+        }
+    }
+
+    void setBudget(size_t bytes)
+    {
+        budget = bytes;
+        enforceBudget();
+    }
+
+    bool canUndo() const
+    {
+        return !undoLog.isEmpty();
+    }
+
+    bool canRedo() const
+    {
+        return !redoLog.isEmpty();
+    }
+
+    const Action& nextUndo() const
+    {
+        return undoLog.back();
+    }
+
+    const Action& nextRedo() const
+    {
+        return redoLog.back();
+    }
+
+    // Move the newest undo step onto the redo log
+    void markUndone()
+    {
+        redoLog.pushBack(undoLog.popBack());
+    }
+
+    // Move the newest redo step back onto the undo log
+    void markRedone()
+    {
+        undoLog.pushBack(redoLog.popBack());
+    }
+
+    string_view accountOf(const Action& action) const
+    {
+        return names.text(action.name);
+    }
+
+    void clearRedo()
+    {
+        while (!redoLog.isEmpty()) release(redoLog.popBack());
+    }
+
+    // Drop everything (logout); the arenas wipe and free per block
+    void clear()
+    {
+        undoLog.reset();
+        redoLog.reset();
+        names.clear();
+        payloads.reset();
+        evicted = 0;
+    }
+};
+
+// ==================== JOURNAL ====================
+
+// Force a stdio stream's written bytes to stable storage
+bool syncFile(FILE* file)
+{
+    if (fflush(file) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+const char JOURNAL_MAGIC[8] = { 'P', 'M', 'J', 'R', 'N', 'L', '0', '1' };
+const size_t JOURNAL_HEADER_BYTES = sizeof(JOURNAL_MAGIC) + VAULT_SALT_BYTES;  // Magic, then the vault's key salt
+const size_t JOURNAL_RECORD_HEADER = 13;  // crc32, type, name size, value size
+
+// Write-ahead journal of vault mutations. After the file header, each record is
+//   crc32 | type (ActionType) | name size | value size | name | encrypted value
+// with the CRC covering everything after itself. Records are buffered by append()
+// and made durable by commit(): one write and one fsync cover every record
+// appended since the last commit (group commit), so a burst of mutations or a
+// bulk import costs a single fsync.
+struct Journal
+{
+    FILE* file;               // nullptr = not persisted (appends are dropped)
+    string path;
+    vector<char> pending;     // Encoded records not yet committed
+    uint32_t pendingRecords;
+    uint64_t bytes;           // Committed size of the file
+    bool torn;                // A failed commit may have left part of a write past bytes
+    unsigned long long syncs;
+
+    Journal()
+    {
+        file = nullptr;
+        pendingRecords = 0;
+        bytes = 0;
+        torn = false;
+        syncs = 0;
+    }
+
+    ~Journal()
+    {
+        close();
+    }
+
+    static void putU32(vector<char>& out, uint32_t v)
+    {
+        char bytes[4] = { static_cast<char>(v), static_cast<char>(v >> 8), static_cast<char>(v >> 16), static_cast<char>(v >> 24) };
+        out.insert(out.end(), bytes, bytes + 4);
+    }
+
+    static uint32_t getU32(const char* p)
+    {
+        const uint8_t* b = reinterpret_cast<const uint8_t*>(p);
+        return b[0] | (b[1] << 8) | (b[2] << 16) | (static_cast<uint32_t>(b[3]) << 24);
+    }
+
+    // Apply one record: Add inserts if absent, Edit sets (or inserts), Delete erases
+    static void apply(VaultStore& vault, ActionType type, string_view name, string_view value)
+    {
+        PasswordNode* node = vault.find(name);
+        if (type == ActionType::Delete)
+        {
+            if (node) vault.erase(node);
+        }
+        else if (!node)
+        {
+            vault.add(name, value);
+        }
+        else if (type == ActionType::Edit)
+        {
+            vault.setPassword(node, value);
+        }
+    }
+
+    // Apply every intact record of a journal file to vault. validSize receives the
+    // length of the intact part (0 if the file is missing). Returns records
+    // applied, or -1 if the file exists but is not a journal of a vault with
+    // vault.key's salt.
+    static int replayFile(const string& journalPath, VaultStore& vault, uintmax_t& validSize)
+    {
+        validSize = 0;
+        MappedFile data;
+        if (!data.open(journalPath))
+        {
+            error_code ec;
+            return filesystem::file_size(journalPath, ec) > 0 && !ec ? -1 : 0;
+        }
+        if (data.size < JOURNAL_HEADER_BYTES || memcmp(data.data, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0
+            || memcmp(data.data + sizeof(JOURNAL_MAGIC), vault.key.salt, VAULT_SALT_BYTES) != 0)
+        {
+            return -1;  // Not this vault's journal; leave it alone
+        }
+
+        int replayed = 0;
+        size_t pos = JOURNAL_HEADER_BYTES;
+        while (data.size - pos >= JOURNAL_RECORD_HEADER)
+        {
+            const char* p = data.data + pos;
+            uint32_t nameSize = getU32(p + 5);
+            uint32_t valueSize = getU32(p + 9);
+            size_t bodySize = JOURNAL_RECORD_HEADER - 4 + static_cast<size_t>(nameSize) + valueSize;
+            if (data.size - pos - 4 < bodySize || crc32(p + 4, bodySize) != getU32(p))
+            {
+                break;  // Torn or corrupt: everything from here on is dropped
+            }
+            string_view name(p + JOURNAL_RECORD_HEADER, nameSize);
+            string_view value(p + JOURNAL_RECORD_HEADER + nameSize, valueSize);
+            apply(vault, static_cast<ActionType>(p[4]), name, value);
+            pos += 4 + bodySize;
+            replayed++;
+        }
+        validSize = pos;
+        return replayed;
+    }
+
+    // Replay an existing journal into vault, drop any torn tail, and open it for
+    // appending (creating it if missing). Returns records replayed, -1 on error.
+    int open(const string& journalPath, VaultStore& vault)
+    {
+        close();
+        path = journalPath;
+
+        uintmax_t validSize = 0;
+        int replayed = replayFile(path, vault, validSize);
+        if (replayed < 0)
+        {
+            return -1;
+        }
+
+        if (validSize > 0)
+        {
+            error_code ec;
+            if (filesystem::file_size(path, ec) > validSize)
+            {
+                filesystem::resize_file(path, validSize, ec);
+            }
+            if (ec) return -1;
+            file = fopen(path.c_str(), "ab");
+            if (file) setvbuf(file, nullptr, _IONBF, 0);
+            bytes = validSize;
+        }
+        else
+        {
+            file = fopen(path.c_str(), "wb");
+            if (file) setvbuf(file, nullptr, _IONBF, 0);
+            char header[JOURNAL_HEADER_BYTES];
+            memcpy(header, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+            memcpy(header + sizeof(JOURNAL_MAGIC), vault.key.salt, VAULT_SALT_BYTES);
+            if (file && (fwrite(header, 1, sizeof(header), file) != sizeof(header) || !syncFile(file)))
+            {
+                close();
+            }
+            bytes = JOURNAL_HEADER_BYTES;
+        }
+        torn = false;
+        return file ? replayed : -1;
+    }
+
+    // Buffer one mutation; it becomes durable at the next commit()
+    void append(ActionType type, string_view name, string_view value)
+    {
+        if (!file) return;
+
+        size_t start = pending.size();
+        putU32(pending, 0);  // CRC, filled in below
+        pending.push_back(static_cast<char>(type));
+        putU32(pending, static_cast<uint32_t>(name.size()));
+        putU32(pending, static_cast<uint32_t>(value.size()));
+        pending.insert(pending.end(), name.begin(), name.end());
+        pending.insert(pending.end(), value.begin(), value.end());
+
+        uint32_t crc = crc32(pending.data() + start + 4, pending.size() - start - 4);
+        for (int i = 0; i < 4; i++) pending[start + i] = static_cast<char>(crc >> (8 * i));
+        pendingRecords++;
+    }
+
+    // Write and fsync every pending record at once. On failure the records stay
+    // pending and the file is cut back to bytes before the next attempt, so a
+    // retry writes them in full (the file is unbuffered: nothing is left over
+    // in the FILE to be written later)
+    bool commit()
+    {
+        if (!file || pending.empty()) return true;
+
+        if (torn)
+        {
+            error_code ec;
+            filesystem::resize_file(path, bytes, ec);
+            if (ec || fseek(file, static_cast<long>(bytes), SEEK_SET) != 0) return false;
+            clearerr(file);
+            torn = false;
+        }
+        syncs++;
+        if (fwrite(pending.data(), 1, pending.size(), file) != pending.size() || !syncFile(file))
+        {
+            torn = true;
+            return false;
+        }
+        bytes += pending.size();
+        pending.clear();
+        pendingRecords = 0;
+        return true;
+    }
+
+    // Commit what is pending and close the file; false if that commit failed
+    // (the records still pending are lost then)
+    bool close()
+    {
+        if (!file) return true;
+        bool committed = commit();
+        fclose(file);
+        file = nullptr;
+        vector<char>().swap(pending);
+        pendingRecords = 0;
+        return committed;
+    }
+};
+
+// ==================== SNAPSHOTS ====================
+
+const uint64_t CHECKPOINT_JOURNAL_BYTES = 4 << 20;  // Journal size that triggers a checkpoint
+
+// Files of a user's vault share "vault_<FNV-1a hash of the email>" in the working
+// directory: .snap (last checkpoint), .wal (journal since then) and .wal.ckpt
+// (a journal segment being folded into the next snapshot)
+string vaultPathFor(const string& email)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (char c : email)
+    {
+        h ^= static_cast<uint8_t>(c);
+        h *= 0x100000001b3ULL;
+    }
+    char name[40];
+    snprintf(name, sizeof(name), "vault_%016llx", static_cast<unsigned long long>(h));
+    return name;
+}
+
+// The key salt of a user's vault, from the header of the first of its files
+// that has one (snapshot, unfinished checkpoint segment, journal). False for a
+// vault with no files yet, which keeps the random salt it was given.
+bool readVaultSalt(const string& vaultPath, uint8_t salt[VAULT_SALT_BYTES])
+{
+    VaultSnapshot snapshot;
+    if (snapshot.open(vaultPath + ".snap"))
+    {
+        memcpy(salt, snapshot.header->keySalt, VAULT_SALT_BYTES);
+        return true;
+    }
+    for (const char* suffix : { ".wal.ckpt", ".wal" })
+    {
+        char header[JOURNAL_HEADER_BYTES];
+        ifstream in(vaultPath + suffix, ios::binary);
+        if (in.read(header, sizeof(header)) && memcmp(header, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) == 0)
+        {
+            memcpy(salt, header + sizeof(JOURNAL_MAGIC), VAULT_SALT_BYTES);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Make a rename inside the working directory durable
+void syncWorkingDirectory()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    int fd = ::open(".", O_RDONLY);
+    if (fd >= 0)
+    {
+        fsync(fd);
+        ::close(fd);
+    }
+#endif
+}
+
+// Write every record of vault, in name order, as a snapshot file (see SnapshotHeader)
+bool writeSnapshot(VaultStore& vault, const string& path)
+{
+    uint32_t count = vault.size();
+    vector<uint64_t> prefixes;
+    vector<SnapshotEntry> entries;
+    vector<SnapshotReuse> reuse;
+    string data;
+    prefixes.reserve(count);
+    entries.reserve(count);
+    reuse.reserve(count);
+
+    random_device rd;
+    uint64_t key0 = (static_cast<uint64_t>(rd()) << 32) | rd();
+    uint64_t key1 = (static_cast<uint64_t>(rd()) << 32) | rd();
+
+    for (VaultIterator it = vault.begin(); it.hasNext(); )
+    {
+        PasswordNode* node = it.next();
+        if (data.size() + node->accountName.size() + node->password.size() > UINT32_MAX)
+        {
+            return false;  // Offsets are 32-bit
+        }
+        SnapshotEntry entry;
+        entry.nameOffset = static_cast<uint32_t>(data.size());
+        entry.nameSize = static_cast<uint32_t>(node->accountName.size());
+        data.append(node->accountName);
+        entry.passwordOffset = static_cast<uint32_t>(data.size());
+        entry.passwordSize = static_cast<uint32_t>(node->password.size());
+        data.append(node->password);
+
+        uint32_t hash = static_cast<uint32_t>(keyedHash(node->password, key0, key1));
+        reuse.push_back({ hash, static_cast<uint32_t>(entries.size()) });
+        prefixes.push_back(keyPrefix(node->accountName));
+        entries.push_back(entry);
+    }
+    sort(reuse.begin(), reuse.end(),
+        [](const SnapshotReuse& a, const SnapshotReuse& b)
+        {
+            return a.hash != b.hash ? a.hash < b.hash : a.entry < b.entry;
+        });
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.count = static_cast<uint32_t>(entries.size());
+    header.endianTag = SNAPSHOT_ENDIAN_TAG;
+    header.hashKey0 = key0;
+    header.hashKey1 = key1;
+    memcpy(header.keySalt, vault.key.salt, VAULT_SALT_BYTES);
+    header.prefixOffset = sizeof(SnapshotHeader);
+    header.entryOffset = header.prefixOffset + prefixes.size() * sizeof(uint64_t);
+    header.reuseOffset = header.entryOffset + entries.size() * sizeof(SnapshotEntry);
+    header.dataOffset = header.reuseOffset + reuse.size() * sizeof(SnapshotReuse);
+    header.fileSize = header.dataOffset + data.size();
+    header.headerCrc = crc32(reinterpret_cast<const char*>(&header), offsetof(SnapshotHeader, headerCrc));
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+        && fwrite(prefixes.data(), sizeof(uint64_t), prefixes.size(), file) == prefixes.size()
+        && fwrite(entries.data(), sizeof(SnapshotEntry), entries.size(), file) == entries.size()
+        && fwrite(reuse.data(), sizeof(SnapshotReuse), reuse.size(), file) == reuse.size()
+        && fwrite(data.data(), 1, data.size(), file) == data.size()
+        && syncFile(file);
+    fclose(file);
+    return ok;
+}
+
+// Fold the rotated journal segment into a new snapshot: load the last snapshot,
+// replay the segment on top, write the result beside it, then swap it in and
+// retire the segment. Only files are touched, never the live vault, so this
+// runs on the checkpoint thread while the session keeps going. salt is the
+// vault's key salt, which every file of the vault carries.
+bool foldJournal(const string& vaultPath, const uint8_t salt[VAULT_SALT_BYTES])
+{
+    string snapshotPath = vaultPath + ".snap";
+    string segmentPath = vaultPath + ".wal.ckpt";
+    string tempPath = snapshotPath + ".tmp";
+
+    VaultStore merged;
+    memcpy(merged.key.salt, salt, VAULT_SALT_BYTES);
+    if (!merged.attachSnapshot(snapshotPath) && filesystem::exists(snapshotPath))
+    {
+        return false;  // Never overwrite a snapshot we cannot read
+    }
+    uintmax_t validSize = 0;
+    if (Journal::replayFile(segmentPath, merged, validSize) < 0 || !writeSnapshot(merged, tempPath))
+    {
+        return false;
+    }
+    merged.clear();
+
+    error_code ec;
+    filesystem::rename(tempPath, snapshotPath, ec);
+    if (ec) return false;
+    syncWorkingDirectory();
+    filesystem::remove(segmentPath, ec);
+    syncWorkingDirectory();
+    return !ec;
+}
+
+// ==================== STRENGTH ESTIMATOR ====================
+//
+// How many guesses an attacker who knows how people pick passwords would need,
+// in the manner of zxcvbn. The password is covered by the cheapest sequence of
+// patterns: dictionary words (capitalised, reversed or in l33t too), keyboard
+// walks, repeats, alphabetic or numeric runs, dates and years. Whatever no
+// pattern covers counts as brute force. The dictionary is one string of common
+// passwords and words, most common first. It is hashed into an open-addressing
+// table at compile time, so nothing is built at startup, and a lookup costs one
+// incremental hash step and about one comparison.
+
+const int STRENGTH_MAX_LENGTH = 32;     // Characters pattern-matched; the rest count as brute force
+const int DICTIONARY_MAX_WORD = 16;
+const int DICTIONARY_MIN_WORD = 3;
+const uint32_t DICTIONARY_SLOTS = 2048; // Power of two, at least twice the words
+const uint32_t PREFIX_FILTER_BITS = 32768;  // Bit per prefix hash, to stop extending a non-word early
+const int STRONG_SCORE = 3;             // Score checkAndSuggestStrength accepts (10^8+ guesses)
+const int MIN_YEAR_SPACE = 20;
+
+// Common passwords, then common words and names, most common first (lowercase)
+constexpr char DICTIONARY_WORDS[] =
+    "password 123456 12345678 qwerty 123456789 12345 111111 1234567 dragon 123123 "
+    "baseball abc123 football monkey letmein shadow master 666666 qwertyuiop 123321 "
+    "mustang 1234567890 michael 654321 superman 1qaz2wsx 7777777 121212 000000 qazwsx "
+    "123qwe killer trustno1 jordan jennifer zxcvbnm asdfgh hunter buster soccer harley "
+    "batman andrew tigger sunshine iloveyou 2000 charlie robert thomas hockey ranger "
+    "daniel starwars klaster 112233 george computer michelle jessica pepper 1111 zxcvbn "
+    "555555 11111111 131313 freedom 777777 pass maggie 159753 aaaaaa ginger princess "
+    "joshua cheese amanda summer love ashley nicole chelsea biteme matthew access "
+    "yankees 987654321 dallas austin thunder taylor matrix william corvette hello "
+    "martin heather secret merlin diamond 1234qwer gfhjkm hammer silver 222222 88888888 "
+    "anthony justin test bailey q1w2e3r4t5 patrick internet scooter orange 11111 golfer "
+    "cookie richard samantha bigdog guitar jackson whatever mickey chicken sparky snoopy "
+    "maverick phoenix camaro sexy peanut morgan welcome falcon cowboy ferrari samsung "
+    "andrea smokey steelers joseph mercedes dakota arsenal eagles melissa boomer booboo "
+    "spider nascar monster tigers yellow xxxxxx 123123123 gateway marina diablo bulldog "
+    "qwer1234 compaq purple hardcore banana junior hannah 123654 porsche lakers iceman "
+    "money cowboys 987654 london tennis 999999 ncc1701 coffee scooby 0000 miller boston "
+    "q1w2e3r4 fuckoff brandon yamaha chester mother forever johnny edward 333333 oliver "
+    "redsox player nikita knight fender barney midnight please brandy chicago badboy "
+    "iwantu slayer rangers charles angel flower bigdaddy rabbit wizard bigdick jasper "
+    "enter rachel chris steven winner adidas victoria natasha 1q2w3e4r jasmine winter "
+    "prince panties marine ghbdtn fishing cocacola casper james 232323 raiders 888888 "
+    "marlboro gandalf asdfasdf crystal 87654321 12344321 golden blowme 8675309 panther "
+    "lauren angela bitch spanky thx1138 angels madison winston shannon mike toyota "
+    "blowjob jordan23 canada sophie apples dick tiger razz123 redskins qwert1 maxwell "
+    "jackie anthony12 admin admin123 root toor login welcome1 passw0rd password1 "
+    "password123 changeme letmein1 iloveyou1 monkey1 dragon1 sunshine1 princess1 "
+    "football1 baseball1 superman1 batman1 trustno1 qwerty1 qwerty123 abc12345 "
+    "default guest user temp temp123 test123 master1 secret1 hello123 love123 "
+    "the and for are but not you all any can her was one our out day get has him his "
+    "how man new now old see two way who boy did its let put say she too use "
+    "about after again air also america animal another answer apple april august "
+    "autumn baby back ball bear beautiful because bed before bird black blue body "
+    "book box bread brother brown business cake call car carpet cat change child "
+    "children christmas city class clean cloud cold color come cool country cream "
+    "dad dance dark daughter dear december dinner doctor dog door dream drink "
+    "earth easter east eight eleven end english evening every eye face family "
+    "farm father february fire first fish five flag floor food forest four friday "
+    "friend friends friendship frog fruit funny game garden girl give glass god "
+    "gold good goodbye grand grass great green group grow guess hair half hand happy "
+    "hard head heart heaven hell help here high hill history holiday home honey "
+    "horse hospital hot house hundred ice idea island jam january job july june "
+    "jump key kid king kitchen kitty lady lake land last laugh leaf life light "
+    "like lion little live long look lucky lunch magic make march mark may milk "
+    "mind minute mirror monday moon morning mountain mouse music name nature "
+    "never nice night nine north november number ocean october office open paper "
+    "paris party peace pencil people person pink pizza place plane plant play "
+    "pretty queen quick rain rainbow read red river road rock room rose round "
+    "saturday school sea season second september seven shoe shop short sister "
+    "six sky sleep small smile snake snow soft song south space spring square "
+    "star start station stone story street strong student study sugar sun sunday "
+    "sweet table teacher team ten thank thing three thursday time today tomorrow "
+    "tree truck true tuesday twelve twenty under uncle universe up water wednesday "
+    "week west white wife window wine woman wood word work world year young zero "
+    "zoo correct battery staple "
+    "alex alexander alice amy anna barbara ben betty bob brian carol catherine chloe "
+    "christopher daisy david debbie diana donald dorothy elizabeth emily emma eric "
+    "frank gary grace hanna harry helen henry jack jacob jake james jane jason jeff "
+    "jessie jim john jonathan julia karen kate kelly kevin laura linda lisa lucy "
+    "maria mark mary max megan mia nancy nick noah olivia paul peter rebecca ryan "
+    "sam sandra sarah scott simon sophia stephen steve susan tom tony william zoe "
+    "liverpool chelsea1 manchester united barcelona madrid juventus lakers1 "
+    "yankee dolphins packers cowboy1 bears giants jets ravens broncos "
+    "pokemon naruto minecraft fortnite pikachu mario zelda sonic starwars1 "
+    "matrix1 hunter2 shadow1 killer1 ninja samurai warrior legend hero "
+    "google facebook youtube twitter apple1 microsoft windows linux android iphone "
+    "qwertz azerty asdf zxcv qazwsxedc 1qazxsw2 zaq12wsx qweasd qweasdzxc "
+    "abcd abcdef abcdefg abcdefgh 1234 4321 1212 2222 4444 5555 6666 7777 8888 9999 "
+    "69696969 6969 1313 2112 1122 1111111 11111111 123abc abc123456 a1b2c3 "
+    "monkey12 dragon12 charlie1 jordan1 michael1 andrew1 jessica1 ashley1 "
+    "soccer1 hockey1 buster1 tigger1 pepper1 ginger1 maggie1 cookie1 "
+    "loveme lovely lover loving iloveu iloveyou2 mylove babygirl babyboy sweetie "
+    "angel1 angelina beauty butterfly cutie darling flowers honey1 kisses "
+    "sunflower unicorn princesa fuckyou asshole shit bitch1 pussy penis sex "
+    "blink182 metallica nirvana slipknot eminem beatles elvis ";
+
+struct DictionarySlot
+{
+    uint32_t offset;  // Of the word in DICTIONARY_WORDS
+    uint16_t rank;    // 1 = most common; 0 = empty slot
+    uint8_t length;
+};
+
+struct DictionaryTable
+{
+    DictionarySlot slots[DICTIONARY_SLOTS];
+    uint64_t prefixes[PREFIX_FILTER_BITS / 64];  // Set for the hash of every prefix of every word
+    uint32_t words;
+};
+
+const uint32_t FNV_BASIS = 2166136261u;
+const uint32_t FNV_PRIME = 16777619u;
+
+constexpr uint32_t dictionaryHash(const char* p, size_t n)
+{
+    uint32_t h = FNV_BASIS;
+    for (size_t i = 0; i < n; i++) h = (h ^ static_cast<uint8_t>(p[i])) * FNV_PRIME;
+    return h;
+}
+
+// Hash every word into the table; a repeated word keeps its first (best) rank
+constexpr DictionaryTable buildDictionary()
+{
+    DictionaryTable table{};
+    size_t i = 0;
+    uint32_t rank = 0;
+    while (DICTIONARY_WORDS[i])
+    {
+        size_t start = i;
+        while (DICTIONARY_WORDS[i] && DICTIONARY_WORDS[i] != ' ') i++;
+        size_t length = i - start;
+        if (DICTIONARY_WORDS[i]) i++;
+        if (length < DICTIONARY_MIN_WORD || length > DICTIONARY_MAX_WORD) continue;
+        rank++;
+        uint32_t prefix = FNV_BASIS;
+        for (size_t k = start; k < start + length; k++)
+        {
+            prefix = (prefix ^ static_cast<uint8_t>(DICTIONARY_WORDS[k])) * FNV_PRIME;
+            table.prefixes[(prefix & (PREFIX_FILTER_BITS - 1)) / 64] |= uint64_t(1) << (prefix & 63);
+        }
+        uint32_t slot = dictionaryHash(DICTIONARY_WORDS + start, length) & (DICTIONARY_SLOTS - 1);
+        bool repeated = false;
+        while (table.slots[slot].rank != 0 && !repeated)
+        {
+            const DictionarySlot& s = table.slots[slot];
+            repeated = s.length == length;
+            for (size_t k = 0; k < length && repeated; k++) repeated = DICTIONARY_WORDS[s.offset + k] == DICTIONARY_WORDS[start + k];
+            slot = (slot + 1) & (DICTIONARY_SLOTS - 1);
+        }
+        if (!repeated)
+        {
+            table.slots[slot] = DictionarySlot{ static_cast<uint32_t>(start), static_cast<uint16_t>(rank), static_cast<uint8_t>(length) };
+        }
+    }
+    table.words = rank;
+    return table;
+}
+
+constexpr DictionaryTable DICTIONARY = buildDictionary();
+static_assert(DICTIONARY.words * 2 <= DICTIONARY_SLOTS, "DICTIONARY_SLOTS too small for the word list");
+
+// Rank of word (its FNV-1a hash given) in the dictionary, 0 if absent
+inline uint32_t dictionaryRank(const char* word, size_t n, uint32_t hash)
+{
+    for (uint32_t slot = hash & (DICTIONARY_SLOTS - 1); DICTIONARY.slots[slot].rank != 0; slot = (slot + 1) & (DICTIONARY_SLOTS - 1))
+    {
+        const DictionarySlot& s = DICTIONARY.slots[slot];
+        if (s.length == n && memcmp(DICTIONARY_WORDS + s.offset, word, n) == 0) return s.rank;
+    }
+    return 0;
+}
+
+// One pattern covering password[i..j]
+struct StrengthMatch
+{
+    int i;
+    int j;
+    double guesses;
+    const char* pattern;   // nullptr = brute force
+};
+
+struct StrengthEstimate
+{
+    double guesses = 1;        // Expected guesses to find the password
+    double log10Guesses = 0;
+    int score = 0;             // 0 (too guessable) .. 4 (very unguessable), as zxcvbn
+    string weakness;           // Patterns the cheapest guess goes through ("" if only brute force)
+};
+
+double binomial(int n, int k)
+{
+    if (k < 0 || k > n) return 0;
+    double r = 1;
+    for (int d = 1; d <= k; d++) r = r * (n - k + d) / d;
+    return r;
+}
+
+// Ways to place s special and u plain letters that an attacker would try
+double variations(int s, int u)
+{
+    if (s == 0) return 1;
+    if (u == 0) return 2;
+    double total = 0;
+    for (int k = 1; k <= min(s, u); k++) total += binomial(s + u, k);
+    return total;
+}
+
+// Capitalisations worth trying for a word: none, first or last letter, all, or
+// any mix of that many capitals
+double upperVariations(const char* word, int n)
+{
+    int upper = 0;
+    int lower = 0;
+    for (int k = 0; k < n; k++)
+    {
+        upper += word[k] >= 'A' && word[k] <= 'Z';
+        lower += word[k] >= 'a' && word[k] <= 'z';
+    }
+    if (upper == 0) return 1;
+    bool first = word[0] >= 'A' && word[0] <= 'Z';
+    bool last = word[n - 1] >= 'A' && word[n - 1] <= 'Z';
+    if (lower == 0 || (upper == 1 && (first || last))) return 2;
+    return variations(upper, lower);
+}
+
+// The letter a l33t character stands for (variant 1 reads '1' as 'l'), 0 if none
+inline char unleet(char c, int variant)
+{
+    switch (c)
+    {
+        case '4': case '@': return 'a';
+        case '3': return 'e';
+        case '1': return variant ? 'l' : 'i';
+        case '!': case '|': return 'i';
+        case '0': return 'o';
+        case '$': case '5': return 's';
+        case '7': case '+': return 't';
+        default: return 0;
+    }
+}
+
+// Dictionary words in text (a lowercase form of the password, same length).
+// Reversed text maps positions back; a l33t form only reports words that
+// needed a substitution.
+void matchDictionary(const string& password, const char* text, int n, bool reversed, int leetVariant,
+                     vector<StrengthMatch>& matches)
+{
+    for (int i = 0; i + DICTIONARY_MIN_WORD <= n; i++)
+    {
+        uint32_t hash = FNV_BASIS;
+        for (int j = i; j < n && j - i < DICTIONARY_MAX_WORD; j++)
+        {
+            hash = (hash ^ static_cast<uint8_t>(text[j])) * FNV_PRIME;
+            if (!(DICTIONARY.prefixes[(hash & (PREFIX_FILTER_BITS - 1)) / 64] >> (hash & 63) & 1)) break;  // No word starts this way
+            int length = j - i + 1;
+            if (length < DICTIONARY_MIN_WORD) continue;
+            uint32_t rank = dictionaryRank(text + i, length, hash);
+            if (rank == 0) continue;
+
+            int from = reversed ? n - 1 - j : i;
+            const char* original = password.data() + from;
+            double guesses = rank * upperVariations(original, length);
+            const char* pattern = reversed ? "reversed word" : "dictionary word";
+            if (leetVariant >= 0)
+            {
+                int subbed = 0;
+                int plain = 0;
+                for (int k = 0; k < length; k++)
+                {
+                    char lower = static_cast<char>(tolower(static_cast<unsigned char>(original[k])));
+                    if (lower != text[i + k]) subbed++;
+                    else if (strchr("aeilost", lower)) plain++;
+                }
+                if (subbed == 0) continue;
+                guesses *= variations(subbed, plain);
+                pattern = "word in l33t";
+            }
+            matches.push_back({ from, from + length - 1, reversed ? guesses * 2 : guesses, pattern });
+        }
+    }
+}
+
+// Keyboard position of a character on a US QWERTY layout: row and x (rows are
+// staggered), and whether shift is needed. False if it is not on the layout.
+bool keyPosition(char c, int& row, double& x, bool& shifted)
+{
+    static const char* const rows[2][4] = {
+        { "`1234567890-=", "qwertyuiop[]\\", "asdfghjkl;'", "zxcvbnm,./" },
+        { "~!@#$%^&*()_+", "QWERTYUIOP{}|", "ASDFGHJKL:\"", "ZXCVBNM<>?" },
+    };
+    static const double stagger[4] = { 0, 1.5, 1.75, 2.25 };
+    for (int s = 0; s < 2; s++)
+    {
+        for (int r = 0; r < 4; r++)
+        {
+            const char* at = strchr(rows[s][r], c);
+            if (at && c)
+            {
+                row = r;
+                x = stagger[r] + (at - rows[s][r]);
+                shifted = s == 1;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Runs of 3+ keys each next to the previous one (repeated keys do not count)
+void matchKeyboardWalks(const string& password, int n, vector<StrengthMatch>& matches)
+{
+    const double keys = 47;        // Starting keys on the layout
+    const double degree = 4.6;     // Average neighbours per key
+    int row[STRENGTH_MAX_LENGTH];
+    double x[STRENGTH_MAX_LENGTH];
+    bool shifted[STRENGTH_MAX_LENGTH];
+    bool onLayout[STRENGTH_MAX_LENGTH];
+    for (int k = 0; k < n; k++) onLayout[k] = keyPosition(password[k], row[k], x[k], shifted[k]);
+
+    auto adjacent = [&](int a, int b)
+    {
+        int dr = abs(row[a] - row[b]);
+        double dx = fabs(x[a] - x[b]);
+        return (dr == 0 && dx > 0.5 && dx < 1.5) || (dr == 1 && dx < 0.8);
+    };
+    int i = 0;
+    while (i < n)
+    {
+        int j = i;
+        int turns = 0;
+        int lastDirection = -1;
+        while (j + 1 < n && onLayout[j] && onLayout[j + 1] && adjacent(j, j + 1))
+        {
+            int direction = (row[j + 1] - row[j] + 1) * 3 + (x[j + 1] > x[j] ? 2 : x[j + 1] < x[j] ? 0 : 1);
+            turns += direction != lastDirection;
+            lastDirection = direction;
+            j++;
+        }
+        int length = j - i + 1;
+        if (length >= 3)
+        {
+            double guesses = 0;
+            for (int l = 2; l <= length; l++)
+            {
+                for (int t = 1; t <= min(turns, l - 1); t++) guesses += binomial(l - 1, t - 1) * keys * pow(degree, t);
+            }
+            int shifts = 0;
+            for (int k = i; k <= j; k++) shifts += shifted[k];
+            guesses *= variations(shifts, length - shifts);
+            matches.push_back({ i, j, guesses, "keyboard walk" });
+            i = j;
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+// Runs of 3+ letters or digits stepping by the same amount (abc, 2468, zyx)
+void matchSequences(const string& password, int n, vector<StrengthMatch>& matches)
+{
+    auto kind = [](char c) { return islower(static_cast<unsigned char>(c)) ? 1 : isupper(static_cast<unsigned char>(c)) ? 2 : isdigit(static_cast<unsigned char>(c)) ? 3 : 0; };
+    int i = 0;
+    while (i + 2 < n)
+    {
+        int delta = password[i + 1] - password[i];
+        int j = i + 1;
+        if (kind(password[i]) != 0 && delta != 0 && abs(delta) <= 5)
+        {
+            while (j + 1 < n && password[j + 1] - password[j] == delta && kind(password[j + 1]) == kind(password[i])) j++;
+        }
+        if (j - i + 1 >= 3 && kind(password[j]) == kind(password[i]))
+        {
+            char first = password[i];
+            double base = strchr("aAzZ019", first) ? 4 : isdigit(static_cast<unsigned char>(first)) ? 10 : 26;
+            if (delta < 0) base *= 2;
+            matches.push_back({ i, j, base * (j - i + 1), "sequence" });
+            i = j;
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+// The current year, which dates near are guessed first (from the system clock;
+// an average year length is close enough here)
+int referenceYear()
+{
+    static const int year = static_cast<int>(1970 + chrono::duration_cast<chrono::seconds>(
+        chrono::system_clock::now().time_since_epoch()).count() / 31556952);
+    return year;
+}
+
+// Guesses for a year: the distance from referenceYear(), at least MIN_YEAR_SPACE
+double yearGuesses(int year)
+{
+    return max(abs(year - referenceYear()), MIN_YEAR_SPACE);
+}
+
+// 4-digit years 1900..2099, and dates of 4 to 8 digits (day, month and year in
+// any common order, two- or four-digit year) with or without one separator
+void matchDates(const string& password, int n, vector<StrengthMatch>& matches)
+{
+    auto digits = [&](int from, int count, int& value)
+    {
+        value = 0;
+        for (int k = from; k < from + count; k++)
+        {
+            if (!isdigit(static_cast<unsigned char>(password[k]))) return false;
+            value = value * 10 + (password[k] - '0');
+        }
+        return true;
+    };
+    auto fullYear = [](int year, int width) { return width == 2 ? (year >= 50 ? 1900 + year : 2000 + year) : year; };
+
+    for (int i = 0; i + 4 <= n; i++)
+    {
+        if (!isdigit(static_cast<unsigned char>(password[i]))) continue;
+        int year;
+        if (digits(i, 4, year) && year >= 1900 && year <= 2099)
+        {
+            matches.push_back({ i, i + 3, yearGuesses(year), "year" });
+        }
+
+        // Split [i, i + length) into day, month and year parts, separated or not
+        for (int length = 4; length <= 10 && i + length <= n; length++)
+        {
+            double best = 0;
+            for (int sep = 0; sep <= 1; sep++)
+            {
+                int digitCount = length - 2 * sep;
+                for (int yearWidth : { 2, 4 })
+                {
+                    for (int firstWidth = 1; firstWidth <= 2; firstWidth++)
+                    {
+                        int secondWidth = digitCount - yearWidth - firstWidth;
+                        if (secondWidth < 1 || secondWidth > 2) continue;
+                        for (int yearFirst = 0; yearFirst <= 1; yearFirst++)
+                        {
+                            int widths[3] = { firstWidth, secondWidth, yearWidth };
+                            if (yearFirst) widths[0] = yearWidth, widths[1] = firstWidth, widths[2] = secondWidth;
+                            int values[3];
+                            int at = i;
+                            bool ok = true;
+                            for (int part = 0; part < 3 && ok; part++)
+                            {
+                                ok = digits(at, widths[part], values[part]);
+                                at += widths[part];
+                                if (sep && part < 2)
+                                {
+                                    ok = ok && strchr("/-._ ", password[at]) && password[at] && (part == 0 || password[at] == password[i + widths[0]]);
+                                    at++;
+                                }
+                            }
+                            if (!ok) continue;
+                            int y = yearFirst ? fullYear(values[0], widths[0]) : fullYear(values[2], widths[2]);
+                            int a = yearFirst ? values[1] : values[0];
+                            int b = yearFirst ? values[2] : values[1];
+                            bool dayMonth = a >= 1 && a <= 31 && b >= 1 && b <= 12;
+                            bool monthDay = a >= 1 && a <= 12 && b >= 1 && b <= 31;
+                            if (y < 1000 || y > 2099 || (!dayMonth && !monthDay)) continue;
+                            double guesses = 365 * yearGuesses(y) * (sep ? 4 : 1);
+                            if (best == 0 || guesses < best) best = guesses;
+                        }
+                    }
+                }
+            }
+            if (best > 0) matches.push_back({ i, i + length - 1, best, "date" });
+        }
+    }
+}
+
+double estimateGuesses(const string& password, string* weakness);
+
+// Runs of one block repeated 2+ times (aaa, abcabc); the block is estimated on its own
+void matchRepeats(const string& password, int n, vector<StrengthMatch>& matches)
+{
+    for (int i = 0; i + 1 < n; i++)
+    {
+        int bestBlock = 0;
+        int bestCount = 0;
+        for (int block = 1; i + 2 * block <= n; block++)
+        {
+            if (password[i] != password[i + block]) continue;
+            if (i >= block && password.compare(i - block, block, password, i, block) == 0) continue;  // Not where the run starts
+            int count = 1;
+            while (i + (count + 1) * block <= n && password.compare(i, block, password, i + count * block, block) == 0) count++;
+            if (count >= 2 && block * count > bestBlock * bestCount)
+            {
+                bestBlock = block;
+                bestCount = count;
+            }
+        }
+        if (bestCount >= 2)
+        {
+            double base = estimateGuesses(password.substr(i, bestBlock), nullptr);
+            matches.push_back({ i, i + bestBlock * bestCount - 1, base * bestCount, "repeat" });
+        }
+    }
+}
+
+// Fewest guesses over every way to cover the password with matches and brute
+// force, as zxcvbn scores a sequence of l parts: l! * product + 10000^(l-1)
+// (an attacker tries short sequences first, in any order). weakness receives
+// the patterns of the cheapest cover.
+double estimateGuesses(const string& full, string* weakness)
+{
+    int n = min(static_cast<int>(full.size()), STRENGTH_MAX_LENGTH);
+    double extra = pow(10.0, static_cast<double>(full.size()) - n);  // Past STRENGTH_MAX_LENGTH: brute force
+    if (n == 0) return 1;
+    string password = full.substr(0, n);
+
+    vector<StrengthMatch> matches;
+    matches.reserve(64);
+    string text(n, '\0');
+    for (int variant = -1; variant <= 1; variant++)
+    {
+        bool substituted = false;
+        for (int k = 0; k < n; k++)
+        {
+            char c = static_cast<char>(tolower(static_cast<unsigned char>(password[k])));
+            char letter = variant >= 0 ? unleet(c, variant) : 0;
+            substituted = substituted || letter;
+            text[k] = letter ? letter : c;
+        }
+        if (variant >= 0 && !substituted) continue;
+        if (variant == 1 && password.find('1') == string::npos) continue;
+        matchDictionary(password, text.data(), n, false, variant, matches);
+        if (variant == -1)
+        {
+            string reversed(text.rbegin(), text.rend());
+            matchDictionary(password, reversed.data(), n, true, variant, matches);
+        }
+    }
+    matchKeyboardWalks(password, n, matches);
+    matchSequences(password, n, matches);
+    matchDates(password, n, matches);
+    matchRepeats(password, n, matches);
+
+    // Any pattern shorter than the password is worth at least a few guesses
+    for (StrengthMatch& m : matches)
+    {
+        if (m.j - m.i + 1 < n) m.guesses = max(m.guesses, m.i == m.j ? 10.0 : 50.0);
+    }
+
+    // best[k][l]: cheapest product of l parts covering [0, k]; from[k][l] the
+    // last part (match index, or -1 - start for brute force)
+    const double none = HUGE_VAL;
+    static thread_local double best[STRENGTH_MAX_LENGTH][STRENGTH_MAX_LENGTH + 1];
+    static thread_local int from[STRENGTH_MAX_LENGTH][STRENGTH_MAX_LENGTH + 1];
+    for (int k = 0; k < n; k++) fill(best[k], best[k] + n + 1, none);
+    auto update = [&](int k, int l, double product, int part)
+    {
+        if (product < best[k][l])
+        {
+            best[k][l] = product;
+            from[k][l] = part;
+        }
+    };
+    sort(matches.begin(), matches.end(), [](const StrengthMatch& a, const StrengthMatch& b) { return a.j < b.j; });
+    double bruteForce[STRENGTH_MAX_LENGTH + 1];
+    bruteForce[1] = 11;
+    bruteForce[2] = 100;
+    for (int length = 3; length <= n; length++) bruteForce[length] = bruteForce[length - 1] * 10;
+    size_t m = 0;
+    for (int k = 0; k < n; k++)
+    {
+        for (; m < matches.size() && matches[m].j == k; m++)
+        {
+            int i = matches[m].i;
+            if (i == 0) update(k, 1, matches[m].guesses, static_cast<int>(m));
+            for (int l = 1; i > 0 && l <= i; l++)
+            {
+                if (best[i - 1][l] != none) update(k, l + 1, best[i - 1][l] * matches[m].guesses, static_cast<int>(m));
+            }
+        }
+        // Brute force over [i, k], never right after more brute force
+        for (int i = 0; i <= k; i++)
+        {
+            double guesses = bruteForce[k - i + 1];
+            if (i == 0) update(k, 1, guesses, -1);
+            for (int l = 1; i > 0 && l <= i; l++)
+            {
+                if (best[i - 1][l] != none && from[i - 1][l] >= 0) update(k, l + 1, best[i - 1][l] * guesses, -1 - i);
+            }
+        }
+    }
+
+    int bestL = 1;
+    double guesses = none;
+    double factorial = 1;
+    double attempts = 1;   // 10000^(l-1)
+    for (int l = 1; l <= n; l++, attempts *= 10000)
+    {
+        factorial *= l;
+        double total = factorial * best[n - 1][l] + attempts;
+        if (total < guesses)
+        {
+            guesses = total;
+            bestL = l;
+        }
+    }
+    guesses *= extra;
+
+    if (weakness)
+    {
+        weakness->clear();
+        for (int k = n - 1, l = bestL; k >= 0 && l >= 1; l--)
+        {
+            int part = from[k][l];
+            if (part >= 0)
+            {
+                const StrengthMatch& m = matches[part];
+                string found = string(m.pattern) + " \"" + full.substr(m.i, m.j - m.i + 1) + "\"";
+                *weakness = weakness->empty() ? found : found + ", " + *weakness;
+                k = m.i - 1;
+            }
+            else
+            {
+                k = -1 - part - 1;
+            }
+        }
+    }
+    return guesses;
+}
+
+// zxcvbn's 0..4 score of a guess count
+int strengthScore(double guesses)
+{
+    const double thresholds[4] = { 1e3, 1e6, 1e8, 1e10 };
+    int score = 0;
+    while (score < 4 && guesses >= thresholds[score] + 5) score++;
+    return score;
+}
+
+StrengthEstimate estimateStrength(const string& password)
+{
+    StrengthEstimate estimate;
+    estimate.guesses = estimateGuesses(password, &estimate.weakness);
+    estimate.log10Guesses = log10(estimate.guesses);
+    estimate.score = strengthScore(estimate.guesses);
+    return estimate;
+}
+
+// strengthScore of a password, as kept in PasswordNode::strength
+uint8_t passwordStrength(const string& password)
+{
+    return static_cast<uint8_t>(strengthScore(estimateGuesses(password, nullptr)));
+}
+
+// Whether checkAndSuggestStrength would call password easy to guess
+bool easyToGuess(const string& password)
+{
+    return passwordStrength(password) < STRONG_SCORE;
+}
+
+// ==================== HELPER FUNCTIONS ====================
+
+bool isValidEmail(const string& email) 
+{
+    if (email.empty()) 
+    {
+        return false;
+    }
+    
+    // Check if email contains @ symbol
+    size_t atPos = email.find('@');
+    if (atPos == string::npos || atPos == 0) 
+    {
+        return false;
+    }
+    
+    // Check if there's text before @
+    if (atPos == 0) 
+    {
+        return false;
+    }
+    
+    // Extract domain part (after @)
+    string domain = email.substr(atPos + 1);
+    if (domain.empty()) 
+    {
+        return false;
+    }
+    
+    // Check if domain contains a dot (for extension like .com, .org, etc.)
+    size_t dotPos = domain.find('.');
+    if (dotPos == string::npos || dotPos == 0) 
+    {
+        return false;
+    }
+    
+    return true;
+}
+
+// Whether password mixes uppercase letters, digits and symbols
+bool hasStrengthClasses(const string& password, bool* upper = nullptr, bool* digit = nullptr, bool* symbol = nullptr)
+{
+    bool hasUpper = false;
+    bool hasDigit = false;
+    bool hasSymbol = false;
+
+    for (char c : password) 
+    {
+        bool isUppercase = (c >= 'A' && c <= 'Z');
+        bool isLowercase = (c >= 'a' && c <= 'z');
+        bool isNumeric   = (c >= '0' && c <= '9');
+        bool isAlnum     = isUppercase || isLowercase || isNumeric;
+
+        if (!hasUpper && isUppercase) hasUpper = true;
+        if (!hasDigit && isNumeric) hasDigit = true;
+        if (!hasSymbol && !isAlnum) hasSymbol = true;
+
+        if (hasUpper && hasDigit && hasSymbol) break;
+    }
+
+    if (upper) *upper = hasUpper;
+    if (digit) *digit = hasDigit;
+    if (symbol) *symbol = hasSymbol;
+    return hasUpper && hasDigit && hasSymbol;
+}
+
+// Prints the verdict and suggestions to out (the console by default). Strong
+// means both the character classes and an estimate of STRONG_SCORE or more.
+bool checkAndSuggestStrength(const string& password, ostream& out = cout, uint8_t* strength = nullptr) 
+{
+    bool hasUpper = false;
+    bool hasDigit = false;
+    bool hasSymbol = false;
+    bool classes = hasStrengthClasses(password, &hasUpper, &hasDigit, &hasSymbol);
+    StrengthEstimate estimate = estimateStrength(password);
+    if (strength) *strength = static_cast<uint8_t>(estimate.score);
+
+    if (classes && estimate.score >= STRONG_SCORE) 
+    {
+        out << "✅ Password looks strong.\n";
+        return true;
+    }
+
+    if (estimate.score < STRONG_SCORE)
+    {
+        out << "⚠️ Password is easy to guess: about 10^" << static_cast<int>(estimate.log10Guesses) << " guesses";
+        if (!estimate.weakness.empty()) out << " (" << estimate.weakness << ")";
+        out << ".\n";
+    }
+    if (classes)
+    {
+        out << "   - Use a longer password without common words or patterns\n";
+        return false;
+    }
+
+    out << "⚠️ Password could be stronger. Consider adding:\n";
+    if (!hasUpper) 
+    {
+        out << "   - Uppercase letters (A-Z)\n";
+    }
+
+    if (!hasDigit) 
+    {
+        out << "   - Numbers (0-9)\n";
+    }
+
+    if (!hasSymbol) 
+    {
+        out << "   - Symbols (!@#$%^&* etc.)\n";
+    }
+
+    return false;
+}
+
+// Prompts until a valid email and a non-empty password are entered
+bool authenticateUser(string& email, string& password) 
+{
+    cout << "\n========== LOGIN REQUIRED ==========" << endl;
+    
+    // Loop until valid email is entered
+    while (true)
+    {
+        cout << "Enter your email: ";
+        cin >> email;
+        
+        // Validate email format
+        if (isValidEmail(email))
+        {
+            break; 
+        }
+        else
+        {
+            cout << "❌ Invalid email format. Please try again.\n";
+        }
+    }
+    
+    // Loop until non-empty password is entered
+    while (true)
+    {
+        cout << "Enter your password: ";
+        cin >> password;
+        
+        if (!password.empty())
+        {
+            break; // Valid password, exit loop
+        }
+        else
+        {
+            cout << "❌ Password cannot be empty. Please try again.\n";
+        }
+    }
+    
+    cout << "✅ Login successful! Welcome to Password Manager.\n";
+    return true;
+}
+
+bool verifyPassword(const UserAuth* user) 
+{
+    string inputPassword;
+    cout << "\nEnter your password to view passwords: ";
+    cin >> inputPassword;
+    bool verified = user && user->matches(inputPassword);
+    wipeString(inputPassword);
+    
+    if (verified) 
+    {
+        cout << "✅ Password verified!\n";
+        return true;
+    } 
+    else 
+    {
+        cout << "❌ Incorrect password! Access denied.\n";
+        return false;
+    }
+}
+
+bool logout() 
+{
+    cout << "\n========== LOGOUT ==========" << endl;
+    cout << "Are you sure you want to logout? (y/n): ";
+    char choice;
+    cin >> choice;
+    
+    if (choice == 'y' || choice == 'Y') 
+    {
+        cout << "✅ Logged out successfully!\n";
+        return true;
+    }
+    return false;
+}
+
+// ==================== PASSWORD GENERATOR ====================
+//
+// Random passwords that meet a policy by construction: one character of each
+// class the policy uses goes in first, the rest come from all of its
+// characters, and the result is shuffled. Each character takes 32 random bits
+// mapped onto its alphabet with one multiply (a bias under 2^-25 for the
+// largest alphabet), so a strict policy costs the same as a loose one: nothing
+// is drawn again. The bits come from AES-128 in counter mode, keyed from the OS;
+// the generator re-keys from its own output after every buffer, so a later
+// key cannot reproduce what was generated before it.
+
+const int GENERATED_LENGTH = 16;          // Length of a generated password by default
+const int GENERATED_MAX_LENGTH = 128;
+const size_t RANDOM_BUFFER_BLOCKS = 256;  // AES blocks produced per refill (and per re-key)
+const size_t GENERATOR_GRAIN = 4096;      // Passwords per work item of a batch call
+
+const char* const LOWER_CHARS = "abcdefghijklmnopqrstuvwxyz";
+const char* const UPPER_CHARS = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+const char* const DIGIT_CHARS = "0123456789";
+const char* const SYMBOL_CHARS = "!#$%&()*+,-./:;<=>?@[]^_{}~";  // No quotes, backslash, space or tab
+const char* const LOOKALIKE_CHARS = "Il1O0o";                    // Easy to misread in many fonts
+
+// Cryptographically secure random bits: AES-128-CTR with fast key erasure.
+// One per thread.
+struct SecureRandom
+{
+    AesRoundKeys rounds;
+    uint64_t counter[2];
+    uint8_t buffer[RANDOM_BUFFER_BLOCKS * AES_BLOCK];
+    size_t used;
+
+    // Seeded from the OS
+    SecureRandom()
+    {
+        uint8_t seed[2 * AES_BLOCK];
+        random_device rd;
+        for (size_t i = 0; i < sizeof(seed); i += 4)
+        {
+            uint32_t r = rd();
+            memcpy(seed + i, &r, 4);
+        }
+        reseed(seed);
+        wipeBytes(seed, sizeof(seed));
+    }
+
+    // Seeded with 32 bytes (key, then first counter block)
+    explicit SecureRandom(const uint8_t seed[2 * AES_BLOCK])
+    {
+        reseed(seed);
+    }
+
+    ~SecureRandom()
+    {
+        wipeBytes(this, sizeof(*this));
+    }
+
+    void reseed(const uint8_t seed[2 * AES_BLOCK])
+    {
+        aesExpandKey(seed, rounds);
+        memcpy(counter, seed + AES_BLOCK, AES_BLOCK);
+        used = sizeof(buffer);
+    }
+
+    // Encrypt the next counter blocks into the buffer, then take its first
+    // block as the next key (it is never handed out). Bytes are wiped from the
+    // buffer as they are used, so a later dump cannot replay past output.
+    void refill()
+    {
+        uint64_t low = counter[0];
+        uint64_t high = counter[1];
+        for (size_t b = 0; b < RANDOM_BUFFER_BLOCKS; b++)
+        {
+            memcpy(buffer + AES_BLOCK * b, &low, 8);
+            memcpy(buffer + AES_BLOCK * b + 8, &high, 8);
+            if (++low == 0) high++;
+        }
+        counter[0] = low;
+        counter[1] = high;
+        aesKernel(rounds, buffer, buffer, RANDOM_BUFFER_BLOCKS);
+        aesExpandKey(buffer, rounds);
+        wipeBytes(buffer, AES_BLOCK);
+        used = AES_BLOCK;
+    }
+
+    void fill(uint8_t* out, size_t n)
+    {
+        while (n > 0)
+        {
+            if (used == sizeof(buffer)) refill();
+            size_t chunk = min(n, sizeof(buffer) - used);
+            memcpy(out, buffer + used, chunk);
+            wipeBytes(buffer + used, chunk);
+            used += chunk;
+            out += chunk;
+            n -= chunk;
+        }
+    }
+
+    uint32_t next32()
+    {
+        if (used + 4 > sizeof(buffer)) refill();
+        uint32_t v;
+        memcpy(&v, buffer + used, 4);
+        wipeBytes(buffer + used, 4);
+        used += 4;
+        return v;
+    }
+
+    // Uniform in [0, n) up to a bias of n / 2^32 (no retries)
+    uint32_t below(uint32_t n)
+    {
+        return static_cast<uint32_t>(static_cast<uint64_t>(next32()) * n >> 32);
+    }
+};
+
+// What a generated password must look like. Each class that is set is used and
+// appears at least once; lowercase letters are used if nothing else is.
+struct PasswordPolicy
+{
+    int length = GENERATED_LENGTH;    // Clamped to [classes used, GENERATED_MAX_LENGTH]
+    bool lower = true;
+    bool upper = true;
+    bool digit = true;
+    bool symbol = true;
+    bool excludeLookalikes = true;    // Leave out LOOKALIKE_CHARS
+};
+
+// A policy turned into alphabets, ready to generate from
+struct PasswordGenerator
+{
+    string classes[4];   // Characters of each class the policy uses
+    int classCount;
+    string alphabet;     // All of them
+    int length;
+
+    explicit PasswordGenerator(const PasswordPolicy& policy = PasswordPolicy())
+    {
+        classCount = 0;
+        const pair<bool, const char*> sets[] = {
+            { policy.lower, LOWER_CHARS }, { policy.upper, UPPER_CHARS },
+            { policy.digit, DIGIT_CHARS }, { policy.symbol, SYMBOL_CHARS },
+        };
+        for (auto& set : sets)
+        {
+            if (!set.first) continue;
+            string& chars = classes[classCount++];
+            for (const char* c = set.second; *c; c++)
+            {
+                if (!policy.excludeLookalikes || !strchr(LOOKALIKE_CHARS, *c)) chars += *c;
+            }
+            alphabet += chars;
+        }
+        if (classCount == 0)
+        {
+            classes[classCount++] = LOWER_CHARS;
+            alphabet = LOWER_CHARS;
+        }
+        length = max(classCount, min(policy.length, GENERATED_MAX_LENGTH));
+    }
+
+    // One password into out
+    void generate(SecureRandom& rng, string& out) const
+    {
+        out.resize(length);
+        for (int k = 0; k < classCount; k++)
+        {
+            out[k] = classes[k][rng.below(static_cast<uint32_t>(classes[k].size()))];
+        }
+        uint32_t size = static_cast<uint32_t>(alphabet.size());
+        for (int i = classCount; i < length; i++) out[i] = alphabet[rng.below(size)];
+        for (int i = length - 1; i > 0; i--) swap(out[i], out[rng.below(i + 1)]);
+    }
+
+    string generate(SecureRandom& rng) const
+    {
+        string out;
+        generate(rng, out);
+        return out;
+    }
+};
+
+// Fill count passwords on up to threads threads (0 = one per core), each work
+// item with its own generator seeded from one OS-seeded parent
+void generatePasswords(const PasswordPolicy& policy, string* const out[], size_t count, unsigned threads = 0)
+{
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    PasswordGenerator generator(policy);
+    size_t items = (count + GENERATOR_GRAIN - 1) / GENERATOR_GRAIN;
+    SecureRandom parent;
+    vector<uint8_t> seeds(items * 2 * AES_BLOCK);
+    if (items) parent.fill(seeds.data(), seeds.size());
+    parallelFor(items, threads, [&](size_t item)
+    {
+        SecureRandom rng(&seeds[item * 2 * AES_BLOCK]);
+        size_t last = min(count, (item + 1) * GENERATOR_GRAIN);
+        for (size_t i = item * GENERATOR_GRAIN; i < last; i++) generator.generate(rng, *out[i]);
+    });
+    wipeBytes(seeds.data(), seeds.size());
+}
+
+// ==================== VAULT AUDIT ====================
+//
+// Whole-vault audit. Each entry's password is checked for the three character
+// classes hasStrengthClasses tests (uppercase, digit, symbol), for being easy
+// to guess, and for reuse by another account. Each record's CTR key stream is
+// generated (no need to authenticate: nothing is shown), and the class kernels
+// XOR it in and classify 16 or 32 bytes at a time in registers. They give the
+// same verdict as hasStrengthClasses: a symbol is any byte that is not an
+// ASCII letter or digit. Only a password with all three classes is opened, into
+// a buffer wiped right after, for the strength estimate, so "weak" is exactly
+// what checkAndSuggestStrength warns about when the password is entered.
+// The work runs on a fork-join pool of threads in three
+// passes: classify every entry, group the in-memory records along their reuse
+// chains, then group the snapshot records along the snapshot's sorted reuse table.
+// Reads the vault in place: no other thread may change it meanwhile (hold the
+// session lock shared).
+
+const int CLASS_UPPER = 1;
+const int CLASS_DIGIT = 2;
+const int CLASS_SYMBOL = 4;
+const int CLASS_ALL = CLASS_UPPER | CLASS_DIGIT | CLASS_SYMBOL;
+const uint8_t AUDIT_REUSED = 8;     // Verdict bit beside the CLASS_ bits found
+const uint8_t AUDIT_BREACHED = 16;  // Verdict bit set by auditBreaches
+const uint8_t AUDIT_GUESSABLE = 32; // Verdict bit: all classes, but easyToGuess()
+const size_t AUDIT_GRAIN = 16384;   // Entries (or table rows) per work item
+const int AUDIT_LIST_LIMIT = 50;    // Flagged accounts auditPasswords prints
+
+// Classify cipher XOR stream (n bytes; stream is padded to a multiple of 32)
+typedef int (*ClassKernel)(const unsigned char* cipher, const unsigned char* stream, size_t n);
+
+// Whether an audit verdict is one checkAndSuggestStrength would warn about
+inline bool auditWeak(uint8_t verdict)
+{
+    return (verdict & CLASS_ALL) != CLASS_ALL || (verdict & AUDIT_GUESSABLE);
+}
+
+// Whether an audit verdict calls for a change of password
+inline bool auditFlagged(uint8_t verdict)
+{
+    return auditWeak(verdict) || (verdict & (AUDIT_REUSED | AUDIT_BREACHED));
+}
+
+// CLASS_ bit of one plaintext byte, tested like hasStrengthClasses does
+inline int strengthClass(unsigned char c)
+{
+    if (static_cast<unsigned>(c - 'A') < 26u) return CLASS_UPPER;
+    if (static_cast<unsigned>(c - '0') < 10u) return CLASS_DIGIT;
+    return static_cast<unsigned>(c - 'a') < 26u ? 0 : CLASS_SYMBOL;
+}
+
+int classKernelScalar(const unsigned char* cipher, const unsigned char* stream, size_t n)
+{
+    int found = 0;
+    for (size_t i = 0; i < n && found != CLASS_ALL; i++)
+    {
+        found |= strengthClass(cipher[i] ^ stream[i]);
+    }
+    return found;
+}
+
+#ifdef PM_HAS_X86_KERNELS
+// x - base <= span for every byte, unsigned: min(x - base, span) == x - base
+PM_TARGET("sse2")
+inline __m128i inRange16(__m128i x, char base, char span)
+{
+    __m128i offset = _mm_sub_epi8(x, _mm_set1_epi8(base));
+    return _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(span)), offset);
+}
+
+PM_TARGET("sse2")
+int classKernelSSE2(const unsigned char* cipher, const unsigned char* stream, size_t n)
+{
+    unsigned upper = 0;
+    unsigned digit = 0;
+    unsigned symbol = 0;
+    for (size_t i = 0; i < n; i += 16)
+    {
+        size_t left = n - i;
+        __m128i data;
+        if (left >= 16)
+        {
+            data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cipher + i));
+        }
+        else
+        {
+            // Never read past the record: the last bytes may end a mapped file
+            unsigned char tail[16] = { 0 };
+            memcpy(tail, cipher + i, left);
+            data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tail));
+        }
+        __m128i plain = _mm_xor_si128(data, _mm_loadu_si128(reinterpret_cast<const __m128i*>(stream + i)));
+
+        unsigned valid = left >= 16 ? 0xFFFFu : (1u << left) - 1;
+        unsigned u = _mm_movemask_epi8(inRange16(plain, 'A', 25)) & valid;
+        unsigned d = _mm_movemask_epi8(inRange16(plain, '0', 9)) & valid;
+        unsigned l = _mm_movemask_epi8(inRange16(plain, 'a', 25)) & valid;
+        upper |= u;
+        digit |= d;
+        symbol |= valid & ~(u | d | l);
+        if (upper && digit && symbol) break;
+    }
+    return (upper ? CLASS_UPPER : 0) | (digit ? CLASS_DIGIT : 0) | (symbol ? CLASS_SYMBOL : 0);
+}
+
+PM_TARGET("avx2")
+inline __m256i inRange32(__m256i x, char base, char span)
+{
+    __m256i offset = _mm256_sub_epi8(x, _mm256_set1_epi8(base));
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(offset, _mm256_set1_epi8(span)), offset);
+}
+
+PM_TARGET("avx2")
+int classKernelAVX2(const unsigned char* cipher, const unsigned char* stream, size_t n)
+{
+    uint32_t upper = 0;
+    uint32_t digit = 0;
+    uint32_t symbol = 0;
+    for (size_t i = 0; i < n; i += 32)
+    {
+        size_t left = n - i;
+        __m256i data;
+        if (left >= 32)
+        {
+            data = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cipher + i));
+        }
+        else
+        {
+            unsigned char tail[32] = { 0 };
+            memcpy(tail, cipher + i, left);
+            data = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tail));
+        }
+        __m256i plain = _mm256_xor_si256(data, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(stream + i)));
+
+        uint32_t valid = left >= 32 ? 0xFFFFFFFFu : (1u << left) - 1;
+        uint32_t u = static_cast<uint32_t>(_mm256_movemask_epi8(inRange32(plain, 'A', 25))) & valid;
+        uint32_t d = static_cast<uint32_t>(_mm256_movemask_epi8(inRange32(plain, '0', 9))) & valid;
+        uint32_t l = static_cast<uint32_t>(_mm256_movemask_epi8(inRange32(plain, 'a', 25))) & valid;
+        upper |= u;
+        digit |= d;
+        symbol |= valid & ~(u | d | l);
+        if (upper && digit && symbol) break;
+    }
+    return (upper ? CLASS_UPPER : 0) | (digit ? CLASS_DIGIT : 0) | (symbol ? CLASS_SYMBOL : 0);
+}
+#endif
+
+// Widest class kernel this CPU can run
+ClassKernel pickClassKernel(const char** name)
+{
+#ifdef PM_HAS_X86_KERNELS
+    if (cpuHasAvx2())
+    {
+        *name = "avx2";
+        return classKernelAVX2;
+    }
+    *name = "sse2";
+    return classKernelSSE2;
+#else
+    *name = "scalar";
+    return classKernelScalar;
+#endif
+}
+
+const char* classKernelName = "";
+const ClassKernel classKernel = pickClassKernel(&classKernelName);
+
+// CLASS_ bits found in a stored (sealed) password; a record too short to be
+// one has none
+int passwordClasses(const VaultKey& key, string_view record)
+{
+    if (record.size() < SIV_BYTES) return 0;
+    const unsigned char* iv = reinterpret_cast<const unsigned char*>(record.data());
+    const unsigned char* cipher = iv + SIV_BYTES;
+    size_t n = record.size() - SIV_BYTES;
+    alignas(32) unsigned char stream[4 * AES_BLOCK];
+    int found = 0;
+    for (size_t i = 0; i < n && found != CLASS_ALL; i += sizeof(stream))
+    {
+        size_t chunk = min(sizeof(stream), n - i);
+        size_t blocks = (chunk + 2 * AES_BLOCK - 1) / (2 * AES_BLOCK) * 2;  // Whole 32-byte vectors
+        sivKeystream(key, iv, static_cast<uint32_t>(i / AES_BLOCK), blocks, stream);
+        found |= classKernel(cipher + i, stream, chunk);
+    }
+    wipeBytes(stream, sizeof(stream));
+    return found;
+}
+
+struct AuditReport
+{
+    vector<uint8_t> slabVerdicts;   // By slot: CLASS_ bits found | AUDIT_REUSED (free slots 0)
+    vector<uint8_t> baseVerdicts;   // By snapshot record (hidden ones 0)
+    uint64_t entries = 0;
+    uint64_t weak = 0;              // Missing a class or easy to guess: checkAndSuggestStrength would warn
+    uint64_t guessable = 0;         // Has every class but is easy to guess
+    uint64_t reused = 0;
+    uint64_t breached = 0;          // In the breach list (counted by auditBreaches)
+    bool breachChecked = false;     // Whether auditBreaches ran
+    uint64_t flagged = 0;           // Weak, reused or breached
+    uint64_t noUpper = 0;
+    uint64_t noDigit = 0;
+    uint64_t noSymbol = 0;
+    unsigned threads = 1;
+    double seconds = 0;
+};
+
+// Mark every member of one hash group whose password another member shares.
+// Members usually all share one password (hash collisions are rare), so the
+// first comparison pass marks the whole group.
+void markReusedGroup(vector<pair<string_view, uint8_t*>>& group)
+{
+    for (size_t i = 0; i + 1 < group.size(); i++)
+    {
+        if (*group[i].second & AUDIT_REUSED) continue;
+        for (size_t j = i + 1; j < group.size(); j++)
+        {
+            if (group[j].first == group[i].first)
+            {
+                *group[i].second |= AUDIT_REUSED;
+                *group[j].second |= AUDIT_REUSED;
+            }
+        }
+    }
+}
+
+// Strength scores of (account, plaintext password) rows as an import stores them,
+// spread over the cores. Only passwords with every class are estimated, as the
+// audit looks at no others; the rest get STRENGTH_UNKNOWN.
+vector<uint8_t> estimateStrengths(const vector<pair<string, string>>& rows)
+{
+    vector<uint8_t> strengths(rows.size(), STRENGTH_UNKNOWN);
+    parallelFor((rows.size() + AUDIT_GRAIN - 1) / AUDIT_GRAIN, max(1u, thread::hardware_concurrency()), [&](size_t item)
+    {
+        size_t last = min(rows.size(), (item + 1) * AUDIT_GRAIN);
+        for (size_t i = item * AUDIT_GRAIN; i < last; i++)
+        {
+            if (hasStrengthClasses(rows[i].second)) strengths[i] = passwordStrength(rows[i].second);
+        }
+    });
+    return strengths;
+}
+
+// Audit every entry of the vault on threads threads (0 = one per core). The
+// strength scores it has to estimate are kept in the vault for the next audit.
+AuditReport auditVault(VaultStore& vault, unsigned threads = 0)
+{
+    auto start = chrono::steady_clock::now();
+    AuditReport report;
+    report.threads = threads ? threads : max(1u, thread::hardware_concurrency());
+    RecordSlab& records = vault.records;
+    const VaultSnapshot& base = vault.base;
+    if (base.count && vault.baseStrengths.empty()) vault.baseStrengths.assign(base.count, STRENGTH_UNKNOWN);
+    uint8_t* baseStrengths = vault.baseStrengths.data();
+    uint32_t slots = records.highWater;
+    report.slabVerdicts.assign(slots, 0);
+    report.baseVerdicts.assign(base.count, 0);
+    uint8_t* slabVerdicts = report.slabVerdicts.data();
+    uint8_t* baseVerdicts = report.baseVerdicts.data();
+
+    // Pass 1: character classes of every entry, then the strength score of those
+    // that have them all (estimated only if the record does not have it yet)
+    size_t slabItems = (slots + AUDIT_GRAIN - 1) / AUDIT_GRAIN;
+    size_t baseItems = (base.count + AUDIT_GRAIN - 1) / AUDIT_GRAIN;
+    parallelFor(slabItems + baseItems, report.threads, [&](size_t item)
+    {
+        bool fromSlab = item < slabItems;
+        size_t first = (fromSlab ? item : item - slabItems) * AUDIT_GRAIN;
+        size_t last = min<size_t>(first + AUDIT_GRAIN, fromSlab ? slots : base.count);
+        string plain;
+        for (size_t i = first; i < last; i++)
+        {
+            string_view record;
+            uint8_t* verdict;
+            uint8_t* strength;
+            if (fromSlab && records.at(static_cast<uint32_t>(i)).inUse)
+            {
+                record = records.at(static_cast<uint32_t>(i)).password;
+                verdict = &slabVerdicts[i];
+                strength = &records.at(static_cast<uint32_t>(i)).strength;
+            }
+            else if (!fromSlab && !base.isHidden(static_cast<uint32_t>(i)))
+            {
+                record = base.passwordAt(static_cast<uint32_t>(i));
+                verdict = &baseVerdicts[i];
+                strength = &baseStrengths[i];
+            }
+            else
+            {
+                continue;
+            }
+            *verdict = static_cast<uint8_t>(passwordClasses(vault.key, record));
+            if (*verdict != CLASS_ALL) continue;
+            if (*strength == STRENGTH_UNKNOWN && decryptPassword(vault.key, record, plain))
+            {
+                *strength = passwordStrength(plain);
+            }
+            if (*strength < STRONG_SCORE) *verdict |= AUDIT_GUESSABLE;
+        }
+        wipeString(plain);
+    });
+
+    // Pass 2: in-memory records, one reuse chain (one hash) at a time. Each
+    // distinct password in a chain is also looked up among the snapshot records;
+    // equal passwords share a chain, so no two threads mark the same record.
+    const PasswordReuseIndex& reuseIndex = vault.reuseIndex;
+    parallelFor((reuseIndex.capacity + AUDIT_GRAIN - 1) / AUDIT_GRAIN, report.threads, [&](size_t item)
+    {
+        vector<pair<string_view, uint8_t*>> group;
+        uint32_t last = min<uint32_t>(static_cast<uint32_t>((item + 1) * AUDIT_GRAIN), reuseIndex.capacity);
+        for (uint32_t bucket = static_cast<uint32_t>(item * AUDIT_GRAIN); bucket < last; bucket++)
+        {
+            group.clear();
+            for (uint32_t slot = reuseIndex.table[bucket].slot; slot != NIL; slot = records.at(slot).reuseNext)
+            {
+                group.emplace_back(records.at(slot).password, &slabVerdicts[slot]);
+            }
+            if (group.empty()) continue;
+            markReusedGroup(group);
+            if (base.count == 0) continue;
+
+            for (size_t i = 0; i < group.size(); i++)
+            {
+                bool seen = false;
+                for (size_t j = 0; j < i && !seen; j++) seen = group[j].first == group[i].first;
+                if (seen) continue;
+                uint32_t hash = base.reuseHash(group[i].first);
+                bool shared = false;
+                for (uint32_t row = base.reuseRow(hash); row < base.count && base.reuse[row].hash == hash; row++)
+                {
+                    uint32_t e = base.reuse[row].entry;
+                    if (e < base.count && !base.isHidden(e) && base.passwordAt(e) == group[i].first)
+                    {
+                        baseVerdicts[e] |= AUDIT_REUSED;
+                        shared = true;
+                    }
+                }
+                for (size_t j = i; j < group.size() && shared; j++)
+                {
+                    if (group[j].first == group[i].first) *group[j].second |= AUDIT_REUSED;
+                }
+            }
+        }
+    });
+
+    // Pass 3: snapshot records, one run of equal hashes in the reuse table at a
+    // time. A work item takes the runs that start inside its rows.
+    parallelFor(baseItems, report.threads, [&](size_t item)
+    {
+        vector<pair<string_view, uint8_t*>> group;
+        uint32_t row = static_cast<uint32_t>(item * AUDIT_GRAIN);
+        uint32_t last = min<uint32_t>(row + static_cast<uint32_t>(AUDIT_GRAIN), base.count);
+        while (row > 0 && row < last && base.reuse[row].hash == base.reuse[row - 1].hash) row++;
+        while (row < last)
+        {
+            uint32_t hash = base.reuse[row].hash;
+            group.clear();
+            for (; row < base.count && base.reuse[row].hash == hash; row++)
+            {
+                uint32_t e = base.reuse[row].entry;
+                if (e < base.count && !base.isHidden(e)) group.emplace_back(base.passwordAt(e), &baseVerdicts[e]);
+            }
+            markReusedGroup(group);
+        }
+    });
+
+    for (const vector<uint8_t>* verdicts : { &report.slabVerdicts, &report.baseVerdicts })
+    {
+        for (size_t i = 0; i < verdicts->size(); i++)
+        {
+            bool live = verdicts == &report.slabVerdicts ? records.at(static_cast<uint32_t>(i)).inUse : !base.isHidden(static_cast<uint32_t>(i));
+            if (!live) continue;
+            uint8_t v = (*verdicts)[i];
+            report.entries++;
+            report.weak += auditWeak(v);
+            report.guessable += (v & AUDIT_GUESSABLE) != 0;
+            report.reused += (v & AUDIT_REUSED) != 0;
+            report.flagged += auditFlagged(v);
+            report.noUpper += !(v & CLASS_UPPER);
+            report.noDigit += !(v & CLASS_DIGIT);
+            report.noSymbol += !(v & CLASS_SYMBOL);
+        }
+    }
+    report.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return report;
+}
+
+// What an audit verdict flags, e.g. "no uppercase, no symbol, reused" (empty if
+// nothing)
+string auditFindings(uint8_t verdict)
+{
+    string text;
+    auto add = [&](const char* finding)
+    {
+        if (!text.empty()) text += ", ";
+        text += finding;
+    };
+    if (!(verdict & CLASS_UPPER)) add("no uppercase");
+    if (!(verdict & CLASS_DIGIT)) add("no number");
+    if (!(verdict & CLASS_SYMBOL)) add("no symbol");
+    if (verdict & AUDIT_GUESSABLE) add("easy to guess");
+    if (verdict & AUDIT_REUSED) add("reused");
+    if (verdict & AUDIT_BREACHED) add("breached");
+    return text;
+}
+
+// Calls visit(node, verdict) for every entry in account-name order
+template <typename Visit>
+void forEachAudited(VaultStore& vault, const AuditReport& report, Visit visit)
+{
+    for (VaultIterator it = vault.begin(); it.hasNext(); )
+    {
+        uint32_t baseIndex = it.baseIndex;  // The record next() returns if it comes from the snapshot
+        PasswordNode* node = it.next();
+        uint8_t verdict = node->slot != NIL ? report.slabVerdicts[node->slot] : report.baseVerdicts[baseIndex];
+        if (!visit(node, verdict)) break;
+    }
+}
+
+// ==================== BREACHED PASSWORDS ====================
+//
+// Offline check against a breached-password list such as the Have I Been Pwned
+// dump "ordered by hash": one "SHA1HEX:count" line per password, sorted by hash,
+// often many gigabytes. The list is memory-mapped and searched in place by
+// binary search on line boundaries; it is never loaded. A blocked Bloom filter
+// built from it once ("main --breach-index", saved beside it as <list>.bloom
+// and mapped as well) answers almost every clean password from one cache line,
+// without touching the list. The whole-vault check hashes every password,
+// sorts the hashes and then only ever moves forward through the list, so it
+// reads the list at most once.
+
+const char* const BREACH_LIST_DEFAULT = "pwned-passwords-sha1.txt";  // Unless PM_BREACH_LIST names one
+const size_t BREACH_MIN_LINE = 41;     // 40 hex digits and a newline
+const int BLOOM_BITS_PER_KEY = 12;     // About 0.7% false positives
+const int BLOOM_PROBES = 8;            // Bits per key, all in one 512-bit block
+const size_t BREACH_GALLOP_START = 4096;  // First step of the forward search, in bytes
+const char BLOOM_MAGIC[8] = { 'P', 'M', 'B', 'L', 'O', 'O', 'M', '1' };
+
+inline int hexValue(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    c |= 0x20;  // Lowercase
+    return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+}
+
+// Read 40 hex digits (either case) at p; false if there are not 40 before end
+bool parseSha1Hex(const char* p, const char* end, Sha1Digest& out)
+{
+    if (end - p < 2 * SHA1_BYTES) return false;
+    for (int i = 0; i < SHA1_BYTES; i++)
+    {
+        int hi = hexValue(p[2 * i]);
+        int lo = hexValue(p[2 * i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        out.bytes[i] = static_cast<uint8_t>(hi << 4 | lo);
+    }
+    return true;
+}
+
+string sha1Hex(const Sha1Digest& digest)
+{
+    static const char digits[] = "0123456789ABCDEF";
+    string hex(2 * SHA1_BYTES, '0');
+    for (int i = 0; i < SHA1_BYTES; i++)
+    {
+        hex[2 * i] = digits[digest.bytes[i] >> 4];
+        hex[2 * i + 1] = digits[digest.bytes[i] & 15];
+    }
+    return hex;
+}
+
+// Header of a .bloom file; one block long so the bit blocks after it stay aligned
+struct BloomHeader
+{
+    char magic[8];
+    uint64_t listSize;    // Size and modification time of the list it was built
+    int64_t listTime;     // from: a changed list needs a new filter
+    uint64_t blocks;      // 64-byte blocks after the header
+    uint64_t keys;        // Hashes added
+    char reserved[24];
+};
+
+// Block and bit positions of a hash. SHA-1 output is already uniform, so its
+// bytes are used directly: 8 for the block, then eight 9-bit positions.
+inline uint64_t bloomProbes(const Sha1Digest& digest, uint64_t blocks, uint16_t bits[BLOOM_PROBES])
+{
+    uint64_t h = 0;
+    uint64_t positions = 0;
+    for (int i = 7; i >= 0; i--)
+    {
+        h = h << 8 | digest.bytes[i];
+        positions = positions << 8 | digest.bytes[8 + i];
+    }
+    for (int i = 0; i < BLOOM_PROBES - 1; i++) bits[i] = (positions >> (9 * i)) & 511;
+    bits[BLOOM_PROBES - 1] = (digest.bytes[16] | digest.bytes[17] << 8) & 511;
+    return h % blocks;
+}
+
+int64_t fileModifiedTime(const string& path)
+{
+    error_code error;
+    auto time = filesystem::last_write_time(path, error);
+    return error ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+// One query of BreachList::lookupSorted
+struct BreachQuery
+{
+    Sha1Digest hash;
+    uint32_t index;   // Caller's own id for the query
+    uint64_t count;   // Set by lookupSorted: times seen in breaches (0 = never)
+};
+
+// A mapped breach list and its filter (lookups are read-only and thread-safe)
+struct BreachList
+{
+    MappedFile list;
+    MappedFile filter;
+    const uint64_t* blocks = nullptr;  // Filter bits, 8 words per block; nullptr without a usable filter
+    uint64_t blockCount = 0;
+
+    // Map a list and its .bloom filter if there is a current one; false if the
+    // list is missing (a missing or stale filter only makes lookups slower)
+    bool open(const string& path)
+    {
+        close();
+        if (!list.open(path)) return false;
+        list.advise(false);
+        if (filter.open(path + ".bloom"))
+        {
+            const BloomHeader* header = reinterpret_cast<const BloomHeader*>(filter.data);
+            bool valid = filter.size >= sizeof(BloomHeader)
+                && memcmp(header->magic, BLOOM_MAGIC, sizeof(BLOOM_MAGIC)) == 0
+                && header->listSize == list.size
+                && header->listTime == fileModifiedTime(path)
+                && header->blocks > 0
+                && filter.size == sizeof(BloomHeader) + header->blocks * 64;
+            if (valid)
+            {
+                blocks = reinterpret_cast<const uint64_t*>(filter.data + sizeof(BloomHeader));
+                blockCount = header->blocks;
+            }
+            else
+            {
+                filter.close();
+            }
+        }
+        return true;
+    }
+
+    void close()
+    {
+        list.close();
+        filter.close();
+        blocks = nullptr;
+        blockCount = 0;
+    }
+
+    bool isOpen() const
+    {
+        return list.data != nullptr;
+    }
+
+    bool hasFilter() const
+    {
+        return blocks != nullptr;
+    }
+
+    // False if the hash is certainly not in the list
+    bool mayContain(const Sha1Digest& digest) const
+    {
+        if (!blocks) return true;
+        uint16_t bits[BLOOM_PROBES];
+        const uint64_t* words = blocks + bloomProbes(digest, blockCount, bits) * 8;
+        for (int i = 0; i < BLOOM_PROBES; i++)
+        {
+            if (!(words[bits[i] >> 6] >> (bits[i] & 63) & 1)) return false;
+        }
+        return true;
+    }
+
+    // Start of the line holding offset, but not before floor
+    size_t lineStart(size_t offset, size_t floor) const
+    {
+        while (offset > floor && list.data[offset - 1] != '\n') offset--;
+        return offset;
+    }
+
+    // Offset just past the line starting at offset
+    size_t lineEnd(size_t offset) const
+    {
+        const void* newline = memchr(list.data + offset, '\n', list.size - offset);
+        return newline ? static_cast<const char*>(newline) - list.data + 1 : list.size;
+    }
+
+    // Whether the line at offset is before the hash (lines without one count as before)
+    bool lineBefore(size_t offset, const Sha1Digest& digest) const
+    {
+        Sha1Digest line;
+        return !parseSha1Hex(list.data + offset, list.data + list.size, line) || line < digest;
+    }
+
+    // First line in [lo, hi) whose hash is >= digest (hi if none); lo and hi
+    // are line starts
+    size_t lowerBound(size_t lo, size_t hi, const Sha1Digest& digest) const
+    {
+        while (lo < hi)
+        {
+            size_t line = lineStart(lo + (hi - lo) / 2, lo);
+            if (lineBefore(line, digest)) lo = lineEnd(line);
+            else hi = line;
+        }
+        return lo;
+    }
+
+    // The count on the line at offset if that line holds digest (0 otherwise;
+    // a line without a count counts once)
+    uint64_t countAt(size_t offset, const Sha1Digest& digest) const
+    {
+        const char* p = list.data + offset;
+        const char* end = list.data + list.size;
+        Sha1Digest line;
+        if (offset >= list.size || !parseSha1Hex(p, end, line) || !(line == digest)) return 0;
+        p += 2 * SHA1_BYTES;
+        uint64_t count = 0;
+        if (p < end && *p == ':')
+        {
+            for (p++; p < end && *p >= '0' && *p <= '9'; p++) count = count * 10 + (*p - '0');
+        }
+        return count ? count : 1;
+    }
+
+    // Times the password with this hash was seen in breaches (0 if never)
+    uint64_t lookup(const Sha1Digest& digest) const
+    {
+        if (!isOpen() || !mayContain(digest)) return 0;
+        return countAt(lowerBound(0, list.size, digest), digest);
+    }
+
+    // lookup() for many hashes at once. The queries are sorted, then each one
+    // gallops forward from where the previous one stopped (steps doubling from
+    // 4 KB), so the list is read front to back, at most once.
+    void lookupSorted(vector<BreachQuery>& queries) const
+    {
+        sort(queries.begin(), queries.end(), [](const BreachQuery& a, const BreachQuery& b) { return a.hash < b.hash; });
+        if (!isOpen()) return;
+        list.advise(true);
+        size_t pos = 0;
+        for (BreachQuery& query : queries)
+        {
+            query.count = 0;
+            if (!mayContain(query.hash)) continue;
+            size_t hi = list.size;
+            for (size_t step = BREACH_GALLOP_START; pos + step < list.size; step *= 2)
+            {
+                size_t line = lineStart(pos + step, pos);
+                if (!lineBefore(line, query.hash))
+                {
+                    hi = line;
+                    break;
+                }
+                pos = lineEnd(line);
+            }
+            pos = lowerBound(pos, hi, query.hash);
+            query.count = countAt(pos, query.hash);
+        }
+        list.advise(false);
+    }
+
+    // Write <path>.bloom from one pass over the list. Returns the hashes added,
+    // or -1 with the reason in error.
+    static long long buildFilter(const string& path, string& error)
+    {
+        BreachList source;
+        if (!source.list.open(path))
+        {
+            error = "cannot read " + path;
+            return -1;
+        }
+        source.list.advise(true);
+        uint64_t blocks = max<uint64_t>(1, (source.list.size / BREACH_MIN_LINE * BLOOM_BITS_PER_KEY + 511) / 512);
+        vector<uint64_t> bits(blocks * 8, 0);
+        long long keys = 0;
+        for (size_t pos = 0; pos < source.list.size; pos = source.lineEnd(pos))
+        {
+            Sha1Digest digest;
+            if (!parseSha1Hex(source.list.data + pos, source.list.data + source.list.size, digest)) continue;
+            uint16_t probes[BLOOM_PROBES];
+            uint64_t* words = bits.data() + bloomProbes(digest, blocks, probes) * 8;
+            for (int i = 0; i < BLOOM_PROBES; i++) words[probes[i] >> 6] |= 1ULL << (probes[i] & 63);
+            keys++;
+        }
+
+        BloomHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, BLOOM_MAGIC, sizeof(BLOOM_MAGIC));
+        header.listSize = source.list.size;
+        header.listTime = fileModifiedTime(path);
+        header.blocks = blocks;
+        header.keys = keys;
+
+        string temp = path + ".bloom.tmp";
+        FILE* file = fopen(temp.c_str(), "wb");
+        bool ok = file
+            && fwrite(&header, sizeof(header), 1, file) == 1
+            && fwrite(bits.data(), sizeof(uint64_t), bits.size(), file) == bits.size()
+            && syncFile(file);
+        if (file) fclose(file);
+        if (!ok || rename(temp.c_str(), (path + ".bloom").c_str()) != 0)
+        {
+            remove(temp.c_str());
+            error = "cannot write " + path + ".bloom";
+            return -1;
+        }
+        return keys;
+    }
+};
+
+// The breach list to use: PM_BREACH_LIST if set, else BREACH_LIST_DEFAULT
+string breachListPath()
+{
+    const char* path = getenv("PM_BREACH_LIST");
+    return path && *path ? path : BREACH_LIST_DEFAULT;
+}
+
+// The breach list, mapped on first use. Not open if the file is missing: the
+// checks are then skipped.
+const BreachList& breachList()
+{
+    static BreachList list;
+    static bool opened = list.open(breachListPath());
+    (void)opened;
+    return list;
+}
+
+// Warn on out if a password is in the breach list; true if it is
+bool warnIfBreached(const string& password, ostream& out)
+{
+    const BreachList& list = breachList();
+    if (!list.isOpen()) return false;
+    uint64_t seen = list.lookup(sha1(password));
+    if (seen == 0) return false;
+    out << "🚨 This password has appeared " << seen << " time(s) in known data breaches. Attackers try these first; choose a different one.\n";
+    return true;
+}
+
+// Add AUDIT_BREACHED to the verdicts of every entry whose password is in the
+// list: hashes all entries in parallel, then one lookupSorted() pass
+void auditBreaches(const VaultStore& vault, const BreachList& list, AuditReport& report)
+{
+    auto start = chrono::steady_clock::now();
+    const RecordSlab& records = vault.records;
+    const VaultSnapshot& base = vault.base;
+    uint32_t slots = records.highWater;
+
+    // Query index: slot for in-memory records, slots + i for snapshot record i
+    vector<BreachQuery> queries(static_cast<size_t>(slots) + base.count);
+    vector<uint8_t> live(queries.size(), 0);
+    parallelFor((queries.size() + AUDIT_GRAIN - 1) / AUDIT_GRAIN, report.threads, [&](size_t item)
+    {
+        string plain;
+        size_t last = min(queries.size(), (item + 1) * AUDIT_GRAIN);
+        for (size_t q = item * AUDIT_GRAIN; q < last; q++)
+        {
+            bool fromSlab = q < slots;
+            uint32_t i = static_cast<uint32_t>(fromSlab ? q : q - slots);
+            if (fromSlab ? !records.at(i).inUse : base.isHidden(i)) continue;
+            if (!decryptPassword(vault.key, fromSlab ? records.at(i).password : base.passwordAt(i), plain)) continue;
+            queries[q] = { sha1(plain), static_cast<uint32_t>(q), 0 };
+            live[q] = 1;
+        }
+        wipeString(plain);
+    });
+    size_t kept = 0;
+    for (size_t q = 0; q < queries.size(); q++)
+    {
+        if (live[q]) queries[kept++] = queries[q];
+    }
+    queries.resize(kept);
+
+    list.lookupSorted(queries);
+    for (const BreachQuery& query : queries)
+    {
+        if (query.count == 0) continue;
+        uint8_t& verdict = query.index < slots ? report.slabVerdicts[query.index] : report.baseVerdicts[query.index - slots];
+        bool wasFlagged = auditFlagged(verdict);
+        verdict |= AUDIT_BREACHED;
+        report.breached++;
+        report.flagged += !wasFlagged;
+    }
+    report.breachChecked = true;
+    report.seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// ==================== PLAINTEXT CACHE ====================
+//
+// Passwords stay sealed in the vault and are opened only when shown. The few
+// that are shown again (the same page, the account being edited, a client
+// polling one login) are kept opened in a small LRU cache so a repeat skips the
+// cipher. Entries are keyed by the sealed record: records are deterministic
+// (see RECORD ENCRYPTION), so an edited password is simply no longer asked for
+// and ages out, and no entry can be stale. An entry is wiped when it is
+// evicted, once it has gone unused for PLAINTEXT_CACHE_SECONDS, and when the
+// vault is closed (logout).
+
+const uint32_t PLAINTEXT_CACHE_ENTRIES = 256;  // Opened passwords kept at most
+const int PLAINTEXT_CACHE_SECONDS = 120;       // Unused this long = wiped
+
+// steady_clock time, to a few milliseconds, for entry ages: Linux's coarse
+// clock costs a few ns a call where steady_clock can cost ~40 (as much as the
+// rest of a cache hit)
+inline chrono::steady_clock::time_point coarseNow()
+{
+#if defined(__linux__) && defined(CLOCK_MONOTONIC_COARSE)
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return chrono::steady_clock::time_point(chrono::duration_cast<chrono::steady_clock::duration>(
+        chrono::seconds(ts.tv_sec) + chrono::nanoseconds(ts.tv_nsec)));
+#else
+    return chrono::steady_clock::now();
+#endif
+}
+
+struct PlaintextCache
+{
+    struct Entry
+    {
+        string record;      // Sealed password (the key)
+        string plain;
+        chrono::steady_clock::time_point used;
+        uint32_t prev;      // Toward the most recently used (NIL at the head)
+        uint32_t next;
+    };
+
+    vector<Entry> entries;                       // Grows to capacity, never moves after
+    vector<uint32_t> freeEntries;                // Wiped entries to reuse
+    unordered_map<string_view, uint32_t> index;  // record -> entry
+    uint32_t head = NIL;                         // Most recently used
+    uint32_t tail = NIL;                         // Least recently used, evicted first
+    uint32_t capacity;
+    chrono::steady_clock::duration ttl;
+    mutex lock;               // Readers under a shared session lock share the cache
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+    PlaintextCache(uint32_t maxEntries = PLAINTEXT_CACHE_ENTRIES)
+        : capacity(maxEntries), ttl(chrono::seconds(PLAINTEXT_CACHE_SECONDS))
+    {
+    }
+
+    ~PlaintextCache()
+    {
+        clear();
+    }
+
+    // The password of a cached record into out; false on a miss
+    bool get(string_view record, string& out)
+    {
+        auto now = coarseNow();
+        lock_guard<mutex> guard(lock);
+        expireBefore(now - ttl);
+        auto it = index.find(record);
+        if (it == index.end())
+        {
+            misses++;
+            return false;
+        }
+        uint32_t e = it->second;
+        unlink(e);
+        pushFront(e);
+        entries[e].used = now;
+        wipeString(out);
+        out.assign(entries[e].plain);
+        hits++;
+        return true;
+    }
+
+    // Remember a record's password, evicting the least recently used at capacity
+    void put(string_view record, string_view plain)
+    {
+        auto now = coarseNow();
+        lock_guard<mutex> guard(lock);
+        if (capacity == 0 || index.count(record)) return;
+        expireBefore(now - ttl);
+        uint32_t e;
+        if (!freeEntries.empty())
+        {
+            e = freeEntries.back();
+            freeEntries.pop_back();
+        }
+        else if (entries.size() < capacity)
+        {
+            if (entries.empty()) entries.reserve(capacity);
+            e = static_cast<uint32_t>(entries.size());
+            entries.emplace_back();
+        }
+        else
+        {
+            e = tail;
+            evict(e);
+            freeEntries.pop_back();
+        }
+        Entry& entry = entries[e];
+        entry.record.assign(record);
+        entry.plain.assign(plain);
+        entry.used = now;
+        pushFront(e);
+        index.emplace(entry.record, e);
+    }
+
+    // Wipe entries unused for ttl (get and put do this as they go)
+    void expire()
+    {
+        auto now = coarseNow();
+        lock_guard<mutex> guard(lock);
+        expireBefore(now - ttl);
+    }
+
+    // Wipe every entry and release the memory
+    void clear()
+    {
+        lock_guard<mutex> guard(lock);
+        for (Entry& entry : entries) wipeString(entry.plain);
+        vector<Entry>().swap(entries);
+        vector<uint32_t>().swap(freeEntries);
+        index.clear();
+        head = NIL;
+        tail = NIL;
+    }
+
+    size_t size()
+    {
+        lock_guard<mutex> guard(lock);
+        return index.size();
+    }
+
+    void unlink(uint32_t e)
+    {
+        Entry& entry = entries[e];
+        (entry.prev == NIL ? head : entries[entry.prev].next) = entry.next;
+        (entry.next == NIL ? tail : entries[entry.next].prev) = entry.prev;
+    }
+
+    void pushFront(uint32_t e)
+    {
+        entries[e].prev = NIL;
+        entries[e].next = head;
+        (head == NIL ? tail : entries[head].prev) = e;
+        head = e;
+    }
+
+    void evict(uint32_t e)
+    {
+        index.erase(entries[e].record);
+        unlink(e);
+        wipeString(entries[e].plain);
+        freeEntries.push_back(e);
+    }
+
+    // The list is in order of use, so expired entries are all at the tail
+    void expireBefore(chrono::steady_clock::time_point cutoff)
+    {
+        while (tail != NIL && entries[tail].used < cutoff) evict(tail);
+    }
+};
+
+// ==================== FAILED ATTEMPTS ====================
+//
+// Failed password checks per identity (an email), for sign-in and for viewing.
+// Each tracked identity keeps its streak of failures since the last success and
+// a count of failures in the last ATTEMPT_WINDOW_SECONDS, kept in
+// ATTEMPT_BUCKETS buckets of equal time: a bucket that falls out of the window
+// is subtracted when time moves past it, so a check or a failure costs O(1)
+// whatever the attempt rate. After ATTEMPT_FREE_FAILURES failures in a row the
+// identity is locked for a delay that doubles with every further failure (up to
+// ATTEMPT_MAX_LOCK_SECONDS); ATTEMPT_WINDOW_LIMIT failures within the window
+// lock it for a whole window. A success forgets the identity. Identities sit in
+// a least-recently-failed list, like PlaintextCache's, and are dropped after
+// ATTEMPT_FORGET_SECONDS without a failure (longer than any lock, so waiting
+// out a lock does not reset the backoff), or, at capacity, from the tail, so
+// memory stays bounded however many identities an attacker tries.
+
+const uint32_t ATTEMPT_TRACKER_ENTRIES = 65536;  // Identities tracked at most
+const int ATTEMPT_WINDOW_SECONDS = 60;
+const int ATTEMPT_BUCKETS = 12;                  // Window granularity: 5 s
+const int ATTEMPT_WINDOW_LIMIT = 10;             // Failures per window before a window-long lock
+const int ATTEMPT_FREE_FAILURES = 3;             // Failures in a row before the backoff starts
+const int ATTEMPT_FIRST_LOCK_SECONDS = 1;
+const int ATTEMPT_MAX_LOCK_SECONDS = 900;
+const int ATTEMPT_FORGET_SECONDS = 3600;         // Without a failure this long = dropped
+
+struct AttemptStatus
+{
+    bool locked = false;
+    chrono::steady_clock::duration retryAfter{ 0 };  // Until the lock ends (0 if not locked)
+    uint32_t streak = 0;                              // Failures since the last success
+    uint32_t recent = 0;                              // Failures in the last ATTEMPT_WINDOW_SECONDS
+
+    long long retrySeconds() const
+    {
+        return chrono::ceil<chrono::seconds>(retryAfter).count();
+    }
+};
+
+struct AttemptTracker
+{
+    struct Entry
+    {
+        string identity;  // The key
+        chrono::steady_clock::time_point lastFailure;
+        chrono::steady_clock::time_point lockedUntil;
+        int64_t newestBucket;  // Bucket number (time / bucket width) buckets[] ends at
+        uint32_t streak;
+        uint32_t recent;       // Sum of buckets
+        uint16_t buckets[ATTEMPT_BUCKETS];
+        uint32_t prev;         // Toward the most recently failed (NIL at the head)
+        uint32_t next;
+    };
+
+    vector<Entry> entries;                       // Grows to capacity, never moves after
+    vector<uint32_t> freeEntries;                // Dropped entries to reuse
+    unordered_map<string_view, uint32_t> index;  // identity -> entry
+    uint32_t head = NIL;                         // Most recently failed
+    uint32_t tail = NIL;                         // Least recently failed, dropped first
+    uint32_t capacity;
+    mutex lock;              // Sign-ins on different threads share the tracker
+    uint64_t evictions = 0;  // Entries dropped at capacity while locked or on a streak
+
+    AttemptTracker(uint32_t maxEntries = ATTEMPT_TRACKER_ENTRIES) : capacity(maxEntries)
+    {
+    }
+
+    static int64_t bucketOf(chrono::steady_clock::time_point t)
+    {
+        return chrono::duration_cast<chrono::milliseconds>(t.time_since_epoch()).count()
+            / (ATTEMPT_WINDOW_SECONDS * 1000 / ATTEMPT_BUCKETS);
+    }
+
+    // Whether identity may try a password now
+    AttemptStatus check(string_view identity, chrono::steady_clock::time_point now = coarseNow())
+    {
+        lock_guard<mutex> guard(lock);
+        expireBefore(now);
+        auto it = index.find(identity);
+        if (it == index.end()) return AttemptStatus();
+        Entry& entry = entries[it->second];
+        slide(entry, bucketOf(now));
+        return statusOf(entry, now);
+    }
+
+    // Count a failed password for identity; the status includes any new lock
+    AttemptStatus fail(string_view identity, chrono::steady_clock::time_point now = coarseNow())
+    {
+        lock_guard<mutex> guard(lock);
+        expireBefore(now);
+        uint32_t e;
+        auto it = index.find(identity);
+        if (it != index.end())
+        {
+            e = it->second;
+            unlink(e);
+        }
+        else
+        {
+            if (capacity == 0) return AttemptStatus();
+            e = allocate(now);
+            Entry& entry = entries[e];
+            entry.identity.assign(identity);
+            entry.lockedUntil = now;
+            entry.newestBucket = bucketOf(now);
+            entry.streak = 0;
+            entry.recent = 0;
+            fill(entry.buckets, entry.buckets + ATTEMPT_BUCKETS, 0);
+            index.emplace(entry.identity, e);
+        }
+        pushFront(e);
+
+        Entry& entry = entries[e];
+        int64_t bucket = bucketOf(now);
+        slide(entry, bucket);
+        uint16_t& count = entry.buckets[bucket % ATTEMPT_BUCKETS];
+        if (count < UINT16_MAX)
+        {
+            count++;
+            entry.recent++;
+        }
+        entry.streak++;
+        entry.lastFailure = now;
+
+        chrono::steady_clock::duration delay{ 0 };
+        if (entry.streak >= ATTEMPT_FREE_FAILURES)
+        {
+            int doublings = static_cast<int>(min<uint32_t>(entry.streak - ATTEMPT_FREE_FAILURES, 30));
+            delay = chrono::seconds(min<long long>(static_cast<long long>(ATTEMPT_FIRST_LOCK_SECONDS) << doublings, ATTEMPT_MAX_LOCK_SECONDS));
+        }
+        if (entry.recent >= ATTEMPT_WINDOW_LIMIT) delay = max<chrono::steady_clock::duration>(delay, chrono::seconds(ATTEMPT_WINDOW_SECONDS));
+        entry.lockedUntil = max(entry.lockedUntil, now + delay);
+        return statusOf(entry, now);
+    }
+
+    // identity got its password right: forget its failures
+    void succeed(string_view identity)
+    {
+        lock_guard<mutex> guard(lock);
+        auto it = index.find(identity);
+        if (it != index.end()) drop(it->second);
+    }
+
+    // Drop identities idle for ATTEMPT_FORGET_SECONDS (check and fail do this as they go)
+    void expire()
+    {
+        auto now = coarseNow();
+        lock_guard<mutex> guard(lock);
+        expireBefore(now);
+    }
+
+    size_t size()
+    {
+        lock_guard<mutex> guard(lock);
+        return index.size();
+    }
+
+    // Move the window up to bucket, emptying the buckets it leaves behind: at
+    // most ATTEMPT_BUCKETS of them, however long the identity was idle
+    static void slide(Entry& entry, int64_t bucket)
+    {
+        if (bucket <= entry.newestBucket) return;
+        if (bucket - entry.newestBucket >= ATTEMPT_BUCKETS)
+        {
+            fill(entry.buckets, entry.buckets + ATTEMPT_BUCKETS, 0);
+            entry.recent = 0;
+        }
+        else
+        {
+            for (int64_t b = entry.newestBucket + 1; b <= bucket; b++)
+            {
+                entry.recent -= entry.buckets[b % ATTEMPT_BUCKETS];
+                entry.buckets[b % ATTEMPT_BUCKETS] = 0;
+            }
+        }
+        entry.newestBucket = bucket;
+    }
+
+    static AttemptStatus statusOf(const Entry& entry, chrono::steady_clock::time_point now)
+    {
+        AttemptStatus status;
+        status.locked = entry.lockedUntil > now;
+        if (status.locked) status.retryAfter = entry.lockedUntil - now;
+        status.streak = entry.streak;
+        status.recent = entry.recent;
+        return status;
+    }
+
+    // A free entry, dropping the least recently failed at capacity
+    uint32_t allocate(chrono::steady_clock::time_point now)
+    {
+        if (freeEntries.empty() && entries.size() < capacity)
+        {
+            if (entries.empty()) entries.reserve(min<uint32_t>(capacity, 1024));
+            entries.emplace_back();
+            return static_cast<uint32_t>(entries.size() - 1);
+        }
+        if (freeEntries.empty())
+        {
+            evictions += entries[tail].lockedUntil > now || entries[tail].streak >= ATTEMPT_FREE_FAILURES;
+            drop(tail);
+        }
+        uint32_t e = freeEntries.back();
+        freeEntries.pop_back();
+        return e;
+    }
+
+    void drop(uint32_t e)
+    {
+        index.erase(entries[e].identity);
+        unlink(e);
+        entries[e].identity.clear();
+        freeEntries.push_back(e);
+    }
+
+    void unlink(uint32_t e)
+    {
+        Entry& entry = entries[e];
+        (entry.prev == NIL ? head : entries[entry.prev].next) = entry.next;
+        (entry.next == NIL ? tail : entries[entry.next].prev) = entry.prev;
+    }
+
+    void pushFront(uint32_t e)
+    {
+        entries[e].prev = NIL;
+        entries[e].next = head;
+        (head == NIL ? tail : entries[head].prev) = e;
+        head = e;
+    }
+
+    // The list is in order of failure, so idle entries are all at the tail
+    void expireBefore(chrono::steady_clock::time_point now)
+    {
+        auto cutoff = now - chrono::seconds(ATTEMPT_FORGET_SECONDS);
+        while (tail != NIL && entries[tail].lastFailure < cutoff) drop(tail);
+    }
+};
+
+// ==================== PASSWORD MANAGER ====================
+
+const int VIEW_PAGE_SIZE = 20;  // Entries printed per page in viewPasswords
+const int SUGGESTION_COUNT = 3;  // "Did you mean" names offered for a mistyped account
+const int VAULT_WRONG_KEY = -2;  // openVault(): the saved vault was sealed under another password
+const int VAULT_LOCKED_OUT = -3; // SessionTable::open(): too many failed sign-ins, retry later
+const size_t MAX_ENTRY_BYTES = PROTO_MAX_FIELD;  // Longest account name or password: one daemon protocol field
+
+// Whether an entry can be stored: every stored entry must fit the daemon's
+// protocol, which has no way to send a longer value
+bool entryFits(string_view account, string_view password)
+{
+    return account.size() <= MAX_ENTRY_BYTES && password.size() <= MAX_ENTRY_BYTES;
+}
+
+struct PasswordManager 
+{
+    VaultStore vault;  // Record slab + name indexes + password reuse index
+    Journal journal;   // Write-ahead log of every mutation (closed = not persisted)
+    string vaultPath;  // vaultPathFor() of the user; empty when not persisted
+    ActionHistory history;          // Undo/redo logs for this vault
+    AttemptTracker viewAttempts{ 1 };  // Failed password checks before viewing (of owner only)
+    PlaintextCache plaintexts;      // Recently shown passwords, opened (wiped on logout)
+    const UserAuth* owner = nullptr;  // Signed-in user viewing is checked against
+    thread checkpointThread;
+    atomic<bool> checkpointRunning{ false };
+    atomic<bool> checkpointOk{ true };
+
+    // Destructor to clean up memory
+    ~PasswordManager()
+    {
+        clearAllPasswords();
+    }
+
+    // The password in a record into out, from the plaintext cache or opened
+    // (and cached if remember is set; full listings pass false so they do not
+    // flush it). False if the record cannot be opened.
+    bool revealPassword(string_view record, string& out, bool remember = true)
+    {
+        if (plaintexts.get(record, out)) return true;
+        if (!decryptPassword(vault.key, record, out)) return false;
+        if (remember) plaintexts.put(record, out);
+        return true;
+    }
+
+    // Find node by account name
+    PasswordNode* findNodeByAccount(const string& account)
+    {
+        return vault.find(account);
+    }
+
+    // Check if password is already used by another account (hash index lookup, O(1) average)
+    string findAccountWithPassword(const string& encryptedPassword, const string& excludeAccount)
+    {
+        PasswordNode* other = vault.findOtherWithPassword(encryptedPassword, excludeAccount);
+        return other ? string(other->accountName) : "";
+    }
+
+    // Add a new password
+    void addPassword() 
+    {
+        cin.ignore(); // Clear the input buffer (removes leftover newline from previous cin >> choice)
+        string account, pass;
+        
+        // Loop until non-empty account name is entered
+        while (true)
+        {
+            cout << "\nEnter Account Name (e.g., Gmail, Facebook, Bank): ";
+            getline(cin, account);
+            
+            if (!account.empty())
+            {
+                break; // Valid account name, exit loop
+            }
+            else
+            {
+                cout << "❌ Account name cannot be empty. Please try again.\n";
+            }
+        }
+
+        if (vault.find(account))
+        {
+            cout << "❌ Account " << account << " already exists. Use Edit Password to change it.\n";
+            return;
+        }
+
+        cout << "Enter Password for " << account << " (leave empty to generate one): ";
+        getline(cin, pass);
+        if (pass.empty())
+        {
+            SecureRandom rng;
+            PasswordGenerator().generate(rng, pass);
+            cout << "🔑 Generated password: " << pass << "\n";
+        }
+
+        addPasswordEntry(account, pass, cout);
+        wipeString(pass);
+    }
+
+    // Add a password without prompting; messages go to out. Returns false if the
+    // account already exists or the entry is too long.
+    bool addPasswordEntry(const string& account, const string& pass, ostream& out)
+    {
+        if (!entryFits(account, pass))
+        {
+            out << "❌ Account names and passwords can be at most " << MAX_ENTRY_BYTES << " bytes.\n";
+            return false;
+        }
+        if (vault.find(account))
+        {
+            out << "❌ Account " << account << " already exists. Use Edit Password to change it.\n";
+            return false;
+        }
+
+        uint8_t strength;
+        checkAndSuggestStrength(pass, out, &strength);
+        warnIfBreached(pass, out);
+
+        string encrypted = encryptPassword(vault.key, pass);
+        
+        // Check if this password is already used by another account
+        string existingAccount = findAccountWithPassword(encrypted, account);
+        if (!existingAccount.empty())
+        {
+            out << "⚠️ Warning: This password is already used for account \"" << existingAccount << "\". Try a new password for better security.\n";
+        }
+        
+        // Store the record (indexes it by name and by password hash)
+        vault.add(account, encrypted, strength);
+        journal.append(ActionType::Add, account, encrypted);
+
+        // Record action for undo (this also clears the redo log)
+        history.record(ActionType::Add, account, string_view(), encrypted);
+
+        out << "✅ Password for " << account << " added successfully!\n";
+        return true;
+    }
+
+    // View all passwords (using BST for sorted display)
+    void viewPasswords() 
+    {
+        string_view identity = owner ? string_view(owner->email) : string_view();
+        AttemptStatus attempts = viewAttempts.check(identity);
+        if (attempts.locked)
+        {
+            cout << "🔒 Too many failed attempts. Try again in " << attempts.retrySeconds() << " second(s).\n";
+            return;
+        }
+        if (!verifyPassword(owner)) 
+        {
+            attempts = viewAttempts.fail(identity);
+            if (attempts.streak >= ATTEMPT_FREE_FAILURES)
+            {
+                cout << "⚠️ Multiple failed view attempts detected (" << attempts.streak << " in a row, "
+                     << attempts.recent << " in the last minute).\n";
+            }
+            if (attempts.locked)
+            {
+                cout << "🔒 Viewing is locked for " << attempts.retrySeconds() << " second(s).\n";
+            }
+            return;
+        }
+        viewAttempts.succeed(identity);
+        
+        if (vault.isEmpty()) 
+        {
+            cout << "\nNo passwords saved yet.\n";
+            return;
+        }
+
+        // Stream entries in sorted order from a read view, one page at a time: the
+        // listing stays one consistent version however long the user pages, and
+        // holds no lock, so writers to the same vault never wait on it.
+        // Passwords not in the plaintext cache are opened in one batch call per
+        // page and cached; each page is formatted into one buffer and written
+        // with a single flush, and the copies are wiped after.
+        vault.enableReadViews();
+        VaultReadView view(vault.versions);
+        VersionIterator it = view.begin();
+        int shown = 0;
+        string page;
+        const VersionNode* nodes[VIEW_PAGE_SIZE];
+        string_view records[VIEW_PAGE_SIZE];
+        string passwords[VIEW_PAGE_SIZE];
+        string* plain[VIEW_PAGE_SIZE];
+        int missed[VIEW_PAGE_SIZE];
+
+        cout << "\n========== Your Stored Passwords (Sorted by Account Name) ==========\n";
+        while (it.hasNext())
+        {
+            int count = 0;
+            int misses = 0;
+            while (count < VIEW_PAGE_SIZE && it.hasNext())
+            {
+                nodes[count] = it.next();
+                string_view record = nodes[count]->password();
+                if (!plaintexts.get(record, passwords[count]))
+                {
+                    records[misses] = record;
+                    plain[misses] = &passwords[count];
+                    missed[misses++] = count;
+                }
+                count++;
+            }
+            decryptPasswordsBatch(vault.key, records, plain, misses, 1);
+            for (int m = 0; m < misses; m++) plaintexts.put(records[m], passwords[missed[m]]);
+
+            page.clear();
+            for (int i = 0; i < count; i++)
+            {
+                page += to_string(++shown);
+                page += ". Account: ";
+                page += nodes[i]->name();
+                page += "\n   Password: ";
+                page += passwords[i];
+                page += "\n   ------------------------------------------\n";
+                wipeString(passwords[i]);
+            }
+            cout << page << flush;
+            wipeString(page);
+
+            if (it.hasNext())
+            {
+                cout << "Show next page? (y/n): ";
+                char more;
+                if (!(cin >> more) || (more != 'y' && more != 'Y'))
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    // Look up a typed account name. On a miss, list the closest names and let the
+    // user pick one (account then holds that name). nullptr if none is chosen.
+    PasswordNode* resolveAccount(string& account)
+    {
+        PasswordNode* node = vault.find(account);
+        if (node)
+        {
+            return node;
+        }
+
+        cout << "❌ Account not found.\n";
+        FuzzyMatch suggestions[SUGGESTION_COUNT];
+        int found = vault.closestNames(account, typoBudget(account.size()), suggestions, SUGGESTION_COUNT);
+        if (found == 0)
+        {
+            return nullptr;
+        }
+
+        cout << "❓ Did you mean:\n";
+        for (int i = 0; i < found; i++)
+        {
+            cout << "   " << i + 1 << ". " << suggestions[i].name << "\n";
+        }
+        cout << "Enter its number, or press Enter to cancel: ";
+        string choice;
+        getline(cin, choice);
+        int pick = atoi(choice.c_str());
+        if (pick < 1 || pick > found)
+        {
+            return nullptr;
+        }
+
+        account.assign(suggestions[pick - 1].name);
+        return vault.find(account);
+    }
+
+    // Edit existing password (uses the name index for fast searching)
+    void editPassword()
+    {
+        if (vault.isEmpty())
+        {
+            cout << "\nNo passwords to edit.\n";
+            return;
+        }
+
+        cin.ignore();
+        string account;
+        cout << "\nEnter Account Name to edit: ";
+        getline(cin, account);
+
+        PasswordNode* node = resolveAccount(account);
+        if (!node)
+        {
+            return;
+        }
+
+        string current;
+        revealPassword(node->password, current);
+        cout << "Current Password: " << current << endl;
+        wipeString(current);
+        string newPass;
+        cout << "Enter New Password: ";
+        getline(cin, newPass);
+
+        editPasswordEntry(account, newPass, cout);
+    }
+
+    // Change a password without prompting; messages go to out. Returns false if
+    // the account does not exist or the password is too long.
+    bool editPasswordEntry(const string& account, const string& newPass, ostream& out)
+    {
+        if (!entryFits(account, newPass))
+        {
+            out << "❌ Account names and passwords can be at most " << MAX_ENTRY_BYTES << " bytes.\n";
+            return false;
+        }
+        PasswordNode* node = vault.find(account);
+        if (!node)
+        {
+            out << "❌ Account not found.\n";
+            return false;
+        }
+
+        uint8_t strength;
+        checkAndSuggestStrength(newPass, out, &strength);
+        warnIfBreached(newPass, out);
+
+        string encryptedNewPass = encryptPassword(vault.key, newPass);
+        
+        // Check if this password is already used by another account
+        string existingAccount = findAccountWithPassword(encryptedNewPass, account);
+        if (!existingAccount.empty())
+        {
+            out << "⚠️ Warning: This password is already used for account \"" << existingAccount << "\". Try a new password for better security.\n";
+        }
+
+        // Record action for undo, keeping the encrypted old password
+        history.record(ActionType::Edit, account, node->password, encryptedNewPass);
+
+        vault.setPassword(node, encryptedNewPass, strength);
+        journal.append(ActionType::Edit, account, encryptedNewPass);
+
+        out << "✅ Password updated for " << account << "!\n";
+        return true;
+    }
+
+    // Delete a password (removes it from the vault and both indexes)
+    void deletePassword()
+    {
+        if (vault.isEmpty())
+        {
+            cout << "\nNo passwords to delete.\n";
+            return;
+        }
+
+        cin.ignore();
+        string account;
+        cout << "\nEnter Account Name to delete: ";
+        getline(cin, account);
+
+        if (resolveAccount(account))
+        {
+            deletePasswordEntry(account, cout);
+        }
+    }
+
+    // Delete a password without prompting; messages go to out. Returns false if
+    // the account does not exist.
+    bool deletePasswordEntry(const string& account, ostream& out)
+    {
+        // Use the name index to quickly find the PasswordNode
+        PasswordNode* nodeToDelete = vault.find(account);
+        
+        if (!nodeToDelete)
+        {
+            out << "❌ Account not found.\n";
+            return false;
+        }
+
+        // Record action for undo, keeping the encrypted password
+        history.record(ActionType::Delete, account, nodeToDelete->password, string_view());
+
+        // Remove from every index, then wipe and free the record
+        vault.erase(nodeToDelete);
+        journal.append(ActionType::Delete, account, string_view());
+
+        out << "✅ Password for " << account << " deleted successfully!\n";
+        return true;
+    }
+
+    // Undo last action (messages go to out). Returns false if there was nothing
+    // to undo or the vault no longer matched the action.
+    bool undo(ostream& out = cout)
+    {
+        if (!history.canUndo())
+        {
+            out << "\n❌ Nothing to undo!\n";
+            return false;
+        }
+
+        Action action = history.nextUndo();
+        history.markUndone(); // Move to redo log
+        string_view account = history.accountOf(action);
+        bool success = false;
+
+        if (action.type == ActionType::Add)
+        {
+            // Find the node with matching account name AND password
+            PasswordNode* node = vault.find(account);
+
+            if (node && node->password == action.newPassword())
+            {
+                vault.erase(node);
+                journal.append(ActionType::Delete, account, string_view());
+                out << "✅ Undo: Removed password for " << account << "\n";
+                success = true;
+            }
+            else
+            {
+                out << "⚠️ Undo: Could not find password for " << account << " to remove.\n";
+            }
+        }
+        else if (action.type == ActionType::Edit)
+        {
+            // Restore old password (name index lookup)
+            PasswordNode* node = vault.find(account);
+            if (node)
+            {
+                // Verify the current password matches what we expect (the newPassword from the action)
+                if (node->password == action.newPassword())
+                {
+                    vault.setPassword(node, action.oldPassword());
+                    journal.append(ActionType::Edit, account, action.oldPassword());
+                    out << "✅ Undo: Restored old password for " << account << "\n";
+                    success = true;
+                }
+                else
+                {
+                    out << "⚠️ Undo: Password for " << account << " has been modified. Cannot undo.\n";
+                }
+            }
+            else
+            {
+                out << "⚠️ Undo: Account " << account << " not found. Cannot undo edit.\n";
+            }
+        }
+        else if (action.type == ActionType::Delete)
+        {
+            // Re-add the deleted password
+            if (vault.add(account, action.oldPassword()))
+            {
+                journal.append(ActionType::Add, account, action.oldPassword());
+                out << "✅ Undo: Restored password for " << account << "\n";
+                success = true;
+            }
+            else
+            {
+                out << "⚠️ Undo: Account " << account << " was added again. Cannot restore the deleted password.\n";
+            }
+        }
+        return success;
+    }
+
+    // Redo last undone action (messages go to out). Returns false if there was
+    // nothing to redo or it could not be reapplied.
+    bool redo(ostream& out = cout)
+    {
+        if (!history.canRedo())
+        {
+            out << "\n❌ Nothing to redo!\n";
+            return false;
+        }
+
+        // The step stays on the redo log unless it is reapplied
+        Action action = history.nextRedo();
+        string_view account = history.accountOf(action);
+        bool success = false;
+
+        if (action.type == ActionType::Add)
+        {
+            // Check if account already exists (name index lookup)
+            PasswordNode* existing = vault.find(account);
+            if (existing)
+            {
+                // Check if it's the same password (from a previous redo)
+                if (existing->password == action.newPassword())
+                {
+                    out << "⚠️ Redo: Password for " << account << " already exists.\n";
+                    return false;
+                }
+                else
+                {
+                    out << "⚠️ Redo: Account " << account << " already exists with different password. Cannot redo.\n";
+                    return false;
+                }
+            }
+
+            // Re-add the password
+            vault.add(account, action.newPassword());
+            journal.append(ActionType::Add, account, action.newPassword());
+
+            out << "✅ Redo: Re-added password for " << account << "\n";
+            success = true;
+        }
+        else if (action.type == ActionType::Edit)
+        {
+            // Reapply new password (name index lookup)
+            PasswordNode* node = vault.find(account);
+            if (node)
+            {
+                // Verify the current password matches the oldPassword (what we expect after undo)
+                if (node->password == action.oldPassword())
+                {
+                    vault.setPassword(node, action.newPassword());
+                    journal.append(ActionType::Edit, account, action.newPassword());
+                    out << "✅ Redo: Reapplied new password for " << account << "\n";
+                    success = true;
+                }
+                else
+                {
+                    out << "⚠️ Redo: Password for " << account << " has been modified. Cannot redo.\n";
+                    return false;
+                }
+            }
+            else
+            {
+                out << "⚠️ Redo: Account " << account << " not found. Cannot redo edit.\n";
+                return false;
+            }
+        }
+        else if (action.type == ActionType::Delete)
+        {
+            // Use the name index to find the node quickly
+            PasswordNode* nodeToDelete = vault.find(account);
+            
+            if (!nodeToDelete || nodeToDelete->password != action.oldPassword())
+            {
+                out << "⚠️ Redo: Could not find password for " << account << " to delete.\n";
+                return false;
+            }
+
+            vault.erase(nodeToDelete);
+            journal.append(ActionType::Delete, account, string_view());
+            out << "✅ Redo: Deleted password for " << account << "\n";
+            success = true;
+        }
+
+        // Only move to the undo log if redo was successful
+        if (success)
+        {
+            history.markRedone();
+        }
+        return success;
+    }
+
+    // Bulk import "account<TAB>password" lines (plaintext passwords) from a file.
+    // Records are sorted once, duplicates and existing accounts are dropped, and the
+    // BST is rebuilt from the merged sorted array in O(n) instead of n single inserts.
+    // Returns the number of imported records, or -1 if the file cannot be opened.
+    int importFromFile(const string& path, int& skipped, int& reused)
+    {
+        ifstream in(path);
+        if (!in)
+        {
+            return -1;
+        }
+
+        skipped = 0;
+        reused = 0;
+
+        vector<pair<string, string>> incoming;
+        string line;
+        while (getline(in, line))
+        {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            size_t tab = line.find('\t');
+            if (tab == string::npos || tab == 0 || !entryFits(string_view(line).substr(0, tab), string_view(line).substr(tab + 1)))
+            {
+                if (!line.empty()) skipped++;  // Malformed or too long
+                continue;
+            }
+            incoming.emplace_back(line.substr(0, tab), line.substr(tab + 1));
+        }
+
+        // Sort once; stable so the first occurrence of a duplicate name wins
+        stable_sort(incoming.begin(), incoming.end(),
+            [](const pair<string, string>& a, const pair<string, string>& b)
+            {
+                return a.first < b.first;
+            });
+
+        // Score the passwords for later audits while they are still plaintext,
+        // then seal them all in one batch call, spread over the cores
+        vector<uint8_t> strengths = estimateStrengths(incoming);
+        vector<string*> passwords(incoming.size());
+        for (size_t i = 0; i < incoming.size(); i++) passwords[i] = &incoming[i].second;
+        encryptPasswordsBatch(vault.key, passwords.data(), passwords.size());
+
+        int imported = vault.bulkLoadSorted(incoming, skipped, reused, &strengths);
+        if (imported > 0)
+        {
+            history.clearRedo(); // A bulk import is a new change, like addPassword
+
+            // Journal every row in sorted order; replaying Add keeps the first
+            // of any duplicate name, exactly as bulkLoadSorted did
+            for (const auto& row : incoming) journal.append(ActionType::Add, row.first, row.second);
+            journal.commit();
+        }
+        return imported;
+    }
+
+    // Prompt for a file and bulk import it
+    void bulkImport()
+    {
+        cin.ignore();
+        string path;
+        cout << "\nEnter path of file to import (one \"account<TAB>password\" per line): ";
+        getline(cin, path);
+
+        int skipped = 0;
+        int reused = 0;
+        auto start = chrono::steady_clock::now();
+        int imported = importFromFile(path, skipped, reused);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        if (imported < 0)
+        {
+            cout << "❌ Could not open " << path << ".\n";
+            return;
+        }
+
+        cout << "✅ Imported " << imported << " passwords";
+        if (seconds > 0)
+        {
+            cout << " (" << static_cast<long long>(imported / seconds) << " records/second)";
+        }
+        cout << ".\n";
+        if (skipped > 0)
+        {
+            cout << "⚠️ Skipped " << skipped << " duplicate, malformed or too long records.\n";
+        }
+        if (reused > 0)
+        {
+            cout << "⚠️ " << reused << " imported passwords are already used by another account.\n";
+        }
+    }
+
+    // List account names that start with what the user types (one page at most)
+    void searchByPrefix()
+    {
+        cin.ignore();
+        string prefix;
+        cout << "\nEnter the start of an account name: ";
+        getline(cin, prefix);
+
+        // Ask for one extra match to know whether the page is complete
+        string_view matches[VIEW_PAGE_SIZE + 1];
+        int found = vault.withPrefix(prefix, matches, VIEW_PAGE_SIZE + 1);
+        if (found == 0)
+        {
+            cout << "❌ No accounts start with \"" << prefix << "\".\n";
+            return;
+        }
+
+        string page = "\n========== Accounts starting with \"" + prefix + "\" ==========\n";
+        for (int i = 0; i < found && i < VIEW_PAGE_SIZE; i++)
+        {
+            page += to_string(i + 1);
+            page += ". ";
+            page += matches[i];
+            page += "\n";
+        }
+        if (found > VIEW_PAGE_SIZE)
+        {
+            page += "... more accounts match. Type more letters to narrow the list.\n";
+        }
+        cout << page << flush;
+    }
+
+    // Check every stored password for strength, reuse and known breaches, and list the accounts
+    // to fix in name order (passwords themselves are never shown)
+    void auditPasswords()
+    {
+        if (vault.isEmpty())
+        {
+            cout << "\nNo passwords saved yet.\n";
+            return;
+        }
+
+        AuditReport report = auditVault(vault);
+        if (breachList().isOpen()) auditBreaches(vault, breachList(), report);
+        string page = "\n========== Vault Audit ==========\n";
+        page += to_string(report.entries) + " password(s) checked in " + to_string(static_cast<long long>(report.seconds * 1000)) + " ms.\n";
+        if (!report.breachChecked)
+        {
+            page += "ℹ️ No breach list found; set PM_BREACH_LIST to a SHA-1 breach list to check for breached passwords.\n";
+        }
+        if (report.flagged == 0)
+        {
+            cout << page << "✅ Every password is strong and used only once.\n";
+            return;
+        }
+        page += "⚠️ Weak: " + to_string(report.weak) + " (no uppercase: " + to_string(report.noUpper)
+            + ", no number: " + to_string(report.noDigit) + ", no symbol: " + to_string(report.noSymbol)
+            + ", easy to guess: " + to_string(report.guessable) + ")\n";
+        page += "⚠️ Reused: " + to_string(report.reused) + "\n";
+        if (report.breachChecked) page += "🚨 In known breaches: " + to_string(report.breached) + "\n";
+
+        int listed = 0;
+        forEachAudited(vault, report, [&](PasswordNode* node, uint8_t verdict)
+        {
+            if (!auditFlagged(verdict)) return true;
+            page += "   - ";
+            page += node->accountName;
+            page += ": " + auditFindings(verdict) + "\n";
+            return ++listed < AUDIT_LIST_LIMIT;
+        });
+        if (report.flagged > static_cast<uint64_t>(listed))
+        {
+            page += "   ... and " + to_string(report.flagged - listed) + " more.\n";
+        }
+        cout << page << flush;
+    }
+
+    // Load the user's vault files: map the snapshot, replay any segment an earlier
+    // checkpoint did not finish, then replay the journal and keep it open for new
+    // mutations. Returns journal records replayed, -1 if a file is unreadable
+    // (or the vault open before could not be saved), or VAULT_WRONG_KEY if
+    // vault.key does not open the saved passwords.
+    int openVault(const string& path)
+    {
+        if (!clearAllPasswords()) return -1;
+        vaultPath = path;
+        if (!vault.attachSnapshot(path + ".snap") && filesystem::exists(path + ".snap"))
+        {
+            vaultPath.clear();
+            return -1;
+        }
+
+        uintmax_t validSize = 0;
+        int replayed = Journal::replayFile(path + ".wal.ckpt", vault, validSize);
+        bool unfinishedFold = validSize > 0;
+        int fromJournal = replayed < 0 ? -1 : journal.open(path + ".wal", vault);
+        if (fromJournal < 0)
+        {
+            vaultPath.clear();
+            vault.clear();
+            return -1;
+        }
+        if (!keyOpensVault())
+        {
+            clearAllPasswords();
+            return VAULT_WRONG_KEY;
+        }
+        if (unfinishedFold)
+        {
+            startCheckpoint();
+        }
+        return replayed + fromJournal;
+    }
+
+    // Whether vault.key opens the saved passwords (tried on the first record; every
+    // record of a vault is sealed under the same key)
+    bool keyOpensVault()
+    {
+        VaultIterator it = vault.begin();
+        if (!it.hasNext()) return true;
+        string plain;
+        bool opened = decryptPassword(vault.key, it.next()->password, plain);
+        wipeString(plain);
+        return opened;
+    }
+
+    // Fold the journal into a new snapshot on a background thread. The journal is
+    // first rotated to .wal.ckpt, so this session keeps appending to a fresh one
+    // while the thread merges the old snapshot with the rotated segment.
+    // Returns false if no checkpoint was started.
+    bool startCheckpoint()
+    {
+        if (vaultPath.empty() || checkpointRunning) return false;
+        finishCheckpoint();  // Reap the previous thread
+
+        string segment = vaultPath + ".wal.ckpt";
+        if (!filesystem::exists(segment))
+        {
+            string active = vaultPath + ".wal";
+            if (!journal.commit()) return false;  // Keep failed records pending for a retry
+            journal.close();
+            error_code ec;
+            filesystem::rename(active, segment, ec);
+            // On failure the old journal is reopened; replaying it again is harmless
+            // because every record carries its final value
+            if (journal.open(active, vault) < 0 || ec) return false;
+        }
+
+        checkpointRunning = true;
+        string path = vaultPath;
+        string salt(reinterpret_cast<const char*>(vault.key.salt), VAULT_SALT_BYTES);
+        checkpointThread = thread([this, path, salt]()
+            {
+                checkpointOk = foldJournal(path, reinterpret_cast<const uint8_t*>(salt.data()));
+                checkpointRunning = false;
+            });
+        return true;
+    }
+
+    // Start a checkpoint once the journal has grown past CHECKPOINT_JOURNAL_BYTES.
+    // Returns false if a checkpoint that finished since the last call failed
+    // (reported once). Nothing is lost then: the segment stays on disk, is
+    // replayed on open, and the next checkpoint folds it again.
+    bool maybeCheckpoint()
+    {
+        bool ok = checkpointRunning || checkpointOk.exchange(true);
+        if (journal.bytes >= CHECKPOINT_JOURNAL_BYTES) startCheckpoint();
+        return ok;
+    }
+
+    // Wait for a running checkpoint; returns whether the last one succeeded
+    bool finishCheckpoint()
+    {
+        if (checkpointThread.joinable()) checkpointThread.join();
+        return checkpointOk;
+    }
+
+    // Make everything done since the last sync durable (one fsync per call)
+    bool syncJournal()
+    {
+        return journal.commit();
+    }
+
+    // Clear all passwords (commits and closes the journal and waits for any
+    // checkpoint first). Returns false if the last changes could not be written;
+    // a checkpoint failing here loses nothing, as openVault() folds it again.
+    bool clearAllPasswords() 
+    {
+        bool saved = journal.close();
+        finishCheckpoint();
+        vaultPath.clear();
+        vault.clear();
+        plaintexts.clear();
+        return saved;
+    }
+};
+
+// ==================== SESSIONS ====================
+
+const int SESSION_SHARDS = 64;  // Independently locked parts of the session table
+
+// One signed-in user: their credentials and a PasswordManager owning their vault,
+// undo history and view attempts. Nothing is shared between sessions, so work on
+// different vaults never waits on the same lock. Within a session, lock is taken
+// shared for reads that leave the vault unchanged (VaultStore::lookup, listing)
+// and exclusively for everything else (find can promote snapshot records).
+// Full scans use readView() instead and take no lock at all.
+struct Session
+{
+    UserAuth user;
+    PasswordManager pm;
+    shared_mutex lock;
+    bool rejected = false;  // Its password did not open the saved vault (it is being dropped)
+
+    explicit Session(const string& email) : user(email)
+    {
+        pm.owner = &user;
+    }
+
+    // Lock-free view of the vault for scans that must not block writers. The
+    // first call turns read views on under the exclusive lock, so the caller
+    // must not hold lock.
+    VaultReadView readView()
+    {
+        if (!pm.vault.versions.enabled)
+        {
+            lock_guard<shared_mutex> guard(lock);
+            pm.vault.enableReadViews();
+        }
+        return VaultReadView(pm.vault.versions);
+    }
+};
+
+// Signed-in sessions by email, split into shards by hash, each with its own
+// mutex, so signing different users in and out rarely touches the same lock.
+// A Session stays at the same address until close(). Each shard also tracks
+// failed sign-ins of its emails, so a password guesser is slowed down before
+// any key is derived for it.
+struct SessionTable
+{
+    struct Shard
+    {
+        mutex lock;
+        unordered_map<string, shared_ptr<Session>> sessions;
+        AttemptTracker failedOpens{ ATTEMPT_TRACKER_ENTRIES / SESSION_SHARDS };
+    };
+
+    Shard shards[SESSION_SHARDS];
+
+    Shard& shardFor(const string& email)
+    {
+        return shards[hash<string>()(email) % SESSION_SHARDS];
+    }
+
+    // The user's session, signing them in if needed. A new session derives the
+    // vault key and its sign-in verifier, and loads the saved vault when persist
+    // is set; opened is openVault()'s result then (0 otherwise). Another
+    // signer-in waits until loading is done, then derives again to be checked
+    // against the verifier. Returns nullptr if the user is already signed in with a
+    // different password, or if the password does not open the saved vault
+    // (both count as failures), with opened = -1 if the saved vault cannot be
+    // read (the next Open tries again), or with opened = VAULT_LOCKED_OUT while
+    // too many failures lock the email out.
+    Session* open(const string& email, const string& password, bool persist, int& opened)
+    {
+        opened = 0;
+        Shard& shard = shardFor(email);
+        if (shard.failedOpens.check(email).locked)
+        {
+            opened = VAULT_LOCKED_OUT;
+            return nullptr;
+        }
+        while (true)
+        {
+            unique_lock<mutex> shardGuard(shard.lock);
+            auto it = shard.sessions.find(email);
+            if (it != shard.sessions.end())
+            {
+                shared_ptr<Session> existing = it->second;
+                shardGuard.unlock();
+                {
+                    lock_guard<shared_mutex> loaded(existing->lock);  // Its verifier is set once this is free
+                    if (existing->rejected) continue;  // That sign-in failed; start over
+                }
+                if (!existing->user.matches(password))
+                {
+                    shard.failedOpens.fail(email);
+                    return nullptr;
+                }
+                shard.failedOpens.succeed(email);
+                return existing.get();
+            }
+
+            shared_ptr<Session> session = make_shared<Session>(email);
+            lock_guard<shared_mutex> loading(session->lock);
+            shard.sessions.emplace(email, session);
+            shardGuard.unlock();
+            // Key derivation is slow on purpose; only this user's signer-ins wait
+            VaultKey& key = session->pm.vault.key;
+            string path = persist ? vaultPathFor(email) : string();
+            if (persist) readVaultSalt(path, key.salt);
+            deriveVaultKey(password, key, session->user.verifier);
+            memcpy(session->user.salt, key.salt, VAULT_SALT_BYTES);
+            if (persist)
+            {
+                opened = session->pm.openVault(path);
+                if (opened < 0)
+                {
+                    session->rejected = true;
+                    if (opened == VAULT_WRONG_KEY) shard.failedOpens.fail(email);
+                    lock_guard<mutex> guard(shard.lock);
+                    shard.sessions.erase(email);
+                    return nullptr;
+                }
+            }
+            shard.failedOpens.succeed(email);
+            return session.get();
+        }
+    }
+
+    // Sign a user out: saves and wipes their vault and frees the session. No
+    // other thread may still be using it. False if its last changes could not
+    // be written.
+    bool close(const string& email)
+    {
+        shared_ptr<Session> closing;
+        {
+            Shard& shard = shardFor(email);
+            lock_guard<mutex> guard(shard.lock);
+            auto it = shard.sessions.find(email);
+            if (it == shard.sessions.end()) return true;
+            closing = move(it->second);
+            shard.sessions.erase(it);
+        }
+        return closing->pm.clearAllPasswords();
+    }
+
+    // Sign everyone out; returns how many vaults could not be saved. No other
+    // thread may still be using the table.
+    size_t closeAll()
+    {
+        size_t unsaved = 0;
+        for (Shard& shard : shards)
+        {
+            lock_guard<mutex> guard(shard.lock);
+            for (auto& entry : shard.sessions)
+            {
+                if (!entry.second->pm.clearAllPasswords()) unsaved++;
+            }
+            shard.sessions.clear();
+        }
+        return unsaved;
+    }
+
+    size_t size()
+    {
+        size_t n = 0;
+        for (Shard& shard : shards)
+        {
+            lock_guard<mutex> guard(shard.lock);
+            n += shard.sessions.size();
+        }
+        return n;
+    }
+};
+
+// ==================== BATCH MODE ====================
+
+const size_t BATCH_OUTPUT_FLUSH = 1 << 16;  // Buffered output bytes per write
+const int BATCH_SYNC_EVERY = 1024;          // Commands per journal group commit
+
+// Swallows the human-readable messages of the stdin-free PasswordManager paths
+ostream nullOut(nullptr);
+
+// Splits a tab-separated line into at most maxFields views (returns the count)
+int splitFields(string_view line, string_view fields[], int maxFields)
+{
+    int n = 0;
+    while (n < maxFields - 1)
+    {
+        size_t tab = line.find('\t');
+        if (tab == string_view::npos) break;
+        fields[n++] = line.substr(0, tab);
+        line.remove_prefix(tab + 1);
+    }
+    fields[n++] = line;
+    return n;
+}
+
+// Runs a command script with no prompts. One command per line, fields separated
+// by tabs (like the bulk import format):
+//   login <email> [<password>] | logout | add <account> <password> | edit <account> <password>
+//   delete <account> | undo | redo | search <account> | view | prefix <start> [<k>]
+//   fuzzy <account> [<edits>] | audit
+// Blank lines and lines starting with '#' are skipped. Each command prints one
+// result line, "OK" or "ERR", the command and a detail; search and view first
+// print their entries as "=<TAB>account<TAB>password" lines, prefix prints
+// the first k (default 10) matching names as "=<TAB>account" lines, and fuzzy
+// prints up to 10 names within the given edits (default by length) as
+// "=<TAB>account<TAB>distance" lines, closest first, and audit prints every weak
+// or reused account as "=<TAB>account<TAB>findings". Without login the
+// vault is in memory only; login derives the vault key from the email and
+// password (an empty one if omitted, which protects nothing). Output is written in 64 KB chunks and the journal is
+// committed once per 1024 commands. Returns the number of failed commands.
+long long runBatch(istream& in, ostream& out, PasswordManager& pm)
+{
+    string line;
+    string buffer;
+    string account;
+    string password;
+    buffer.reserve(BATCH_OUTPUT_FLUSH + 4096);
+    long long failed = 0;
+    int sinceSync = 0;
+
+    auto result = [&](bool ok, string_view command, string_view detail, const char* reason)
+    {
+        buffer += ok ? "OK\t" : "ERR\t";
+        buffer += command;
+        if (!detail.empty())
+        {
+            buffer += '\t';
+            buffer += detail;
+        }
+        if (!ok && reason)
+        {
+            buffer += '\t';
+            buffer += reason;
+        }
+        buffer += '\n';
+        if (!ok) failed++;
+    };
+    auto entry = [&](string_view name, string_view encrypted, bool remember)
+    {
+        buffer += "=\t";
+        buffer += name;
+        buffer += '\t';
+        pm.revealPassword(encrypted, password, remember);
+        buffer += password;
+        wipeString(password);
+        buffer += '\n';
+    };
+
+    while (getline(in, line))
+    {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+
+        string_view fields[3];
+        int n = splitFields(line, fields, 3);
+        string_view command = fields[0];
+        bool hasAccount = n >= 2 && !fields[1].empty();
+
+        if ((command == "add" || command == "edit") && (!hasAccount || n < 3))
+        {
+            result(false, command, hasAccount ? fields[1] : string_view(), "expected account and password");
+        }
+        else if ((command == "delete" || command == "search" || command == "login") && !hasAccount)
+        {
+            result(false, command, string_view(), "expected an argument");
+        }
+        else if ((command == "add" || command == "edit") && !entryFits(fields[1], fields[2]))
+        {
+            result(false, command, fields[1].size() <= MAX_ENTRY_BYTES ? fields[1] : string_view(), "too long");
+        }
+        else if (command == "add")
+        {
+            account.assign(fields[1]);
+            password.assign(fields[2]);
+            result(pm.addPasswordEntry(account, password, nullOut), command, fields[1], "already exists");
+        }
+        else if (command == "edit")
+        {
+            account.assign(fields[1]);
+            password.assign(fields[2]);
+            result(pm.editPasswordEntry(account, password, nullOut), command, fields[1], "not found");
+        }
+        else if (command == "delete")
+        {
+            account.assign(fields[1]);
+            result(pm.deletePasswordEntry(account, nullOut), command, fields[1], "not found");
+        }
+        else if (command == "undo" || command == "redo")
+        {
+            bool undo = command == "undo";
+            bool pending = undo ? pm.history.canUndo() : pm.history.canRedo();
+            bool ok = pending && (undo ? pm.undo(nullOut) : pm.redo(nullOut));
+            result(ok, command, string_view(), pending ? "vault changed since" : "nothing to do");
+        }
+        else if (command == "search")
+        {
+            PasswordNode* node = pm.vault.find(fields[1]);
+            if (node) entry(node->accountName, node->password, true);
+            result(node != nullptr, command, fields[1], "not found");
+        }
+        else if (command == "prefix")
+        {
+            const int maxMatches = 1000;
+            int k = n >= 3 ? atoi(string(fields[2]).c_str()) : 10;
+            k = max(0, min(k, maxMatches));
+            string_view matches[maxMatches];
+            string_view start = n >= 2 ? fields[1] : string_view();
+            int found = pm.vault.withPrefix(start, matches, k);
+            for (int i = 0; i < found; i++)
+            {
+                buffer += "=\t";
+                buffer += matches[i];
+                buffer += '\n';
+            }
+            result(true, command, to_string(found), nullptr);
+        }
+        else if (command == "fuzzy")
+        {
+            FuzzyMatch matches[10];
+            string_view typed = n >= 2 ? fields[1] : string_view();
+            int edits = n >= 3 ? atoi(string(fields[2]).c_str()) : typoBudget(typed.size());
+            int found = pm.vault.closestNames(typed, edits, matches, 10);
+            for (int i = 0; i < found; i++)
+            {
+                buffer += "=\t";
+                buffer += matches[i].name;
+                buffer += '\t';
+                buffer += to_string(matches[i].distance);
+                buffer += '\n';
+            }
+            result(true, command, to_string(found), nullptr);
+        }
+        else if (command == "audit")
+        {
+            AuditReport report = auditVault(pm.vault);
+            if (breachList().isOpen()) auditBreaches(pm.vault, breachList(), report);
+            uint64_t flagged = 0;
+            forEachAudited(pm.vault, report, [&](PasswordNode* node, uint8_t verdict)
+            {
+                if (!auditFlagged(verdict)) return true;
+                buffer += "=\t";
+                buffer += node->accountName;
+                buffer += '\t';
+                buffer += auditFindings(verdict);
+                buffer += '\n';
+                flagged++;
+                if (buffer.size() >= BATCH_OUTPUT_FLUSH)
+                {
+                    out.write(buffer.data(), buffer.size());
+                    buffer.clear();
+                }
+                return true;
+            });
+            result(true, command, to_string(flagged), nullptr);
+        }
+        else if (command == "view")
+        {
+            uint32_t shown = 0;
+            for (VaultIterator it = pm.vault.begin(); it.hasNext(); )
+            {
+                PasswordNode* node = it.next();
+                entry(node->accountName, node->password, false);
+                shown++;
+                if (buffer.size() >= BATCH_OUTPUT_FLUSH)
+                {
+                    out.write(buffer.data(), buffer.size());
+                    buffer.clear();
+                }
+            }
+            result(true, command, to_string(shown), nullptr);
+        }
+        else if (command == "login")
+        {
+            account.assign(fields[1]);
+            if (!isValidEmail(account))
+            {
+                result(false, command, fields[1], "invalid email");
+            }
+            else
+            {
+                pm.history.clear();
+                password.assign(n >= 3 ? fields[2] : string_view());
+                string path = vaultPathFor(account);
+                if (!pm.clearAllPasswords()) result(false, "sync", string_view(), "could not write the vault journal");
+                readVaultSalt(path, pm.vault.key.salt);
+                deriveVaultKey(password, pm.vault.key);
+                wipeString(password);
+                int opened = pm.openVault(path);
+                result(opened >= 0, command, opened >= 0 ? to_string(pm.vault.size()) : account,
+                    opened == VAULT_WRONG_KEY ? "wrong password for this vault" : "could not open the saved vault");
+            }
+        }
+        else if (command == "logout")
+        {
+            bool saved = pm.clearAllPasswords();
+            pm.history.clear();
+            pm.vault.key = VaultKey();
+            result(saved, command, string_view(), "could not write the vault journal");
+        }
+        else
+        {
+            result(false, command, string_view(), "unknown command");
+        }
+
+        if (++sinceSync == BATCH_SYNC_EVERY)
+        {
+            if (!pm.syncJournal()) result(false, "sync", string_view(), "could not write the vault journal");
+            if (!pm.maybeCheckpoint()) result(false, "checkpoint", string_view(), "could not write the vault snapshot");
+            sinceSync = 0;
+        }
+        if (buffer.size() >= BATCH_OUTPUT_FLUSH)
+        {
+            out.write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    }
+
+    if (!pm.syncJournal()) result(false, "sync", string_view(), "could not write the vault journal");
+    out.write(buffer.data(), buffer.size());
+    out.flush();
+    return failed;
+}
+
+// ==================== DAEMON ====================
+//
+// "main --serve <socket>" answers vault requests from other local tools over a
+// Unix domain socket (frames and operations: vault_protocol.h). One thread runs a
+// level-triggered epoll loop over non-blocking sockets. Each wakeup handles every
+// complete frame that arrived, commits the journal of each vault it changed once
+// (group commit), and only then sends the responses, so an Ok for a change means
+// it is on disk: if a commit fails, the Ok of every change to that vault in the
+// wakeup becomes Failed. Every Open derives a key (slow on purpose), and one of
+// a saved vault loads its files too, on a pool of worker threads, so it never
+// stalls the loop; that connection's later requests wait for it, the others do not.
+// Saved vaults stay loaded until the daemon stops on SIGINT or SIGTERM. A
+// memory-only vault is dropped once no connection has been signed in to it for
+// DAEMON_MEMORY_IDLE_SECONDS, so clients that come and go cannot pile them up.
+
+const size_t DAEMON_READ_CHUNK = 64 * 1024;    // Bytes per recv
+const size_t DAEMON_OUTPUT_LIMIT = 4 << 20;    // Unsent bytes at which a client is not read
+const int DAEMON_MAX_EVENTS = 64;              // Events per epoll_wait
+const unsigned DAEMON_OPEN_THREADS = 4;        // Workers deriving keys and loading vaults for Open
+const int DAEMON_MEMORY_IDLE_SECONDS = 300;    // Unused time after which a memory-only vault is dropped
+const int DAEMON_SWEEP_MS = 1000;              // How often idle memory-only vaults are looked for
+
+#ifdef __linux__
+
+volatile sig_atomic_t daemonStopping = 0;
+
+void stopDaemon(int)
+{
+    daemonStopping = 1;
+}
+
+// One client connection and its buffers
+struct DaemonClient
+{
+    int fd;
+    uint64_t id = 0;         // Tells a reused fd's new client from the old one
+    string in;               // Received bytes; frames from inStart on are unhandled
+    size_t inStart = 0;
+    string out;              // Responses; bytes from outStart on are unsent
+    size_t outStart = 0;
+    Session* session = nullptr;
+    bool memoryOnly = false; // session is a memory-only vault
+    uint32_t events = 0;     // Currently registered epoll events
+    bool peerClosed = false; // Nothing more will arrive
+    bool opening = false;    // An Open is on a worker; later frames wait for it
+    bool queued = false;     // In VaultDaemon::pending
+    bool dead = false;       // Closed; freed at the end of the wakeup
+};
+
+struct VaultDaemon
+{
+    SessionTable sessions;        // Vaults loaded from and saved to disk
+    SessionTable memorySessions;  // Memory-only vaults: a separate key space, so an
+                                  // Open of either kind never finds or locks the other
+    string socketPath;
+    int listenFd = -1;
+    int epollFd = -1;
+    unordered_map<int, unique_ptr<DaemonClient>> clients;
+    // The Ok response of one change, turned into Failed if its vault's commit fails
+    struct ChangeResponse
+    {
+        DaemonClient* client;
+        size_t statusAt;   // Offset of the status byte in client->out
+        Session* session;
+    };
 
-        // Get all PasswordNode pointers from BST in sorted order
-        const int MAX_ACCOUNTS = 1000;
-        PasswordNode* sortedNodes[MAX_ACCOUNTS];
-        int nodeCount = bst.getAllNodes(sortedNodes, MAX_ACCOUNTS);
+    vector<Session*> changed;                // Vaults to commit before the next send
+    vector<ChangeResponse> changeResponses;  // Oks waiting on those commits
+    Session* lastChanged = nullptr;          // Vault changed by the request being answered
+    vector<DaemonClient*> pending;           // Clients with responses to send
+    uint64_t nextClientId = 0;
 
-        cout << "\n========== Your Stored Passwords (Sorted by Account Name) ==========\n";
-        for (int i = 0; i < nodeCount; i++)
-        {
-            PasswordNode* node = sortedNodes[i];
-            cout << (i + 1) << ". Account: " << node->accountName << endl;
-            cout << "   Password: " << decryptPassword(node->password) << endl;
-            cout << "   ------------------------------------------\n";
-        }
-    }
+    // Use of a memory-only vault: connections signed in to it, Opens of it on a
+    // worker, and since when both have been zero
+    struct MemoryUse
+    {
+        int clients = 0;
+        int opening = 0;
+        chrono::steady_clock::time_point idleSince;
+    };
 
-    // Edit existing password (uses BST for fast searching)
-    void editPassword()
+    unordered_map<string, MemoryUse> memoryUse;  // By email
+    chrono::steady_clock::time_point lastSweep;
+
+    // An Open, run by a worker and answered by the loop
+    struct OpenJob
     {
-        if (!head || bst.isEmpty())
-        {
-            cout << "\nNo passwords to edit.\n";
-            return;
-        }
+        int fd;
+        uint64_t clientId;
+        uint32_t tag;
+        string email;
+        string password;
+        bool memoryOnly = false;
+        Session* session = nullptr;
+        int opened = 0;
+    };
 
-        cin.ignore();
-        string account;
-        cout << "\nEnter Account Name to edit: ";
-        getline(cin, account);
+    mutex openLock;
+    condition_variable openReady;
+    deque<OpenJob> openQueue;      // Waiting for a worker
+    vector<OpenJob> openDone;      // Finished, to answer
+    vector<thread> openWorkers;
+    bool openStopping = false;
+    int wakeFd = -1;               // eventfd a worker signals when a job is done
 
-        // Use BST to quickly find the PasswordNode
-        PasswordNode* node = bst.search(account);
-        if (!node)
+    ~VaultDaemon()
+    {
+        stopOpenWorkers();
+        if (wakeFd >= 0) close(wakeFd);
+        for (auto& entry : clients) close(entry.first);
+        if (listenFd >= 0)
         {
-            cout << "❌ Account not found.\n";
-            return;
+            close(listenFd);
+            unlink(socketPath.c_str());
         }
+        if (epollFd >= 0) close(epollFd);
+    }
 
-        cout << "Current Password: " << decryptPassword(node->password) << endl;
-        string newPass;
-        cout << "Enter New Password: ";
-        getline(cin, newPass);
-
-        checkAndSuggestStrength(newPass);
-
-        string encryptedNewPass = encryptPassword(newPass);
-        
-        // Check if this password is already used by another account
-        string existingAccount = findAccountWithPassword(encryptedNewPass, account);
-        if (!existingAccount.empty())
+    // Let the running Opens finish and drop the queued ones
+    void stopOpenWorkers()
+    {
         {
-            cout << "⚠️ Warning: This password is already used for account \"" << existingAccount << "\". Try a new password for better security.\n";
+            lock_guard<mutex> guard(openLock);
+            openStopping = true;
         }
-
-        // Record action for undo
-        Action action;
-        action.actionType = "EDIT";
-        action.accountName = account;
-        action.oldPassword = node->password; // Store encrypted old password
-        action.newPassword = encryptedNewPass;
-        undoStack.push(action);
-        redoStack.clear(); // Clear redo stack after new action
-
-        node->password = action.newPassword;
-
-        cout << "✅ Password updated for " << account << "!\n";
+        openReady.notify_all();
+        for (thread& worker : openWorkers) worker.join();
+        openWorkers.clear();
+        for (OpenJob& job : openQueue) wipeString(job.password);
+        openQueue.clear();
     }
 
-    // Delete a password (removes from both BST and linked list)
-    void deletePassword()
+    // Listen on path; false (with a message) if that fails or a daemon already
+    // answers there. A leftover socket file from a stopped daemon is replaced.
+    bool start(const string& path)
     {
-        if (!head || bst.isEmpty())
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(address.sun_path))
         {
-            cout << "\nNo passwords to delete.\n";
-            return;
+            cerr << "❌ Socket path must be 1 to " << sizeof(address.sun_path) - 1 << " bytes.\n";
+            return false;
         }
+        memcpy(address.sun_path, path.c_str(), path.size() + 1);
 
-        cin.ignore();
-        string account;
-        cout << "\nEnter Account Name to delete: ";
-        getline(cin, account);
-
-        // Use BST to quickly find the PasswordNode pointer
-        PasswordNode* nodeToDelete = bst.search(account);
-        
-        if (!nodeToDelete)
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        bool running = probe >= 0 && connect(probe, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+        if (probe >= 0) close(probe);
+        if (running)
         {
-            cout << "❌ Account not found.\n";
-            return;
+            cerr << "❌ A vault daemon is already serving " << path << ".\n";
+            return false;
         }
+        unlink(path.c_str());
 
-        // Record action for undo
-        Action action;
-        action.actionType = "DELETE";
-        action.accountName = account;
-        action.oldPassword = nodeToDelete->password; // Store encrypted password
-        undoStack.push(action);
-        redoStack.clear(); // Clear redo stack after new action
-
-        // Remove from BST first (just removes the BST node, not the PasswordNode)
-        bst.remove(nodeToDelete);
-
-        // Now remove from linked list (this deletes the actual PasswordNode)
-        PasswordNode* temp = head;
-        PasswordNode* prev = nullptr;
-
-        while (temp && temp != nodeToDelete)
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd < 0 || ::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+        {
+            cerr << "❌ Could not bind " << path << ": " << strerror(errno) << "\n";
+            return false;
+        }
+        socketPath = path;
+        chmod(path.c_str(), 0600);  // Vault contents: owner only
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (listen(listenFd, SOMAXCONN) != 0 || epollFd < 0)
+        {
+            cerr << "❌ Could not listen on " << path << ": " << strerror(errno) << "\n";
+            return false;
+        }
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.fd = listenFd;
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoll_event wake = {};
+        wake.events = EPOLLIN;
+        wake.data.fd = wakeFd;
+        if (wakeFd < 0 || epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event) != 0
+            || epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &wake) != 0)
         {
-            prev = temp;
-            temp = temp->next;
+            return false;
         }
+        for (unsigned t = 0; t < DAEMON_OPEN_THREADS; t++) openWorkers.emplace_back([this]() { runOpenWorker(); });
+        return true;
+    }
 
-        if (temp == nodeToDelete)
+    void runOpenWorker()
+    {
+        while (true)
         {
-            if (prev == nullptr) 
+            OpenJob job;
             {
-                head = temp->next;
-            } 
-            else 
+                unique_lock<mutex> guard(openLock);
+                openReady.wait(guard, [this]() { return openStopping || !openQueue.empty(); });
+                if (openStopping) return;
+                job = move(openQueue.front());
+                openQueue.pop_front();
+            }
+            SessionTable& table = job.memoryOnly ? memorySessions : sessions;
+            job.session = table.open(job.email, job.password, !job.memoryOnly, job.opened);
+            wipeString(job.password);
             {
-                prev->next = temp->next;
+                lock_guard<mutex> guard(openLock);
+                openDone.push_back(move(job));
             }
-
-            delete temp;  // Delete the actual PasswordNode (account name and password)
+            uint64_t one = 1;
+            ssize_t written = write(wakeFd, &one, sizeof(one));
+            (void)written;  // Only fails if the counter is saturated, when the loop wakes anyway
         }
-
-        cout << "✅ Password for " << account << " deleted successfully!\n";
     }
 
-    // Undo last action
-    void undo()
+    // Answer the Opens the workers finished, then go on with frames that waited
+    void finishOpens()
     {
-        if (undoStack.isEmpty())
+        uint64_t count;
+        ssize_t got = read(wakeFd, &count, sizeof(count));
+        (void)got;
+        vector<OpenJob> done;
         {
-            cout << "\n❌ Nothing to undo!\n";
-            return;
+            lock_guard<mutex> guard(openLock);
+            done.swap(openDone);
         }
-
-        Action action = undoStack.pop();
-        redoStack.push(action); // Move to redo stack
-
-        if (action.actionType == "ADD")
+        for (OpenJob& job : done)
         {
-            // Find the node with matching account name AND password
-            PasswordNode* temp = head;
-            PasswordNode* prev = nullptr;
-
-            while (temp && (temp->accountName != action.accountName || temp->password != action.newPassword))
+            if (job.memoryOnly)
             {
-                prev = temp;
-                temp = temp->next;
+                MemoryUse& use = memoryUse[job.email];
+                if (--use.opening == 0 && use.clients == 0) use.idleSince = chrono::steady_clock::now();
             }
+            auto it = clients.find(job.fd);
+            if (it == clients.end() || it->second->id != job.clientId || it->second->dead) continue;
+            DaemonClient& client = *it->second;
+            ProtoStatus status = ProtoStatus::Ok;
+            if (job.opened == VAULT_LOCKED_OUT) status = ProtoStatus::Locked;
+            else if (!job.session) status = job.opened == -1 ? ProtoStatus::Failed : ProtoStatus::Denied;
+            else attach(client, job.session, job.memoryOnly);
+            size_t start = protoBegin(client.out, static_cast<uint8_t>(status), job.tag);
+            protoEnd(client.out, start);
+            client.opening = false;
+            queueSend(client);
+            handleFrames(client);
+        }
+    }
+
+    // Sign client in to session (nullptr: sign it out), counting the
+    // connections of each memory-only vault
+    void attach(DaemonClient& client, Session* session, bool memoryOnly)
+    {
+        if (client.session && client.memoryOnly)
+        {
+            MemoryUse& use = memoryUse[client.session->user.email];
+            if (--use.clients == 0 && use.opening == 0) use.idleSince = chrono::steady_clock::now();
+        }
+        client.session = session;
+        client.memoryOnly = session && memoryOnly;
+        if (client.memoryOnly) memoryUse[session->user.email].clients++;
+    }
 
-            if (temp)
+    // Drop the memory-only vaults unused for DAEMON_MEMORY_IDLE_SECONDS. Nothing
+    // refers to them then: no connection is signed in and no Open is running.
+    void evictIdleMemoryVaults()
+    {
+        auto now = chrono::steady_clock::now();
+        lastSweep = now;
+        for (auto it = memoryUse.begin(); it != memoryUse.end(); )
+        {
+            const MemoryUse& use = it->second;
+            if (use.clients || use.opening || now - use.idleSince < chrono::seconds(DAEMON_MEMORY_IDLE_SECONDS))
             {
-                // Remove from BST first
-                bst.remove(temp);
+                ++it;
+                continue;
+            }
+            memorySessions.close(it->first);
+            it = memoryUse.erase(it);
+        }
+    }
 
-                // Then remove from linked list
-                if (prev == nullptr)
-                    head = temp->next;
-                else
-                    prev->next = temp->next;
+    void queueSend(DaemonClient& client)
+    {
+        if (client.queued) return;
+        client.queued = true;
+        pending.push_back(&client);
+    }
 
-                delete temp;  // Delete the actual PasswordNode
-                cout << "✅ Undo: Removed password for " << action.accountName << "\n";
+    void run()
+    {
+        epoll_event events[DAEMON_MAX_EVENTS];
+        while (!daemonStopping)
+        {
+            int n = epoll_wait(epollFd, events, DAEMON_MAX_EVENTS, memoryUse.empty() ? -1 : DAEMON_SWEEP_MS);
+            if (n < 0)
+            {
+                if (errno == EINTR) continue;
+                cerr << "❌ epoll_wait: " << strerror(errno) << "\n";
+                break;
             }
-            else
+
+            for (int i = 0; i < n; i++)
             {
-                cout << "⚠️ Undo: Could not find password for " << action.accountName << " to remove.\n";
+                if (events[i].data.fd == listenFd)
+                {
+                    acceptClients();
+                    continue;
+                }
+                if (events[i].data.fd == wakeFd)
+                {
+                    finishOpens();
+                    continue;
+                }
+                auto it = clients.find(events[i].data.fd);
+                if (it == clients.end() || it->second->dead) continue;
+                DaemonClient& client = *it->second;
+                if (events[i].events & (EPOLLERR | EPOLLHUP) && !(events[i].events & EPOLLIN))
+                {
+                    drop(client);
+                    continue;
+                }
+                if (events[i].events & EPOLLOUT) send(client);
+                if (events[i].events & EPOLLIN) receive(client);
+                handleFrames(client);
             }
-        }
-        else if (action.actionType == "EDIT")
-        {
-            // Restore old password (use BST for fast search)
-            PasswordNode* node = bst.search(action.accountName);
-            if (node)
+
+            // Group commit, then answer
+            vector<Session*> failed;
+            for (Session* session : changed)
             {
-                // Verify the current password matches what we expect (the newPassword from the action)
-                if (node->password == action.newPassword)
+                lock_guard<shared_mutex> guard(session->lock);
+                if (!session->pm.syncJournal())
                 {
-                    node->password = action.oldPassword;
-                    cout << "✅ Undo: Restored old password for " << action.accountName << "\n";
+                    cerr << "⚠️ Could not write the journal of " << session->user.email << ".\n";
+                    failed.push_back(session);
                 }
-                else
+                if (!session->pm.maybeCheckpoint())
                 {
-                    cout << "⚠️ Undo: Password for " << action.accountName << " has been modified. Cannot undo.\n";
+                    cerr << "⚠️ Could not write the checkpoint of " << session->user.email << "; its journal keeps the changes.\n";
                 }
             }
-            else
+            for (const ChangeResponse& response : changeResponses)
             {
-                cout << "⚠️ Undo: Account " << action.accountName << " not found. Cannot undo edit.\n";
+                if (find(failed.begin(), failed.end(), response.session) != failed.end())
+                {
+                    response.client->out[response.statusAt] = static_cast<char>(ProtoStatus::Failed);
+                }
             }
-        }
-        else if (action.actionType == "DELETE")
-        {
-            // Re-add the deleted password
-            PasswordNode* newNode = new PasswordNode(action.accountName, action.oldPassword);
+            changed.clear();
+            changeResponses.clear();
+            for (DaemonClient* client : pending)
+            {
+                client->queued = false;
+                if (!client->dead) send(*client);
+            }
+            pending.clear();
 
-            if (!head)
+            for (auto it = clients.begin(); it != clients.end(); )
             {
-                head = newNode;
-            } else 
+                if (it->second->dead) it = clients.erase(it);
+                else ++it;
+            }
+            if (!memoryUse.empty() && chrono::steady_clock::now() - lastSweep >= chrono::milliseconds(DAEMON_SWEEP_MS))
             {
-                PasswordNode* temp = head;
-                while (temp->next) temp = temp->next;
-                temp->next = newNode;
+                evictIdleMemoryVaults();
             }
+        }
+    }
 
-            // Re-insert into BST
-            bst.insert(newNode);
-
-            cout << "✅ Undo: Restored password for " << action.accountName << "\n";
+    void acceptClients()
+    {
+        while (true)
+        {
+            int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) return;  // EAGAIN: no more waiting (errors drop just that client)
+            unique_ptr<DaemonClient> client(new DaemonClient());
+            client->fd = fd;
+            client->id = ++nextClientId;
+            client->events = EPOLLIN;
+            epoll_event event = {};
+            event.events = EPOLLIN;
+            event.data.fd = fd;
+            if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0)
+            {
+                close(fd);
+                continue;
+            }
+            clients[fd] = move(client);
         }
     }
 
-    // Redo last undone action
-    void redo()
+    // Register for input while the client is not too far behind on output, and
+    // for output while responses are waiting
+    void watch(DaemonClient& client)
+    {
+        size_t unsent = client.out.size() - client.outStart;
+        bool reading = !client.peerClosed && !client.opening && unsent < DAEMON_OUTPUT_LIMIT;
+        uint32_t wanted = (reading ? static_cast<uint32_t>(EPOLLIN) : 0) | (unsent ? static_cast<uint32_t>(EPOLLOUT) : 0);
+        if (wanted == client.events) return;
+        epoll_event event = {};
+        event.events = wanted;
+        event.data.fd = client.fd;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, client.fd, &event);
+        client.events = wanted;
+    }
+
+    void drop(DaemonClient& client)
     {
-        if (redoStack.isEmpty())
+        if (client.dead) return;
+        attach(client, nullptr, false);
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, client.fd, nullptr);
+        close(client.fd);
+        client.dead = true;
+    }
+
+    void receive(DaemonClient& client)
+    {
+        while (true)
         {
-            cout << "\n❌ Nothing to redo!\n";
+            size_t used = client.in.size();
+            client.in.resize(used + DAEMON_READ_CHUNK);
+            ssize_t got = recv(client.fd, &client.in[used], DAEMON_READ_CHUNK, 0);
+            client.in.resize(used + (got > 0 ? got : 0));
+            if (got > 0) continue;
+            if (got == 0) client.peerClosed = true;
+            else if (errno != EAGAIN && errno != EWOULDBLOCK) drop(client);
             return;
         }
+    }
 
-        Action action = redoStack.pop();
-        bool success = false;
-
-        if (action.actionType == "ADD")
+    void send(DaemonClient& client)
+    {
+        while (client.outStart < client.out.size())
         {
-            // Check if account already exists (use BST for fast search)
-            PasswordNode* existing = bst.search(action.accountName);
-            if (existing)
+            ssize_t sent = ::send(client.fd, client.out.data() + client.outStart, client.out.size() - client.outStart, MSG_NOSIGNAL);
+            if (sent < 0)
             {
-                // Check if it's the same password (from a previous redo)
-                if (existing->password == action.newPassword)
-                {
-                    cout << "⚠️ Redo: Password for " << action.accountName << " already exists.\n";
-                    redoStack.push(action); // Put it back
-                    return;
-                }
-                else
-                {
-                    cout << "⚠️ Redo: Account " << action.accountName << " already exists with different password. Cannot redo.\n";
-                    redoStack.push(action); // Put it back
-                    return;
-                }
+                if (errno != EAGAIN && errno != EWOULDBLOCK) drop(client);
+                break;
             }
+            client.outStart += sent;
+        }
+        if (client.outStart == client.out.size())
+        {
+            client.out.clear();
+            client.outStart = 0;
+        }
+        if (client.dead) return;
+        if (client.peerClosed && !client.opening && client.out.empty() && client.inStart == client.in.size())
+        {
+            drop(client);
+            return;
+        }
+        watch(client);
+    }
 
-            // Re-add the password
-            PasswordNode* newNode = new PasswordNode(action.accountName, action.newPassword);
-
-            if (!head)
-            {
-                head = newNode;
-            } else 
+    // Answer every complete frame received, until the client falls too far behind
+    // or waits on an Open
+    void handleFrames(DaemonClient& client)
+    {
+        if (client.dead) return;
+        size_t before = client.out.size();
+        while (!client.opening && client.out.size() - client.outStart < DAEMON_OUTPUT_LIMIT)
+        {
+            size_t size = protoFrameSize(client.in.data() + client.inStart, client.in.size() - client.inStart);
+            if (size == SIZE_MAX)
             {
-                PasswordNode* temp = head;
-                while (temp->next) temp = temp->next;
-                temp->next = newNode;
+                drop(client);
+                return;
             }
+            if (size == 0) break;
+            ProtoFrame frame(client.in.data() + client.inStart, size);
+            handle(client, frame);
+            client.inStart += size;
+        }
+        if (client.inStart == client.in.size())
+        {
+            client.in.clear();
+            client.inStart = 0;
+        }
+        else if (client.inStart > client.in.size() / 2)
+        {
+            client.in.erase(0, client.inStart);
+            client.inStart = 0;
+        }
 
-            // Re-insert into BST
-            bst.insert(newNode);
+        if (client.out.size() != before) queueSend(client);
+        else if (client.peerClosed && !client.opening && client.out.empty() && client.inStart == client.in.size()) drop(client);
+        else watch(client);
+    }
 
-            cout << "✅ Redo: Re-added password for " << action.accountName << "\n";
-            success = true;
+    void markChanged(Session* session)
+    {
+        lastChanged = session;
+        if (find(changed.begin(), changed.end(), session) == changed.end()) changed.push_back(session);
+    }
+
+    // Append the response to one request
+    void handle(DaemonClient& client, ProtoFrame& frame)
+    {
+        string& out = client.out;
+        size_t start = protoBegin(out, static_cast<uint8_t>(ProtoStatus::Ok), frame.tag);
+        lastChanged = nullptr;
+        ProtoStatus status = respond(client, frame, out);
+        if (client.opening)
+        {
+            out.resize(start);  // finishOpens() answers it
+            return;
         }
-        else if (action.actionType == "EDIT")
+        if (status != ProtoStatus::Ok)
         {
-            // Reapply new password (use BST for fast search)
-            PasswordNode* node = bst.search(action.accountName);
-            if (node)
-            {
-                // Verify the current password matches the oldPassword (what we expect after undo)
-                if (node->password == action.oldPassword)
-                {
-                    node->password = action.newPassword;
-                    cout << "✅ Redo: Reapplied new password for " << action.accountName << "\n";
-                    success = true;
-                }
-                else
-                {
-                    cout << "⚠️ Redo: Password for " << action.accountName << " has been modified. Cannot redo.\n";
-                    redoStack.push(action); // Put it back
-                    return;
-                }
-            }
-            else
-            {
-                cout << "⚠️ Redo: Account " << action.accountName << " not found. Cannot redo edit.\n";
-                redoStack.push(action); // Put it back
-                return;
-            }
+            out.resize(start + PROTO_HEADER_BYTES);
+            out[start + 4] = static_cast<char>(status);
         }
-        else if (action.actionType == "DELETE")
+        else if (lastChanged)
         {
-            // Use BST to find the node quickly
-            PasswordNode* nodeToDelete = bst.search(action.accountName);
-            
-            if (!nodeToDelete || nodeToDelete->password != action.oldPassword)
+            changeResponses.push_back({ &client, start + 4, lastChanged });
+        }
+        protoEnd(out, start);
+    }
+
+    ProtoStatus respond(DaemonClient& client, ProtoFrame& frame, string& out)
+    {
+        ProtoOp op = static_cast<ProtoOp>(frame.code);
+        string_view a, b;
+        if (op == ProtoOp::Open)
+        {
+            string_view flags;
+            if (!frame.field(a) || !frame.field(b)) return ProtoStatus::BadRequest;
+            bool memoryOnly = frame.field(flags) && flags.size() == 1 && (flags[0] & PROTO_OPEN_MEMORY_ONLY);
+            string email(a);
+            if (!frame.atEnd() || !isValidEmail(email) || b.empty()) return ProtoStatus::BadRequest;
             {
-                cout << "⚠️ Redo: Could not find password for " << action.accountName << " to delete.\n";
-                redoStack.push(action); // Put it back
-                return;
+                lock_guard<mutex> guard(openLock);
+                openQueue.push_back({ client.fd, client.id, frame.tag, email, string(b), memoryOnly });
             }
+            if (memoryOnly) memoryUse[email].opening++;
+            wipeBytes(const_cast<char*>(b.data()), b.size());  // The worker's copy is the only one left
+            openReady.notify_one();
+            client.opening = true;
+            return ProtoStatus::Ok;
+        }
 
-            // Remove from BST first
-            bst.remove(nodeToDelete);
-
-            // Then remove from linked list
-            PasswordNode* temp = head;
-            PasswordNode* prev = nullptr;
+        Session* session = client.session;
+        if (op == ProtoOp::Close)
+        {
+            attach(client, nullptr, false);
+            return frame.atEnd() ? ProtoStatus::Ok : ProtoStatus::BadRequest;
+        }
+        if (!session) return ProtoStatus::NotOpen;
+        PasswordManager& pm = session->pm;
 
-            while (temp && temp != nodeToDelete)
+        switch (op)
+        {
+            case ProtoOp::Search:
             {
-                prev = temp;
-                temp = temp->next;
+                if (!frame.field(a) || !frame.atEnd()) return ProtoStatus::BadRequest;
+                shared_lock<shared_mutex> guard(session->lock);
+                string_view encrypted;
+                if (!pm.vault.lookup(a, encrypted)) return ProtoStatus::NotFound;
+                string password;
+                pm.revealPassword(encrypted, password);
+                bool fits = password.size() <= PROTO_MAX_FIELD;  // Stored before entries were limited
+                if (fits) protoField(out, password);
+                wipeString(password);
+                return fits ? ProtoStatus::Ok : ProtoStatus::Failed;
             }
-
-            if (temp == nodeToDelete)
+            case ProtoOp::Add:
+            case ProtoOp::Edit:
             {
-                if (prev == nullptr)
-                    head = temp->next;
-                else
-                    prev->next = temp->next;
-
-                delete temp;  // Delete the actual PasswordNode
-                cout << "✅ Redo: Deleted password for " << action.accountName << "\n";
-                success = true;
+                if (!frame.field(a) || !frame.field(b) || !frame.atEnd() || a.empty()) return ProtoStatus::BadRequest;
+                lock_guard<shared_mutex> guard(session->lock);
+                bool ok = op == ProtoOp::Add
+                    ? pm.addPasswordEntry(string(a), string(b), nullOut)
+                    : pm.editPasswordEntry(string(a), string(b), nullOut);
+                if (!ok) return op == ProtoOp::Add ? ProtoStatus::Exists : ProtoStatus::NotFound;
+                markChanged(session);
+                return ProtoStatus::Ok;
             }
-            else
+            case ProtoOp::Delete:
             {
-                cout << "⚠️ Redo: Could not find password for " << action.accountName << " to delete.\n";
-                redoStack.push(action); // Put it back
-                return;
+                if (!frame.field(a) || !frame.atEnd()) return ProtoStatus::BadRequest;
+                lock_guard<shared_mutex> guard(session->lock);
+                if (!pm.deletePasswordEntry(string(a), nullOut)) return ProtoStatus::NotFound;
+                markChanged(session);
+                return ProtoStatus::Ok;
+            }
+            case ProtoOp::Range:
+            {
+                uint32_t limit = 0;
+                if (!frame.field(a) || !frame.field(b) || !frame.fieldU32(limit) || !frame.atEnd()) return ProtoStatus::BadRequest;
+                limit = min(limit, PROTO_MAX_RANGE);
+                size_t frameStart = out.size() - PROTO_HEADER_BYTES;
+                string password;
+                VaultReadView view = session->readView();
+                VersionIterator it = view.lowerBound(a);
+                for (uint32_t n = 0; n < limit && it.hasNext(); n++)
+                {
+                    const VersionNode* node = it.next();
+                    if (!b.empty() && node->name() >= b) break;
+                    pm.revealPassword(node->password(), password, false);
+                    if (!entryFits(node->name(), password))
+                    {
+                        wipeString(password);
+                        return ProtoStatus::Failed;
+                    }
+                    if (out.size() - frameStart + 4 + node->nameSize + password.size() > PROTO_MAX_FRAME) break;
+                    protoField(out, node->name());
+                    protoField(out, password);
+                }
+                wipeString(password);
+                return ProtoStatus::Ok;
             }
+            default:
+                return ProtoStatus::BadRequest;
         }
+    }
+};
 
-        // Only move to undo stack if redo was successful
-        if (success)
+int runDaemon(const string& path)
+{
+    struct sigaction action = {};
+    action.sa_handler = stopDaemon;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    VaultDaemon daemon;
+    if (!daemon.start(path)) return 1;
+    cout << "🔌 Serving vaults on " << path << " (Ctrl+C to stop)" << endl;
+    daemon.run();
+    daemon.stopOpenWorkers();  // No Open may be loading a vault while they close
+    size_t vaults = daemon.sessions.size();
+    size_t unsaved = daemon.sessions.closeAll();
+    daemon.memorySessions.closeAll();
+    if (unsaved)
+    {
+        cerr << "❌ " << unsaved << " vault(s) could not be saved on shutdown; their latest changes are lost.\n";
+    }
+    cout << "👋 Daemon stopped; " << vaults - unsaved << " vault(s) saved and closed." << endl;
+    return unsaved ? 1 : 0;
+}
+
+#else
+
+int runDaemon(const string&)
+{
+    cerr << "❌ Daemon mode needs Linux (epoll and Unix domain sockets).\n";
+    return 1;
+}
+
+#endif
+
+#ifndef PM_BENCH
+
+// ==================== MAIN FUNCTION ====================
+
+int main(int argc, char* argv[]) 
+{
+    // "main --breach-index [list]" builds the filter for a breach list (<list>.bloom)
+    if (argc > 1 && strcmp(argv[1], "--breach-index") == 0)
+    {
+        string path = argc > 2 ? argv[2] : breachListPath();
+        string error;
+        auto start = chrono::steady_clock::now();
+        long long keys = BreachList::buildFilter(path, error);
+        if (keys < 0)
         {
-            undoStack.push(action);
+            cerr << "❌ " << error << "\n";
+            return 1;
         }
+        cout << "✅ Indexed " << keys << " breached password hash(es) from " << path << " in " << secondsSince(start) << " s.\n";
+        return 0;
     }
 
-    // Clear all passwords
-    void clearAllPasswords() 
+    // "main --serve [socket]" runs the vault daemon until SIGINT or SIGTERM
+    if (argc > 1 && strcmp(argv[1], "--serve") == 0)
     {
-        PasswordNode* temp = head;
-        while (temp) 
+        return runDaemon(argc > 2 ? argv[2] : "vault.sock");
+    }
+
+    // "main --batch [script]" runs a command script (stdin if omitted or "-")
+    if (argc > 1 && strcmp(argv[1], "--batch") == 0)
+    {
+        ios::sync_with_stdio(false);
+        PasswordManager pm;
+        if (argc > 2 && strcmp(argv[2], "-") != 0)
         {
-            PasswordNode* toDelete = temp;
-            temp = temp->next;
-            delete toDelete;
+            ifstream script(argv[2]);
+            if (!script)
+            {
+                cerr << "❌ Could not open " << argv[2] << "\n";
+                return 1;
+            }
+            return runBatch(script, cout, pm) == 0 ? 0 : 1;
         }
-        head = nullptr;
+        return runBatch(cin, cout, pm) == 0 ? 0 : 1;
     }
-};
 
-// ==================== MAIN FUNCTION ====================
 
-int main() 
-{
-    PasswordManager pm;
-    int choice;
-    bool loggedIn = false;
+    SessionTable sessions;
+    Session* session = nullptr;
+    int choice = 0;
 
-    // Initialize stacks
-    undoStack.init();
-    redoStack.init();
 
     do {
-        if (!loggedIn) 
+        if (!session) 
         {
-            if (!authenticateUser()) 
+            string email, password;
+            if (!authenticateUser(email, password)) 
             {
                 cout << "Program terminated due to failed authentication.\n";
                 return 0;
             }
-            loggedIn = true;
+
+            // Map this user's last snapshot and replay the journal on top
+            int opened = 0;
+            session = sessions.open(email, password, true, opened);
+            if (!session && opened == -1)
+            {
+                cout << "⚠️ Could not open the saved vault. Changes in this session will not be saved.\n";
+                session = sessions.open(email, password, false, opened);
+            }
+            wipeString(password);  // The session keeps only a verifier
+            if (!session)
+            {
+                AttemptStatus attempts = sessions.shardFor(email).failedOpens.check(email);
+                if (opened != VAULT_LOCKED_OUT) cout << "❌ Wrong password for this vault.\n";
+                if (attempts.locked)
+                {
+                    cout << "🔒 Too many failed sign-ins for " << email << ". Try again in " << attempts.retrySeconds() << " second(s).\n";
+                }
+                continue;
+            }
+            if (!session->pm.vault.isEmpty())
+            {
+                cout << "📂 Restored " << session->pm.vault.size() << " saved password(s).\n";
+            }
         }
+        PasswordManager& pm = session->pm;
         
         cout << "\n====== PASSWORD MANAGER ======" << endl;
-        cout << "Logged in as: " << currentUser->email << endl;
+        cout << "Logged in as: " << session->user.email << endl;
         cout << "1. Add Password" << endl;
         cout << "2. View All Passwords" << endl;
         cout << "3. Edit Password" << endl;
@@ -1063,6 +8315,9 @@ int main()
         cout << "6. Redo Last Undo" << endl;
         cout << "7. Logout" << endl;
         cout << "8. Exit" << endl;
+        cout << "9. Bulk Import from File" << endl;
+        cout << "10. Search Accounts by Prefix" << endl;
+        cout << "11. Audit Password Strength" << endl;
         
         
         while (true)
@@ -1071,19 +8326,19 @@ int main()
             if (cin >> choice)
             {
                 
-                if (choice >= 1 && choice <= 8)
+                if (choice >= 1 && choice <= 11)
                 {
                     break;
                 }
                 else
                 {
-                    cout << "❌ Invalid choice! Please enter a number between 1 and 8.\n";
+                    cout << "❌ Invalid choice! Please enter a number between 1 and 11.\n";
                 }
             }
             else
             {
                 // Invalid input (non-numeric)
-                cout << "❌ Invalid input! Please enter a number between 1 and 8.\n";
+                cout << "❌ Invalid input! Please enter a number between 1 and 11.\n";
                 cin.clear(); // Clear error flags
                 cin.ignore(10000, '\n');
             }
@@ -1112,25 +8367,50 @@ int main()
             case 7:
                 if (logout()) 
                 {
-                    pm.clearAllPasswords(); 
-                    delete currentUser;
-                    currentUser = nullptr;
-                    loggedIn = false;
-                    undoStack.clear();
-                    redoStack.clear();
+                    if (!sessions.close(session->user.email))
+                    {
+                        cout << "⚠️ Could not write the vault journal. Recent changes were not saved.\n";
+                    }
+                    session = nullptr;
                 }
                 break;
             case 8:
                 cout << "Exiting...\n";
-                pm.clearAllPasswords();
-                delete currentUser;
+                if (!sessions.close(session->user.email))
+                {
+                    cout << "⚠️ Could not write the vault journal. Recent changes were not saved.\n";
+                }
+                session = nullptr;
+                break;
+            case 9:
+                pm.bulkImport();
+                break;
+            case 10:
+                pm.searchByPrefix();
+                break;
+            case 11:
+                pm.auditPasswords();
                 break;
             default:
                 cout << "❌ Invalid choice!\n";
                 break;
         }
 
+        // Group commit: everything the menu action changed shares one fsync
+        // (closing a session on logout or exit has already committed it)
+        if (session && !pm.syncJournal())
+        {
+            cout << "⚠️ Could not write the vault journal. Recent changes may not be saved.\n";
+        }
+        if (session && !pm.maybeCheckpoint())
+        {
+            cout << "⚠️ Could not write the vault checkpoint. Your changes are kept in the journal and folded in later.\n";
+        }
+        if (session) pm.plaintexts.expire();
+
     } while (choice != 8);
 
     return 0;
-}
\ No newline at end of file
+}
+
+#endif
@@ -0,0 +1,170 @@
+// Wire protocol of the vault daemon ("main --serve <socket>") and its clients
+// (loadgen.cpp). Shared by both sides so they cannot drift apart.
+//
+// Every message is one frame, little-endian:
+//   u32 size | u8 code | u32 tag | fields...
+// size counts the bytes after itself; a field is a u16 length and its bytes.
+// A request's code is a ProtoOp, a response's a ProtoStatus. The server answers
+// every request with exactly one response carrying the same tag, in the order the
+// requests arrived on that connection, so a client may send many requests before
+// reading (pipelining).
+//
+// Requests and the fields they carry:
+//   Open   email, password[, flags]   Sign in (flags byte 1 = memory-only vault, kept
+//                                      apart from the email's saved vault and dropped
+//                                      once no connection has used it for 5 minutes)
+//   Search account                    -> password
+//   Add    account, password          (each at most PROTO_MAX_FIELD bytes)
+//   Edit   account, new password
+//   Delete account
+//   Range  from, to, u32 limit         -> name, password pairs with from <= name < to
+//                                        (empty to = no upper bound), at most limit
+//   Close                              Drop this connection's sign-in
+// Everything but Open needs an Open on the same connection first.
+
+#ifndef VAULT_PROTOCOL_H
+#define VAULT_PROTOCOL_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+const uint32_t PROTO_MAX_FRAME = 1 << 20;  // Largest size a frame may declare
+const size_t PROTO_HEADER_BYTES = 9;       // size + code + tag
+const size_t PROTO_MAX_FIELD = 0xFFFF;     // Longest field value
+const uint32_t PROTO_MAX_RANGE = 1000;     // Most entries one Range returns
+const uint8_t PROTO_OPEN_MEMORY_ONLY = 1;  // Open flag: do not load or save files
+
+enum class ProtoOp : uint8_t
+{
+    Open = 1,
+    Search = 2,
+    Add = 3,
+    Edit = 4,
+    Delete = 5,
+    Range = 6,
+    Close = 7
+};
+
+enum class ProtoStatus : uint8_t
+{
+    Ok = 0,
+    NotFound = 1,      // No such account
+    Exists = 2,        // Add of an account already stored
+    BadRequest = 3,    // Unknown code or malformed fields
+    NotOpen = 4,       // Request before Open
+    Denied = 5,        // Open with a different password than the live session
+    Failed = 6,        // The saved vault could not be read, a change could not be written,
+                       // or a stored value is too long for a field
+    Locked = 7         // Open refused: too many failed Opens for this email, retry later
+};
+
+inline void protoPutU16(std::string& out, uint16_t v)
+{
+    char bytes[2] = { static_cast<char>(v), static_cast<char>(v >> 8) };
+    out.append(bytes, 2);
+}
+
+inline void protoPutU32(std::string& out, uint32_t v)
+{
+    char bytes[4] = { static_cast<char>(v), static_cast<char>(v >> 8), static_cast<char>(v >> 16), static_cast<char>(v >> 24) };
+    out.append(bytes, 4);
+}
+
+inline uint16_t protoGetU16(const char* p)
+{
+    const unsigned char* b = reinterpret_cast<const unsigned char*>(p);
+    return static_cast<uint16_t>(b[0] | b[1] << 8);
+}
+
+inline uint32_t protoGetU32(const char* p)
+{
+    const unsigned char* b = reinterpret_cast<const unsigned char*>(p);
+    return static_cast<uint32_t>(b[0]) | static_cast<uint32_t>(b[1]) << 8 | static_cast<uint32_t>(b[2]) << 16 | static_cast<uint32_t>(b[3]) << 24;
+}
+
+// Start a frame at the end of out; returns where it starts (for protoEnd)
+inline size_t protoBegin(std::string& out, uint8_t code, uint32_t tag)
+{
+    size_t start = out.size();
+    protoPutU32(out, 0);
+    out.push_back(static_cast<char>(code));
+    protoPutU32(out, tag);
+    return start;
+}
+
+// Append a field. Values must be at most PROTO_MAX_FIELD bytes: the vault refuses
+// longer entries, and the server answers Failed rather than send one cut short.
+inline void protoField(std::string& out, std::string_view value)
+{
+    size_t n = value.size() < PROTO_MAX_FIELD ? value.size() : PROTO_MAX_FIELD;
+    protoPutU16(out, static_cast<uint16_t>(n));
+    out.append(value.data(), n);
+}
+
+inline void protoFieldU32(std::string& out, uint32_t v)
+{
+    protoPutU16(out, 4);
+    protoPutU32(out, v);
+}
+
+// Fill in the size of the frame begun at start
+inline void protoEnd(std::string& out, size_t start)
+{
+    uint32_t size = static_cast<uint32_t>(out.size() - start - 4);
+    for (int i = 0; i < 4; i++) out[start + i] = static_cast<char>(size >> (8 * i));
+}
+
+// Size of the complete frame at the front of data: 0 if more bytes are needed,
+// SIZE_MAX if the frame is malformed (the connection should be dropped)
+inline size_t protoFrameSize(const char* data, size_t available)
+{
+    if (available < 4) return 0;
+    uint32_t size = protoGetU32(data);
+    if (size < PROTO_HEADER_BYTES - 4 || size > PROTO_MAX_FRAME) return SIZE_MAX;
+    return available >= size + 4u ? size + 4u : 0;
+}
+
+// One parsed frame: its code and tag, then its fields read in order
+struct ProtoFrame
+{
+    uint8_t code;
+    uint32_t tag;
+    const char* next;
+    const char* end;
+
+    ProtoFrame(const char* frame, size_t frameSize)
+    {
+        code = static_cast<uint8_t>(frame[4]);
+        tag = protoGetU32(frame + 5);
+        next = frame + PROTO_HEADER_BYTES;
+        end = frame + frameSize;
+    }
+
+    // Next field; false if there is none or it runs past the frame
+    bool field(std::string_view& value)
+    {
+        if (end - next < 2) return false;
+        uint16_t n = protoGetU16(next);
+        if (end - next - 2 < n) return false;
+        value = std::string_view(next + 2, n);
+        next += 2 + n;
+        return true;
+    }
+
+    bool fieldU32(uint32_t& v)
+    {
+        std::string_view value;
+        if (!field(value) || value.size() != 4) return false;
+        v = protoGetU32(value.data());
+        return true;
+    }
+
+    bool atEnd() const
+    {
+        return next == end;
+    }
+};
+
+#endif